@@ -0,0 +1,66 @@
+#!/bin/sh
+#  bench.sh - time flydoc over synthetic trees from flydocgen
+#  Copyright 2024 Drew Gislason
+#  License MIT <https://mit-license.org>
+#
+#  Run from src/ with "make bench". Each tree is generated once (same seed, same tree), then each
+#  case is run once to warm the file cache and RUNS more times. Times come from flydoc's own
+#  --profile-json (sum of all phases), so process startup and the shell don't add noise. The
+#  min and median of the runs are printed, one line per tree and case.
+#
+#  Environment (all optional):
+#
+#  FLYDOC   flydoc to time. Default: ./flydoc
+#  GEN      flydocgen. Default: out/flydocgen
+#  OUT      scratch folder for trees and output. Default: out/bench
+#  RUNS     timed runs per case. Default: 5
+#  JOBS     -j=# for flydoc. Default: 1
+#  TREES    trees as "name:modules:funcs:docs:images:density ...".
+#           Default: "small:100:20:20:10:75 large:2000:20:400:100:75"
+
+FLYDOC=${FLYDOC:-./flydoc}
+GEN=${GEN:-out/flydocgen}
+OUT=${OUT:-out/bench}
+RUNS=${RUNS:-5}
+JOBS=${JOBS:-1}
+TREES=${TREES:-"small:100:20:20:10:75 large:2000:20:400:100:75"}
+
+# run flydoc once, print total ms from its --profile-json
+run_once() {
+  rm -rf "$OUT/html" "$OUT/md"
+  "$FLYDOC" -v=0 -j="$JOBS" --profile-json "$OUT/profile.json" "$@" > /dev/null 2>&1
+  grep -o '"wall_ms": [0-9.]*' "$OUT/profile.json" | awk '{ ms += $2 } END { printf "%.3f\n", ms }'
+}
+
+# run a case RUNS times after a warm up, print min and median
+run_case() {
+  name=$1
+  shift
+  run_once "$@" > /dev/null
+  i=0
+  : > "$OUT/times.txt"
+  while [ $i -lt "$RUNS" ]; do
+    run_once "$@" >> "$OUT/times.txt"
+    i=$((i + 1))
+  done
+  sort -n "$OUT/times.txt" | awk -v name="$name" '
+    { t[NR] = $1 }
+    END { printf "%-24s %12.3f %12.3f\n", name, t[1], (NR % 2) ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2 }'
+}
+
+mkdir -p "$OUT" || exit 1
+echo "flydoc bench: $FLYDOC, -j=$JOBS, $RUNS runs"
+printf "%-24s %12s %12s\n" "case" "min ms" "median ms"
+
+for tree in $TREES; do
+  IFS=: read -r name mods funcs docs images density <<END
+$tree
+END
+  src="$OUT/tree_$name"
+  if [ ! -d "$src" ]; then
+    "$GEN" -m="$mods" -f="$funcs" -d="$docs" -i="$images" -c="$density" "$src" > /dev/null || exit 1
+  fi
+  run_case "$name parse (-n)"   -n "$src"
+  run_case "$name html"         -o "$OUT/html" "$src"
+  run_case "$name markdown"     --markdown -o "$OUT/md" "$src"
+done
@@ -0,0 +1,312 @@
+/**************************************************************************************************
+  flydocgen.c - Generate a synthetic source tree for benchmarking flydoc
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+
+  The same options (and seed) always generate exactly the same tree, so benchmark runs on
+  different days or different commits are timing the same input. See bench.sh.
+
+  Usage = flydocgen [-m=#] [-f=#] [-d=#] [-i=#] [-c=#] [-s=#] out/
+
+  -m=#    modules, one source file each, languages rotate through SZ_FLY_DOC_EXTS. Default: 100
+  -f=#    functions per module. Default: 20
+  -d=#    markdown documents. Default: 20
+  -i=#    images, referenced by the markdown documents. Default: 10
+  -c=#    comment density: percent of functions with a doc comment. Default: 75
+  -s=#    random seed. Default: 1
+**************************************************************************************************/
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define GEN_FILES_PER_FOLDER  100   // keeps folders a realistic size
+
+// each language uses the doc comment form from the flydoc user guide
+typedef enum
+{
+  GEN_LANG_C,       // C, C++, C#, Java, Javascript, Typescript, Rust, Swift, Go: /*! */
+  GEN_LANG_PY       // Python: """! """ after the def
+} genLang_t;
+
+typedef struct
+{
+  const char *szExt;
+  genLang_t   lang;
+  const char *szProto;    // printf format for prototype: module #, function #
+} genExt_t;
+
+static const genExt_t m_aExts[] =
+{
+  { ".c",     GEN_LANG_C,   "int mod%u_func%u(int a, int b)\n{\n  return a + b;\n}\n" },
+  { ".c++",   GEN_LANG_C,   "int Mod%u::Func%u(int a, int b)\n{\n  return a + b;\n}\n" },
+  { ".cc",    GEN_LANG_C,   "int Mod%u::Func%u(int a, int b)\n{\n  return a + b;\n}\n" },
+  { ".cpp",   GEN_LANG_C,   "int Mod%u::Func%u(int a, int b)\n{\n  return a + b;\n}\n" },
+  { ".cxx",   GEN_LANG_C,   "int Mod%u::Func%u(int a, int b)\n{\n  return a + b;\n}\n" },
+  { ".cs",    GEN_LANG_C,   "  public static int Mod%uFunc%u(int a, int b)\n  {\n    return a + b;\n  }\n" },
+  { ".go",    GEN_LANG_C,   "func Mod%uFunc%u(a int, b int) int {\n  return a + b\n}\n" },
+  { ".java",  GEN_LANG_C,   "  public static int mod%uFunc%u(int a, int b) {\n    return a + b;\n  }\n" },
+  { ".js",    GEN_LANG_C,   "function mod%uFunc%u(a, b) {\n  return a + b;\n}\n" },
+  { ".py",    GEN_LANG_PY,  "def mod%u_func%u(a, b):\n" },
+  { ".rs",    GEN_LANG_C,   "fn mod%u_func%u(a: i32, b: i32) -> i32 {\n    a + b\n}\n" },
+  { ".swift", GEN_LANG_C,   "func Mod%uFunc%u(a: Int, b: Int) -> Int {\n    return a + b\n}\n" },
+  { ".ts",    GEN_LANG_C,   "function mod%uFunc%u(a: number, b: number): number {\n  return a + b;\n}\n" },
+};
+
+static const char *m_aszWords[] =
+{
+  "the", "parser", "returns", "a", "list", "of", "items", "for", "each", "input", "file", "and",
+  "output", "page", "with", "markdown", "text", "that", "is", "converted", "to", "HTML", "in",
+  "order", "module", "function", "value", "index", "thread", "cache", "buffer", "length"
+};
+
+// smallest valid PNG, 1x1 pixel
+static const uint8_t m_abPng[] =
+{
+  0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1f, 0x15, 0xc4,
+  0x89, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0x60, 0x00, 0x02, 0x00,
+  0x00, 0x05, 0x00, 0x01, 0x7a, 0x5e, 0xab, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44,
+  0xae, 0x42, 0x60, 0x82
+};
+
+static uint64_t m_seed;
+
+/*-------------------------------------------------------------------------------------------------
+  Next pseudo random number (xorshift64). Same seed, same sequence, on every platform.
+
+  @param    n     range
+  @return   random number 0 to n-1
+-------------------------------------------------------------------------------------------------*/
+static unsigned GenRand(unsigned n)
+{
+  m_seed ^= m_seed << 13;
+  m_seed ^= m_seed >> 7;
+  m_seed ^= m_seed << 17;
+  return n ? (unsigned)(m_seed % n) : 0;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write a line of random words.
+
+  @param    fp        file to write to
+  @param    szPrefix  prefix for line, e.g. "  "
+  @param    nWords    number of words
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void GenWords(FILE *fp, const char *szPrefix, unsigned nWords)
+{
+  unsigned  i;
+
+  fputs(szPrefix, fp);
+  for(i = 0; i < nWords; ++i)
+    fprintf(fp, "%s%s", i ? " " : "", m_aszWords[GenRand(sizeof(m_aszWords) / sizeof(m_aszWords[0]))]);
+  fputs("\n", fp);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Create a folder if it doesn't exist.
+
+  @param    szPath    folder
+  @return   none, exits on failure
+-------------------------------------------------------------------------------------------------*/
+static void GenFolder(const char *szPath)
+{
+  if(mkdir(szPath, 0777) != 0 && errno != EEXIST)
+  {
+    fprintf(stderr, "flydocgen: can't create folder %s\n", szPath);
+    exit(1);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Open a file in a numbered sub folder, e.g. out/src/002/mod217.py. Creates the sub folder.
+
+  @param    szOut     output folder
+  @param    szSub     sub folder, e.g. "src"
+  @param    i         file number, picks the numbered folder
+  @param    szName    file name
+  @return   open file, exits on failure
+-------------------------------------------------------------------------------------------------*/
+static FILE * GenOpen(const char *szOut, const char *szSub, unsigned i, const char *szName)
+{
+  char    szPath[1024];
+  FILE   *fp;
+
+  snprintf(szPath, sizeof(szPath), "%s/%s", szOut, szSub);
+  GenFolder(szPath);
+  snprintf(szPath, sizeof(szPath), "%s/%s/%03u", szOut, szSub, i / GEN_FILES_PER_FOLDER);
+  GenFolder(szPath);
+  snprintf(szPath, sizeof(szPath), "%s/%s/%03u/%s", szOut, szSub, i / GEN_FILES_PER_FOLDER, szName);
+  fp = fopen(szPath, "wb");
+  if(!fp)
+  {
+    fprintf(stderr, "flydocgen: can't create file %s\n", szPath);
+    exit(1);
+  }
+
+  return fp;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write one module: a source file with a @defgroup and nFuncs functions, some with doc comments.
+
+  @param    szOut     output folder
+  @param    iMod      module number, also picks language
+  @param    nFuncs    functions in module
+  @param    density   percent of functions with doc comments
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void GenModule(const char *szOut, unsigned iMod, unsigned nFuncs, unsigned density)
+{
+  const genExt_t *pExt = &m_aExts[iMod % (sizeof(m_aExts) / sizeof(m_aExts[0]))];
+  char            szName[64];
+  FILE           *fp;
+  unsigned        i;
+  unsigned        n;
+
+  snprintf(szName, sizeof(szName), "mod%u%s", iMod, pExt->szExt);
+  fp = GenOpen(szOut, "src", iMod, szName);
+
+  if(pExt->lang == GEN_LANG_PY)
+    fprintf(fp, "\"\"\"!\n  @defgroup mod%u Module %u\n\n", iMod, iMod);
+  else
+    fprintf(fp, "/*!\n  @defgroup mod%u Module %u\n\n", iMod, iMod);
+  for(n = 1 + GenRand(6); n; --n)
+    GenWords(fp, "  ", 8 + GenRand(8));
+  fputs(pExt->lang == GEN_LANG_PY ? "\"\"\"\n\n" : "*/\n\n", fp);
+
+  for(i = 0; i < nFuncs; ++i)
+  {
+    // not all functions are documented, and not all comments are doc comments
+    if(GenRand(100) >= density)
+    {
+      fputs(pExt->lang == GEN_LANG_PY ? "# " : "// ", fp);
+      GenWords(fp, "", 6);
+      fprintf(fp, pExt->szProto, iMod, i);
+      if(pExt->lang == GEN_LANG_PY)
+        fputs("    return a + b\n", fp);
+      fputs("\n", fp);
+      continue;
+    }
+
+    if(pExt->lang == GEN_LANG_PY)
+      fprintf(fp, pExt->szProto, iMod, i);
+    fputs(pExt->lang == GEN_LANG_PY ? "    \"\"\"!\n" : "/*!\n", fp);
+    GenWords(fp, "  ", 6 + GenRand(6));
+    fputs("\n", fp);
+    for(n = GenRand(5); n; --n)
+      GenWords(fp, "  ", 8 + GenRand(10));
+    if(GenRand(4) == 0)
+      fprintf(fp, "\n  @example mod%u_func%u\n\n  ```\n  x = mod%u_func%u(1, 2)\n  ```\n", iMod, i, iMod, i);
+    fputs("\n  @param   a   first value\n  @param   b   second value\n  @return  sum of a and b\n", fp);
+    if(pExt->lang == GEN_LANG_PY)
+      fputs("    \"\"\"\n    return a + b\n\n", fp);
+    else
+    {
+      fputs("*/\n", fp);
+      fprintf(fp, pExt->szProto, iMod, i);
+      fputs("\n", fp);
+    }
+  }
+
+  fclose(fp);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write one markdown document with headings, text, a code block and image links.
+
+  @param    szOut     output folder
+  @param    iDoc      document number
+  @param    nImages   images there are to reference
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void GenMarkdown(const char *szOut, unsigned iDoc, unsigned nImages)
+{
+  char      szName[64];
+  FILE     *fp;
+  unsigned  iSect;
+  unsigned  nSects;
+  unsigned  n;
+
+  snprintf(szName, sizeof(szName), "doc%u.md", iDoc);
+  fp = GenOpen(szOut, "docs", iDoc, szName);
+
+  fprintf(fp, "# Document %u\n\n", iDoc);
+  nSects = 3 + GenRand(6);
+  for(iSect = 0; iSect < nSects; ++iSect)
+  {
+    fprintf(fp, "## Section %u.%u\n\n", iDoc, iSect);
+    for(n = 2 + GenRand(8); n; --n)
+      GenWords(fp, "", 10 + GenRand(10));
+    fputs("\n", fp);
+    if(GenRand(3) == 0)
+      fprintf(fp, "```\nint x = %u;\n```\n\n", iSect);
+    if(nImages && GenRand(2) == 0)
+      fprintf(fp, "![image](img%u.png)\n\n", GenRand(nImages));
+  }
+
+  fclose(fp);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Generate the tree. See usage at top of file.
+-------------------------------------------------------------------------------------------------*/
+int main(int argc, const char *argv[])
+{
+  const char *szOut     = NULL;
+  unsigned    nMods     = 100;
+  unsigned    nFuncs    = 20;
+  unsigned    nDocs     = 20;
+  unsigned    nImages   = 10;
+  unsigned    density   = 75;
+  unsigned    seed      = 1;
+  unsigned    i;
+  FILE       *fp;
+  char        szName[64];
+
+  for(i = 1; i < (unsigned)argc; ++i)
+  {
+    if(argv[i][0] == '-' && argv[i][1] && argv[i][2] == '=')
+    {
+      switch(argv[i][1])
+      {
+        case 'm': nMods   = (unsigned)atoi(&argv[i][3]); break;
+        case 'f': nFuncs  = (unsigned)atoi(&argv[i][3]); break;
+        case 'd': nDocs   = (unsigned)atoi(&argv[i][3]); break;
+        case 'i': nImages = (unsigned)atoi(&argv[i][3]); break;
+        case 'c': density = (unsigned)atoi(&argv[i][3]); break;
+        case 's': seed    = (unsigned)atoi(&argv[i][3]); break;
+        default:  szOut = NULL; i = (unsigned)argc; break;
+      }
+    }
+    else
+      szOut = argv[i];
+  }
+  if(szOut == NULL)
+  {
+    printf("Usage = flydocgen [-m=#] [-f=#] [-d=#] [-i=#] [-c=#] [-s=#] out/\n");
+    return 1;
+  }
+
+  m_seed = 0x9e3779b97f4a7c15ULL ^ seed;
+  GenFolder(szOut);
+  for(i = 0; i < nMods; ++i)
+    GenModule(szOut, i, nFuncs, density);
+  for(i = 0; i < nDocs; ++i)
+    GenMarkdown(szOut, i, nImages);
+  for(i = 0; i < nImages; ++i)
+  {
+    snprintf(szName, sizeof(szName), "img%u.png", i);
+    fp = GenOpen(szOut, "images", i, szName);
+    fwrite(m_abPng, 1, sizeof(m_abPng), fp);
+    fclose(fp);
+  }
+
+  printf("%s: %u modules, %u functions, %u documents, %u images\n", szOut, nMods, nMods * nFuncs,
+         nDocs, nImages);
+
+  return 0;
+}
@@ -23,6 +23,7 @@
 #define FLYDOC_DEF_HBAR_COLOR   "w3-text-blue"
 #define FLYDOC_DEF_HTITLE_COLOR "w3-text-black"
 #define FLYDOC_MAX_DEPTH        3
+#define FLYDOC_HASH_INIT        14695981039346656037ULL   // see FlyDocHash()
 
 typedef enum 
 {
@@ -66,28 +67,54 @@ typedef enum
   FLYDOC_SORT_ALL,
 } flyDocSort_t;
 
+typedef enum
+{
+  FLYDOC_COPY_COPY = 0,     // copy images, reflink if possible (default)
+  FLYDOC_COPY_LINK,         // hard link images, copy if on another file system
+  FLYDOC_COPY_SYMLINK,      // symbolic link to images
+} flyDocCopy_t;
+
 typedef struct
 {
   const char *szExts;
   const char *szLink;
   const char *szOut;
   const char *szSlug;
+  const char *szCache;    // --cache folder/ for parse results, or NULL
+  const char *szExclude;  // --exclude patterns, comma separated, or NULL
+  const char *szProfileJson; // --profile-json file, or NULL
+  const char *szEmitDb;   // --emit-db file, write parsed document, or NULL
+  const char *szLoadDb;   // --load-db file, read parsed document rather than parse inputs, or NULL
+  const char *szCopy;     // --copy=how, copy, link or symlink images, see FlyDocCopyHow(), or NULL
   int         debug;
   int         verbose;
+  int         nJobs;      // -j=#, number of threads for parsing and writing
+  int         split;      // --split=#, most functions per page and entries per main page list, 0 = no limit
+  int         maxMem;     // --max-mem=#, megabytes of text to keep in memory, the rest spills to disk, 0 = no limit
   bool_t      fNoBuild;
   bool_t      fSort;
   bool_t      fLocal;
   bool_t      fMarkdown;
   bool_t      fCombine;   // applies to --markdown only
   bool_t      fNoIndex;
+  bool_t      fNoSearch;  // --nosearch, no search box or search index in HTML pages
+  bool_t      fNoLink;    // --nolink, don't auto-link mentions of functions, modules and classes
   bool_t      fUserGuide;
+  bool_t      fChanged;   // --changed, only write output files whose contents changed
+  bool_t      fGzip;      // --gzip, also write a precompressed .gz next to each output file
+  bool_t      fProfile;   // --profile, time each phase, file and page
+  bool_t      fWatch;     // --watch, rebuild when inputs change
 } flyDocOpts_t;
 
+// library: receives each output file rather than it being written, see FlyDocLibWrite()
+typedef bool_t (*pfnFlyDocOut_t)(void *pData, const char *szPath, const void *pFile, size_t len);
+
 // a function
 typedef struct flyDocFunc
 {
   struct flyDocFunc *pNext;
   char              *szFunc;        // function CName
+  const char        *szRef;         // local reference to szFunc, e.g. "#myfunc", see FlyDocRefNew()
   char              *szBrief;
   char              *szPrototype;   // includes @param and @return lines
   char              *szText;        // may be NULL if no text beyond brief description
@@ -149,6 +176,8 @@ typedef struct flyDocMdHdr
 {
   struct flyDocMdHdr      *pNext;
   const char              *szTitle; // NOT a string, just a pointer to the header line in markdwon file
+  const char              *szRef;   // local reference to szTitle, e.g. "#my-heading", see FlyDocRefNew()
+  const char              *szNbTitle; // szTitle with non-breaking spaces for the left bar, see FlyDocNbNew()
 } flyDocMdHdr_t;
 
 // each markdown file gets it's own page
@@ -157,7 +186,7 @@ typedef struct flyDocMarkdown
   struct flyDocMarkdown  *pNext;
   flyDocSection_t         section;       // includes logo, colors, etc...
   char                   *szPath;        // path to markdown file
-  const char             *szFile;
+  const char             *szFile;        // contents, or NULL if read again on output (--markdown)
   flyDocMdHdr_t          *pHdrList;      // ptrs to headers in markdown file
 } flyDocMarkdown_t;
 
@@ -175,30 +204,132 @@ typedef struct
   flyDocSection_t         section;        // includes logo, colors, etc...
 } flyDocMainPage_t;
 
+// an input file queued for (possibly parallel) parsing, see FlyDocParseInputs()
+typedef struct
+{
+  char             *szPath;
+  bool_t            fInvalid;       // not a file, folder or wildcard: just a warning
+} flyDocInput_t;
+
+// contents of an input file, see FlyDocInFileRead()
+typedef struct
+{
+  char             *szFile;         // '\0' terminated contents, or NULL if couldn't read
+  size_t            len;            // length of contents, not including the '\0'
+  size_t            mapLen;         // length of memory map, or 0 if contents are on the heap
+} flyDocInFile_t;
+
+// arena for everything parsed into a flyDoc_t, see flydocarena.c
+typedef struct
+{
+  struct flyDocArenaBlk  *pBlkList;       // 1st block is the one being allocated from
+  struct flyDocArenaOwn  *pOwnList;       // heap memory freed with the arena
+  size_t                  size;           // total size of all blocks
+  size_t                  nAllocs;        // # of allocations, for --profile
+} flyDocArena_t;
+
+// an output page being built in memory, see flydocpage.c
+typedef struct
+{
+  char                   *szBuf;          // page so far, not '\0' terminated
+  size_t                  len;            // length of page so far
+  size_t                  size;           // size of szBuf
+  uint64_t                nsStart;        // --profile: when the current page was started
+  uint64_t                nsLast;         // --profile: time to build and write the last page
+  size_t                  lenLast;        // --profile: length of the last page written
+} flyDocPage_t;
+
+// --profile phases, see FlyDocProfPhase()
+typedef enum
+{
+  FLYDOC_PHASE_WALK = 0,    // walk input folders, find images
+  FLYDOC_PHASE_PARSE,       // read and parse input files
+  FLYDOC_PHASE_SORT,
+  FLYDOC_PHASE_WRITE,       // write HTML pages or markdown file
+  FLYDOC_PHASE_IMAGES,      // copy referenced images
+  FLYDOC_PHASE_MAX          // none
+} flyDocPhase_t;
+
+// --profile: time to read and parse one input file, see FlyDocParseFileEx()
+typedef struct
+{
+  uint64_t                nsRead;
+  uint64_t                nsParse;
+  size_t                  len;            // bytes read
+  bool_t                  fMarkdown;      // markdown file rather than source
+} flyDocFileProf_t;
+
+// hash index into the lists of a flyDoc_t, see flydochash.c
+typedef struct
+{
+  struct flyDocHashEntry *aEntries;       // open addressed, size is a power of 2
+  unsigned                size;           // # of slots
+  unsigned                count;          // # of keys
+} flyDocHash_t;
+
+// --watch: an input or image file as of the last build, see FlyDocWatchFile()
+typedef struct
+{
+  const char             *szPath;
+  uint64_t                mtime;          // modified time in ns, from last FlyDocWatchFileSame()
+  uint64_t                size;
+  bool_t                  fStat;          // mtime and size are known
+  uint64_t                hContents;      // hash of contents when pCache was made
+  void                   *pCache;         // source file's partial doc in --cache form, or NULL
+  size_t                  lenCache;
+} flyDocWatchFile_t;
+
 // main state for a flydoc session
 typedef struct
 {
   unsigned          sanchk;
   unsigned          level;
   flyDocOpts_t      opts;                 // cmdline options
-  char              szInPath[PATH_MAX];   // for recursing through input files/folders
 
   // current file being parsed or written
   char              szPath[PATH_MAX];     // current filename being processed
   const char       *szFile;               // current file contents being processed
+  size_t            lenFile;              // length of szFile
+  size_t           *aLineStarts;          // offsets of lines in szFile, see FlyDocLinePos()
+  unsigned          nLineStarts;          // 0 until built by 1st warning in szFile
+  bool_t            fFileDone;            // nothing refers to szFile after parsing, see FlyDocParseMarkdownFile()
   flyDocModule_t   *pCurMod;              // current module or class (for functions)
   flyStrHdr_t      *pCurHdr;              // current doc header or NULL
   const char       *szCurHdr;             // pointer to allocated text of doc header or NULL
-  FILE             *fpOut;                // current file being written
+  FILE             *fpOut;                // current markdown file being written
+  flyDocPage_t      page;                 // current HTML page being written, see FlyDocHtmlPageNew()
+  FILE             *fpWarn;               // where warnings go, NULL for stderr
 
-  // parsed input ready for output
+  // parsed input ready for output, allocated from the arena
+  flyDocArena_t     arena;
   flyDocMainPage_t *pMainPage;            // main page for entire project
   flyDocModule_t   *pModList;             // modules in project, or NULL if none
   flyDocModule_t   *pClassList;           // classes in project, or NULL if none
   flyDocMarkdown_t *pMarkdownList;        // markdown files (documents) in project , NULL if none
   flyDocImage_t    *pImageList;           // image references found in all text
   flyDocFile_t     *pImgFileList;         // list of input image files, some of which may be referenced
+  flyDocHash_t      modIndex;             // pModList by title
+  flyDocHash_t      classIndex;           // pClassList by title
+  flyDocHash_t      pageIndex;            // page names of all modules, classes and markdown files
+  flyDocHash_t      imgIndex;             // pImgFileList by file name without path
+  flyDocHash_t      linkIndex;            // symbols to auto-link in HTML text, see FlyDocLinkIndex()
+  uint64_t          hLinks;               // hash of linkIndex, so --watch sees changed links
+  unsigned          nPages;               // # of modules, classes and markdown files, incl duplicates
   bool_t            fNeedImgHome;         // need the flydoc_home.png image
+  bool_t            fPartial;             // a per-file partial doc, see FlyDocParseInputs()
+  flyDocFileProf_t  fileProf;             // --profile: last file parsed
+  struct flyDocProf *pProf;               // --profile counters, NULL if not profiling (main doc only)
+  uint64_t          hCache;               // --cache context, see FlyDocCacheContext()
+  struct flyDocWatch *pWatch;             // --watch state kept from build to build, or NULL
+  pfnFlyDocOut_t    pfnOut;               // library: output files go here, not to disk, or NULL
+  void             *pOutData;             // library: data for pfnOut()
+  bool_t            fInMemory;            // library: inputs are in memory, see FlyDocLibParse()
+  struct flyDocSpill *pSpill;             // --max-mem spill file, shared with partial docs, or NULL
+
+  // input files queued for parsing with -j
+  flyDocInput_t    *aInputs;
+  unsigned          nInputs;
+  unsigned          maxInputs;
   
   // statistics, see FlyDocStatsUpdate()
   unsigned          nModules;
@@ -218,23 +349,109 @@ typedef struct
 #endif
 
 // flydoc.c
+void      FlyDocInit                (flyDoc_t *pDoc, const flyDocOpts_t *pOpts);
 bool_t    FlyDocIsDoc               (const flyDoc_t *pDoc);
+unsigned  FlyDocNumObjects          (const flyDoc_t *pDoc);
 void      FlyDocStyleGet            (flyDoc_t *pDoc, flyDocSection_t *pSection, flyDocStyle_t *pStyle);
+uint64_t  FlyDocHash                (const void *pData, size_t len, uint64_t hash);
 void      FlyDocAllocCheck          (void *pMem);
 void     *FlyDocAlloc               (size_t n);
 bool_t    FlyDocCreateFolder        (flyDoc_t *pDoc, const char *szPath);
+bool_t    FlyDocFileSame            (const char *szPath, const void *pData, size_t len);
+bool_t    FlyDocFilesSame           (const char *szPath1, const char *szPath2);
+bool_t    FlyDocFileWrite           (const flyDoc_t *pDoc, const char *szPath, const void *pData, size_t len);
+bool_t    FlyDocFileWriteDone       (const flyDoc_t *pDoc, const char *szPath, const char *szTmp);
+bool_t    FlyDocInFileRead          (flyDocInFile_t *pIn, const char *szPath);
+void      FlyDocInFileFree          (flyDocInFile_t *pIn);
 
 // flydochome.c
 extern uint8_t imgHome[];
 extern long imgHome_size;
 
+// flydocjobs.c
+typedef void   (*pfnFlyDocJob_t)(void *pData, unsigned i);
+typedef bool_t (*pfnFlyDocJobDone_t)(void *pData, unsigned i);
+void      FlyDocJobsRun             (unsigned nThreads, unsigned nJobs, pfnFlyDocJob_t pfnJob, pfnFlyDocJobDone_t pfnDone, void *pData);
+
 // flydochtml.c
 bool_t    FlyDocWriteHtml           (flyDoc_t *pDoc);
 size_t    FlyDocStrToRef            (char *szRef, unsigned size, const char *szBase, const char *szTitle);
+size_t    FlyDocRefJoin             (char *szRef, size_t size, const char *szBase, const char *szLocal);
+const char *FlyDocRefNew            (flyDocArena_t *pArena, const char *szTitle);
+const char *FlyDocNbNew             (flyDocArena_t *pArena, const char *sz);
+void      FlyDocHtmlPageNew         (flyDoc_t *pDoc, const char *szPath);
+unsigned  FlyDocHtmlNumParts        (const flyDoc_t *pDoc, unsigned nFuncs);
+void      FlyDocHtmlPartName        (char *szName, size_t size, const char *szTitle, unsigned part);
+bool_t    FlyDocHtmlPageWrite       (flyDoc_t *pDoc);
+void      FlyDocHtmlWriteFunc       (flyDoc_t *pDoc, flyDocModule_t *pMod, const flyDocFunc_t *pFunc);
+
+// flydocpage.c
+char     *FlyDocPageSpace           (flyDocPage_t *pPage, size_t n);
+void      FlyDocPageAppend          (flyDocPage_t *pPage, const void *pData, size_t len);
+void      FlyDocPageStr             (flyDocPage_t *pPage, const char *sz);
+void      FlyDocPageTpl             (flyDocPage_t *pPage, const char *szTpl, ...);
+bool_t    FlyDocPageWrite           (const flyDoc_t *pDoc, flyDocPage_t *pPage, const char *szPath);
+void      FlyDocPageFree            (flyDocPage_t *pPage);
+
+// flydoclib.c
+void      FlyDocLibInit             (flyDoc_t *pDoc, const flyDocOpts_t *pOpts);
+bool_t    FlyDocLibParse            (flyDoc_t *pDoc, const char *szPath, const char *szText, size_t len);
+void      FlyDocLibDone             (flyDoc_t *pDoc);
+bool_t    FlyDocLibWrite            (flyDoc_t *pDoc, pfnFlyDocOut_t pfnOut, void *pData);
+bool_t    FlyDocLibWriteFunc        (flyDoc_t *pDoc, const char *szFunc, pfnFlyDocOut_t pfnOut, void *pData);
+void      FlyDocLibFree             (flyDoc_t *pDoc);
+
+// flydoclink.c
+void      FlyDocLinkIndex           (flyDoc_t *pDoc);
+void      FlyDocLinkText            (flyDoc_t *pDoc, size_t offset);
 
 // flydocmd.c
 bool_t    FlyDocWriteMarkdown       (flyDoc_t *pDoc);
 
+// flydocarena.c
+void     *FlyDocArenaAlloc          (flyDocArena_t *pArena, size_t n);
+char     *FlyDocArenaStrAllocN      (flyDocArena_t *pArena, const char *sz, size_t len);
+char     *FlyDocArenaStrClone       (flyDocArena_t *pArena, const char *sz);
+void      FlyDocArenaOwn            (flyDocArena_t *pArena, void *pMem);
+void      FlyDocArenaOwnInFile      (flyDocArena_t *pArena, flyDocInFile_t *pIn);
+void      FlyDocArenaMove           (flyDocArena_t *pDst, flyDocArena_t *pSrc);
+void      FlyDocArenaFree           (flyDocArena_t *pArena);
+
+// flydocspill.c
+bool_t    FlyDocSpillInit           (flyDoc_t *pDoc);
+char     *FlyDocTextAlloc           (flyDoc_t *pDoc, size_t size);
+size_t    FlyDocSpillSize           (const flyDoc_t *pDoc);
+void      FlyDocSpillFree           (flyDoc_t *pDoc);
+
+// flydoccopy.c
+int       FlyDocCopyHow             (const char *szHow);
+bool_t    FlyDocFileCopy            (const flyDoc_t *pDoc, const char *szDst, const char *szSrc);
+void      FlyDocCopyReferencedImages(flyDoc_t *pDoc);
+
+// flydoccache.c
+uint64_t  FlyDocCacheContext        (const flyDoc_t *pDoc);
+bool_t    FlyDocCacheLoad           (flyDoc_t *pPartial, const char *szPath, uint64_t hContents, unsigned id);
+bool_t    FlyDocCacheSave           (const flyDoc_t *pPartial, const char *szPath, uint64_t hContents,
+                                     const char *szWarn, size_t lenWarn, unsigned id);
+bool_t    FlyDocCacheLoadMem        (flyDoc_t *pPartial, const char *szPath, uint64_t hContents,
+                                     const void *pCache, size_t len);
+bool_t    FlyDocCacheSaveMem        (const flyDoc_t *pPartial, const char *szPath, uint64_t hContents,
+                                     const char *szWarn, size_t lenWarn, void **ppCache, size_t *pLen);
+bool_t    FlyDocDbSave              (const flyDoc_t *pDoc, const char *szPath);
+bool_t    FlyDocDbLoad              (flyDoc_t *pDoc, const char *szPath);
+
+// flydochash.c
+size_t            FlyDocPageNameLen         (const char *szTitle);
+flyDocModule_t   *FlyDocModFind             (const flyDoc_t *pDoc, const char *szTitle, bool_t fClass);
+void              FlyDocIndexMod            (flyDoc_t *pDoc, flyDocModule_t *pMod, bool_t fClass);
+void              FlyDocIndexPage           (flyDoc_t *pDoc, const char *szTitle);
+bool_t            FlyDocIndexHasPage        (const flyDoc_t *pDoc, const char *szTitle);
+void              FlyDocIndexImgFile        (flyDoc_t *pDoc, flyDocFile_t *pImgFile);
+flyDocFile_t     *FlyDocImgFileFind         (const flyDoc_t *pDoc, const char *szName);
+void              FlyDocIndexAdd            (flyDocArena_t *pArena, flyDocHash_t *pHash, const char *szKey, void *pValue);
+void             *FlyDocIndexFind           (const flyDocHash_t *pHash, const char *szKey);
+void             *FlyDocIndexFindN          (const flyDocHash_t *pHash, const char *szKey, size_t len);
+
 // flydoccss.c
 extern const char szW3CssPath[];
 extern const char szW3CssFile[];
@@ -242,19 +459,42 @@ extern const char szW3CssFile[];
 // flydocmanual.c
 extern const char szFlyDocManual[];
 
+// flydocprof.c
+uint64_t  FlyDocProfNow             (void);
+void      FlyDocProfInit            (flyDoc_t *pDoc);
+void      FlyDocProfPhase           (flyDoc_t *pDoc, flyDocPhase_t phase);
+void      FlyDocProfFile            (flyDoc_t *pDoc, const char *szPath, const flyDocFileProf_t *pFileProf);
+void      FlyDocProfPage            (flyDoc_t *pDoc, const char *szPath, uint64_t ns, size_t len);
+void      FlyDocProfPrint           (const flyDoc_t *pDoc);
+bool_t    FlyDocProfWriteJson       (const flyDoc_t *pDoc, const char *szPath);
+void      FlyDocProfFree            (flyDoc_t *pDoc);
+
 // flydocparse.c
 unsigned          FlyDocExampleCountAll     (flyDoc_t *pDoc);
-flyDocExample_t  *FlyDocExampleNew          (const char *szTitle);
-flyDocExample_t  *FlyDocExampleFree         (flyDocExample_t *pExample);
+flyDocExample_t  *FlyDocExampleNew          (flyDoc_t *pDoc, const char *szTitle);
+flyDocFunc_t     *FlyDocFuncInList          (flyDocFunc_t *pList, const char *szFunc);
 const char       *FlyDocIsKeyword           (const char *szLine, flyDocKeyword_t *pKeyword);
 bool_t            FlyDocIsKeywordProto      (flyDocKeyword_t keyword);
 void              FlyDocProcessFolderTree   (flyDoc_t *pDoc, const char *szPath);
-void              FlyDocPreProcess          (flyDoc_t *pDoc, const char *szPath);
+void              FlyDocInputAdd            (flyDoc_t *pDoc, const char *szPath, bool_t fInvalid);
+bool_t            FlyDocUsePartials         (const flyDoc_t *pDoc);
+void              FlyDocParseInputs         (flyDoc_t *pDoc);
+bool_t            FlyDocParseFile           (flyDoc_t *pDoc, const char *szPath);
+bool_t            FlyDocParseFileEx         (flyDoc_t *pDoc, const char *szPath, flyDocInFile_t *pIn);
+void              FlyDocSortLists           (flyDoc_t *pDoc);
 void              FlyDocStatsUpdate         (flyDoc_t *pDoc);
 unsigned          FlyDocMakeNameBase        (char *szNameBase, const char *szTitle, size_t size);
 void              FlyDocDupCheck            (flyDoc_t *pDoc, const char *szTitle, const char *szPos);
+bool_t            FlyDocIsDup               (const flyDoc_t *pDoc, const char *szTitle);
+void              FlyDocModAdd              (flyDoc_t *pDoc, flyDocModule_t *pMod, bool_t fClass);
+void              FlyDocMarkdownAdd         (flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdown);
+
+// flydocsearch.c
+bool_t    FlyDocSearchWrite         (flyDoc_t *pDoc);
 
 // flydocprint.c
+unsigned  FlyDocLinePos             (flyDoc_t *pDoc, const char *szPos, unsigned *pCol, const char **ppszLine);
+void      FlyDocLinesFree           (flyDoc_t *pDoc);
 void      FlyDocPrintBanner         (const char *szText);
 void      FlyDocPrintDoc            (const flyDoc_t *pDoc, flyDocDbg_t debug);
 void      FlyDocPrintMainPage       (const flyDocMainPage_t *pMainPage, flyDocDbg_t debug);
@@ -283,4 +523,14 @@ extern const char szWarningNoObjects[];
 extern const char szWarningNoImage[];
 extern const char szWarningReadFile[];
 
+// flydocwatch.c
+void                FlyDocWatchInit         (flyDoc_t *pDoc);
+flyDocWatchFile_t  *FlyDocWatchFile         (flyDoc_t *pDoc, const char *szPath);
+bool_t              FlyDocWatchFileSame     (flyDocWatchFile_t *pFile);
+void                FlyDocWatchFileCache    (flyDocWatchFile_t *pFile, uint64_t hContents, void *pCache, size_t len);
+bool_t              FlyDocWatchPageSame     (flyDoc_t *pDoc, const char *szName, uint64_t hInputs);
+void                FlyDocWatchPagesForget  (flyDoc_t *pDoc);
+void                FlyDocWatchFolder       (flyDoc_t *pDoc, const char *szPath);
+void                FlyDocWatchWait         (flyDoc_t *pDoc);
+
 #endif // FLY_DOC_H
@@ -3,7 +3,11 @@
   Copyright 2024 Drew Gislason  
   License MIT <https://mit-license.org>
 **************************************************************************************************/
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
 #include "flydoc.h"
 #include "FlyCli.h"
 #include "FlyFile.h"
@@ -13,6 +17,9 @@
 
 #define SANCHK_DOC    987
 
+#define FLYDOC_GZ_MIN     64          // --gzip: files smaller than this don't get a .gz
+#define FLYDOC_GZ_BLOCK   (16 * 1024) // --gzip: compress this much at a time
+
 /*!
   @mainpage flydoc    
   @logo ![flydoc](fireflylogo.png "w3-round")
@@ -55,6 +62,10 @@ bool_t FlyDocCreateFolder(flyDoc_t *pDoc, const char *szPath)
   sFlyFileInfo_t  info;
   bool_t          fWorked = FALSE;
 
+  // library output goes to a callback, there are no folders
+  if(pDoc->pfnOut)
+    return TRUE;
+
   // does the folder already exist?
   for(int i = 0; i < 2; ++i)
   {
@@ -79,6 +90,389 @@ bool_t FlyDocCreateFolder(flyDoc_t *pDoc, const char *szPath)
   return fWorked;
 }
 
+/*!------------------------------------------------------------------------------------------------
+  Is the file on disk exactly the same as the data? Used by `--changed`.
+
+  @param    szPath    path to file
+  @param    pData     ptr to data
+  @param    len       length of data
+  @return   TRUE if file exists and has the same contents
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocFileSame(const char *szPath, const void *pData, size_t len)
+{
+  sFlyFileInfo_t  info;
+  uint8_t         aBuf[4096];
+  const uint8_t  *p     = pData;
+  FILE           *fp;
+  size_t          lenRead;
+  bool_t          fSame = FALSE;
+
+  // quick check on size before comparing contents
+  memset(&info, 0, sizeof(info));
+  if(!FlyFileInfoGet(&info, szPath) || info.fIsDir || info.size != (long)len)
+    return FALSE;
+
+  fp = fopen(szPath, "rb");
+  if(fp)
+  {
+    fSame = TRUE;
+    while(fSame && len)
+    {
+      lenRead = fread(aBuf, 1, len < sizeof(aBuf) ? len : sizeof(aBuf), fp);
+      if(lenRead == 0 || memcmp(aBuf, p, lenRead) != 0)
+        fSame = FALSE;
+      p   += lenRead;
+      len -= lenRead;
+    }
+    fclose(fp);
+  }
+
+  return fSame;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Do two files have the same contents? Both are read a block at a time, so neither needs to fit
+  in memory.
+
+  @param    szPath1   path to 1st file
+  @param    szPath2   path to 2nd file
+  @return   TRUE if both exist and have the same contents
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocFilesSame(const char *szPath1, const char *szPath2)
+{
+  uint8_t   a1[4096];
+  uint8_t   a2[4096];
+  FILE     *fp1;
+  FILE     *fp2;
+  size_t    len1;
+  size_t    len2;
+  bool_t    fSame = FALSE;
+
+  fp1 = fopen(szPath1, "rb");
+  fp2 = fopen(szPath2, "rb");
+  if(fp1 && fp2)
+  {
+    do
+    {
+      len1 = fread(a1, 1, sizeof(a1), fp1);
+      len2 = fread(a2, 1, sizeof(a2), fp2);
+      fSame = (len1 == len2 && memcmp(a1, a2, len1) == 0) ? TRUE : FALSE;
+    } while(fSame && len1 == sizeof(a1));
+  }
+  if(fp1)
+    fclose(fp1);
+  if(fp2)
+    fclose(fp2);
+
+  return fSame;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Get the modified time of a file.
+
+  @param    szPath    path to file
+  @param    pMtime    receives modified time (ns)
+  @return   TRUE if file exists
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdFileMtime(const char *szPath, uint64_t *pMtime)
+{
+  struct stat   st;
+
+  if(stat(szPath, &st) != 0)
+    return FALSE;
+#ifdef __APPLE__
+  *pMtime = (uint64_t)st.st_mtimespec.tv_sec * 1000000000ULL + (uint64_t)st.st_mtimespec.tv_nsec;
+#else
+  *pMtime = (uint64_t)st.st_mtim.tv_sec * 1000000000ULL + (uint64_t)st.st_mtim.tv_nsec;
+#endif
+  return TRUE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Is the .gz sibling of an unchanged file up to date? It is if it was written at or after the file.
+
+  @param    szPath    path to file
+  @param    szGz      path to szPath.gz
+  @return   TRUE if szGz is at least as new as szPath
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdFileGzFresh(const char *szPath, const char *szGz)
+{
+  uint64_t  mtime;
+  uint64_t  mtimeGz;
+
+  return (MdFileMtime(szPath, &mtime) && MdFileMtime(szGz, &mtimeGz) && mtimeGz >= mtime) ? TRUE : FALSE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Is this data worth compressing? Tiny files and files that are already compressed (images,
+  archives) don't get smaller, so they are known not to be without compressing them, every build.
+
+  @param    pData     ptr to data
+  @param    len       length of data
+  @return   TRUE if it may get smaller
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdFileGzWorth(const void *pData, size_t len)
+{
+  static const char *aszMagic[] = { "\x89PNG", "\xff\xd8\xff", "GIF8", "RIFF", "\x1f\x8b", "PK\x03\x04" };
+  unsigned  i;
+
+  if(len < FLYDOC_GZ_MIN)
+    return FALSE;
+  for(i = 0; i < NumElements(aszMagic); ++i)
+  {
+    if(memcmp(pData, aszMagic[i], strlen(aszMagic[i])) == 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write the gzip compressed data to szGz, from memory or a block at a time from a file. The gzip
+  header has no name or time, so the same data always gives the same file. If compressing doesn't
+  make it smaller, szGz is removed instead, so a web server sends the file itself.
+
+  @param    szGz      path to .gz file
+  @param    pData     ptr to data, or NULL to read fpIn
+  @param    len       length of data
+  @param    fpIn      file to compress if pData is NULL
+  @return   TRUE if worked, FALSE if couldn't write file
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdFileWriteGz(const char *szGz, const void *pData, size_t len, FILE *fpIn)
+{
+  z_stream  strm;
+  uint8_t   aIn[FLYDOC_GZ_BLOCK];
+  uint8_t   aOut[FLYDOC_GZ_BLOCK];
+  FILE     *fp;
+  size_t    lenOut;
+  int       flush;
+  int       ret     = Z_OK;
+  bool_t    fWorked = TRUE;
+
+  fp = fopen(szGz, "wb");
+  if(fp == NULL)
+    return FALSE;
+
+  // windowBits 15 + 16 asks for a gzip (rather than zlib) header
+  memset(&strm, 0, sizeof(strm));
+  if(deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    fclose(fp);
+    remove(szGz);
+    return FALSE;
+  }
+  if(pData)
+  {
+    strm.next_in  = (Bytef *)pData;
+    strm.avail_in = (uInt)len;
+  }
+
+  while(fWorked && ret != Z_STREAM_END)
+  {
+    if(pData == NULL && strm.avail_in == 0)
+    {
+      strm.next_in  = aIn;
+      strm.avail_in = (uInt)fread(aIn, 1, sizeof(aIn), fpIn);
+    }
+    flush = (pData || feof(fpIn) || ferror(fpIn)) ? Z_FINISH : Z_NO_FLUSH;
+    do
+    {
+      strm.next_out  = aOut;
+      strm.avail_out = sizeof(aOut);
+      ret = deflate(&strm, flush);
+      lenOut = sizeof(aOut) - strm.avail_out;
+      if(ret == Z_STREAM_ERROR || fwrite(aOut, 1, lenOut, fp) != lenOut)
+        fWorked = FALSE;
+    } while(fWorked && strm.avail_out == 0);
+    if(flush == Z_NO_FLUSH && ret == Z_BUF_ERROR)
+      ret = Z_OK;
+  }
+  if(pData == NULL && ferror(fpIn))
+    fWorked = FALSE;
+  if(fclose(fp) != 0)
+    fWorked = FALSE;
+
+  if(!fWorked || strm.total_out >= strm.total_in)
+    remove(szGz);
+  deflateEnd(&strm);
+
+  return fWorked;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Get the path of the .gz sibling of a file, e.g. "out/index.html.gz".
+
+  @param    szPath    path to file
+  @return   allocated path, free with FlyFree()
+-------------------------------------------------------------------------------------------------*/
+static char * MdFileGzPath(const char *szPath)
+{
+  static const char szGzExt[] = ".gz";
+  char             *szGz;
+  size_t            size;
+
+  size = strlen(szPath) + sizeof(szGzExt);
+  szGz = FlyDocAlloc(size);
+  FlyStrZCpy(szGz, szPath, size);
+  FlyStrZCat(szGz, szGzExt, size);
+
+  return szGz;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write data to an output file. With `--changed`, the file is left alone (not even touched) if it
+  already has the same contents. With `--gzip`, a compressed copy is also written to szPath.gz,
+  straight from the data. Unchanged files aren't compressed again if their .gz is up to date, and
+  files not worth compressing (e.g. .png) never are.
+
+  If used as a library with an output callback (see FlyDocLibWrite()), the data goes to the
+  callback instead.
+
+  @param    pDoc      flydoc state with opts
+  @param    szPath    path to file
+  @param    pData     ptr to data
+  @param    len       length of data
+  @return   TRUE if worked (written or unchanged), FALSE if couldn't write file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocFileWrite(const flyDoc_t *pDoc, const char *szPath, const void *pData, size_t len)
+{
+  char             *szGz;
+  bool_t            fSame   = FALSE;
+  bool_t            fWorked = TRUE;
+
+  if(pDoc->pfnOut)
+    return pDoc->pfnOut(pDoc->pOutData, szPath, pData, len);
+
+  if(pDoc->opts.fChanged)
+    fSame = FlyDocFileSame(szPath, pData, len);
+  if(!fSame)
+    fWorked = FlyFileWriteBin(szPath, pData, (long)len);
+
+  if(fWorked && pDoc->opts.fGzip)
+  {
+    szGz = MdFileGzPath(szPath);
+    if(!MdFileGzWorth(pData, len))
+      remove(szGz);
+    else if(!(fSame && MdFileGzFresh(szPath, szGz)))
+      fWorked = MdFileWriteGz(szGz, pData, len, NULL);
+    FlyFreeIf(szGz);
+  }
+
+  return fWorked;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Finish an output file that was too big to build in memory, so was written as it was made, e.g.
+  the `--markdown` file. With `--changed` it was written to szTmp, which replaces szPath only if
+  the contents differ. With `--gzip`, the .gz is compressed from the file, a block at a time.
+
+  @param    pDoc      flydoc state with opts
+  @param    szPath    path to output file
+  @param    szTmp     path the file was written to, szTmp may be the same as szPath
+  @return   TRUE if worked (written or unchanged), FALSE if couldn't write file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocFileWriteDone(const flyDoc_t *pDoc, const char *szPath, const char *szTmp)
+{
+  char             *szGz;
+  FILE             *fp;
+  bool_t            fSame   = FALSE;
+  bool_t            fWorked = TRUE;
+
+  if(strcmp(szPath, szTmp) != 0)
+  {
+    fSame = FlyDocFilesSame(szPath, szTmp);
+    if(fSame)
+      remove(szTmp);
+    else if(rename(szTmp, szPath) != 0)
+      fWorked = FALSE;
+  }
+
+  if(fWorked && pDoc->opts.fGzip)
+  {
+    szGz = MdFileGzPath(szPath);
+    if(!(fSame && MdFileGzFresh(szPath, szGz)))
+    {
+      fp = fopen(szPath, "rb");
+      fWorked = fp ? MdFileWriteGz(szGz, NULL, 0, fp) : FALSE;
+      if(fp)
+        fclose(fp);
+    }
+    FlyFreeIf(szGz);
+  }
+
+  return fWorked;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Read an input file into memory, '\0' terminated, for parsing.
+
+  Where possible the file is memory mapped rather than copied to the heap. The mapping is private:
+  pages come from the OS file cache and can be reclaimed, so markdown documents kept for the whole
+  run don't add to the heap. The '\0' terminator comes free from the zero fill at the end of the
+  last page. If the file size is an exact multiple of the page size (no room for the '\0'), or the
+  file can't be mapped, it is read onto the heap instead.
+
+  Free with FlyDocInFileFree() or hand to an arena with FlyDocArenaOwnInFile().
+
+  @param    pIn       receives input file contents
+  @param    szPath    path to file
+  @return   TRUE if worked, FALSE if couldn't read the file (pIn->szFile is NULL)
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocInFileRead(flyDocInFile_t *pIn, const char *szPath)
+{
+  struct stat   st;
+  long          pageSize;
+  void         *pMap;
+  int           fd;
+
+  memset(pIn, 0, sizeof(*pIn));
+
+  fd = open(szPath, O_RDONLY);
+  if(fd >= 0)
+  {
+    pageSize = sysconf(_SC_PAGESIZE);
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && pageSize > 0 &&
+       (st.st_size % pageSize) != 0)
+    {
+      pMap = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if(pMap != MAP_FAILED)
+      {
+        pIn->szFile = pMap;
+        pIn->mapLen = (size_t)st.st_size;
+        pIn->len    = strlen(pIn->szFile);
+      }
+    }
+    close(fd);
+  }
+
+  if(pIn->szFile == NULL)
+  {
+    pIn->szFile = FlyFileRead(szPath);
+    if(pIn->szFile)
+      pIn->len = strlen(pIn->szFile);
+  }
+
+  return pIn->szFile ? TRUE : FALSE;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Free (or unmap) an input file from FlyDocInFileRead(). OK if already freed.
+
+  @param    pIn       input file
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocInFileFree(flyDocInFile_t *pIn)
+{
+  if(pIn->szFile)
+  {
+    if(pIn->mapLen)
+      munmap(pIn->szFile, pIn->mapLen);
+    else
+      FlyFree(pIn->szFile);
+  }
+  memset(pIn, 0, sizeof(*pIn));
+}
+
 /*!------------------------------------------------------------------------------------------------
   Determine total number of flydoc objects (modules, functions, documents, etc...)
 
@@ -126,6 +520,29 @@ void * FlyDocAlloc(size_t n)
   return pMem;
 }
 
+/*!------------------------------------------------------------------------------------------------
+  Hash a block of memory (64-bit FNV-1a). Not cryptographic, but fast with few collisions.
+
+  To hash more than one block, pass the result of the previous block as the hash.
+
+  @param    pData   ptr to data to hash
+  @param    len     length of data
+  @param    hash    FLYDOC_HASH_INIT or hash of previous block(s)
+  @return   hash of the data
+-------------------------------------------------------------------------------------------------*/
+uint64_t FlyDocHash(const void *pData, size_t len, uint64_t hash)
+{
+  const uint8_t  *p = pData;
+
+  while(len--)
+  {
+    hash ^= *p++;
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
 /*!------------------------------------------------------------------------------------------------
   Is this a flytdoc object?
 
@@ -153,6 +570,12 @@ void FlyDocInit(flyDoc_t *pDoc, const flyDocOpts_t *pOpts)
   pDoc->opts      = *pOpts;
   if(!pDoc->opts.szExts)
     pDoc->opts.szExts = SZ_FLY_DOC_EXTS;
+
+  // debug output is printed while parsing, so parse one file at a time
+  if(pDoc->opts.debug)
+    pDoc->opts.nJobs = 1;
+  if(pDoc->opts.split < 0)
+    pDoc->opts.split = 0;
 }
 
 /*!-------------------------------------------------------------------------------------------------
@@ -233,31 +656,122 @@ void FlyDocStyleGet(flyDoc_t *pDoc, flyDocSection_t *pSection, flyDocStyle_t *pS
     pStyle->szVersion = (char *)szEmpty;
 }
 
-/*!------------------------------------------------------------------------------------------------
-  Copy any referenced images to ouput folder.
+// the library (libflydoc.a) is all of flydoc but the program itself
+#ifndef FLYDOC_LIB
+/*-------------------------------------------------------------------------------------------------
+  Build the documentation: walk and parse the inputs, then write the HTML or markdown output.
+  Prints stats and, with --profile, where the time went.
 
-  Uses pDoc->szOutPath, pImgFileList
-
-  @param    pDoc    Filled out flyDoc_t object
-  @return   none
+  @param    pDoc    flydoc state from FlyDocInit(), nothing parsed yet
+  @param    pCli    command-line with the inputs
+  @return   TRUE if worked, FALSE if output couldn't be written
 -------------------------------------------------------------------------------------------------*/
-void FlyDocCopyReferencedImages(flyDoc_t *pDoc)
+static bool_t MdBuild(flyDoc_t *pDoc, const flyCli_t *pCli)
 {
-  flyDocFile_t *pImgFile = pDoc->pImgFileList;
+  bool_t    fWorked = TRUE;
+  bool_t    fProfile;
+  int       i;
+
+  // parse the input files
+  if((pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE) || pDoc->opts.debug)
+    printf("\nProcessing file(s)...\n");
 
-  while(pImgFile)
+  // one walk of the inputs collects all images (pDoc->pImgFileList) and queues files to parse
+  fProfile = pDoc->opts.fProfile;
+  FlyDocProfInit(pDoc);
+  FlyDocSpillInit(pDoc);
+  FlyDocProfPhase(pDoc, FLYDOC_PHASE_WALK);
+  for(i = 1; !pDoc->opts.szLoadDb && i < FlyCliNumArgs(pCli); ++i)
   {
-    if(pImgFile->fReferenced)
+    pDoc->level = 0;
+    FlyDocProcessFolderTree(pDoc, FlyCliArg(pCli, i));
+  }
+
+  if(pDoc->opts.debug >= 12)
+  {
+    FlyDocPrintDoc(pDoc, pDoc->opts.debug);
+    exit(1);
+  }
+
+  // parse all inputs files into the flyDoc_t structure, or load one parsed earlier by --emit-db
+  FlyDocProfPhase(pDoc, FLYDOC_PHASE_PARSE);
+  if(pDoc->opts.szLoadDb)
+  {
+    if((pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE) || pDoc->opts.debug)
+      printf("%s\n", pDoc->opts.szLoadDb);
+    if(!FlyDocDbLoad(pDoc, pDoc->opts.szLoadDb))
     {
-      FlyStrZCpy(pDoc->szPath, pDoc->opts.szOut, sizeof(pDoc->szPath));
-      FlyStrPathAppend(pDoc->szPath, FlyStrPathNameOnly(pImgFile->szPath), sizeof(pDoc->szPath));
-      if(pDoc->opts.verbose >= FLYDOC_DEBUG_MORE)
-        printf("  Copying %s => %s\n", pImgFile->szPath, pDoc->szPath);
-      if(!FlyFileCopy(pDoc->szPath, pImgFile->szPath))
-        FlyDocAssertMem();
+      printf("Not a flydoc v" FLYDOC_VER_STR " db file: %s\n", pDoc->opts.szLoadDb);
+      exit(1);
     }
-    pImgFile = pImgFile->pNext;
   }
+  else
+  {
+    FlyDocParseInputs(pDoc);
+    FlyDocProfPhase(pDoc, FLYDOC_PHASE_SORT);
+    if(pDoc->opts.fSort)
+      FlyDocSortLists(pDoc);
+  }
+  FlyDocProfPhase(pDoc, FLYDOC_PHASE_MAX);
+
+  // write the parsed document for later runs with --load-db
+  if(pDoc->opts.szEmitDb && !FlyDocDbSave(pDoc, pDoc->opts.szEmitDb))
+  {
+    FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->opts.szEmitDb);
+    fWorked = FALSE;
+  }
+
+  // calculate statistics
+  FlyDocStatsUpdate(pDoc);
+
+  // print out internal structures
+  if(pDoc->opts.debug)
+    FlyDocPrintDoc(pDoc, pDoc->opts.debug);
+
+  if(FlyDocNumObjects(pDoc) == 0)
+  {
+    FlyDocPrintWarning(pDoc, szWarningNoObjects, NULL);
+  }
+
+  else if(!pDoc->opts.fNoBuild)
+  {
+    if((pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE) || pDoc->opts.debug)
+      printf("\nCreating file(s)...\n");
+    FlyDocProfPhase(pDoc, FLYDOC_PHASE_WRITE);
+    if(pDoc->opts.fMarkdown)
+    {
+      if(!FlyDocWriteMarkdown(pDoc))
+        fWorked = FALSE;
+    }
+    else
+    {
+      if(!FlyDocWriteHtml(pDoc))
+        fWorked = FALSE;
+    }
+
+    // copy any locally referenced images to out folder
+    FlyDocProfPhase(pDoc, FLYDOC_PHASE_IMAGES);
+    if(fWorked)
+      FlyDocCopyReferencedImages(pDoc);
+    FlyDocProfPhase(pDoc, FLYDOC_PHASE_MAX);
+    FlyDocStatsUpdate(pDoc);
+  }
+
+  // print # of modules, classes, functions, examples, etc...
+  if(fWorked && pDoc->opts.verbose && !(pDoc->opts.debug && pDoc->opts.fNoBuild))
+    FlyDocPrintStats(pDoc);
+
+  // print or write where the time went
+  if(fProfile)
+    FlyDocProfPrint(pDoc);
+  if(pDoc->opts.szProfileJson && !FlyDocProfWriteJson(pDoc, pDoc->opts.szProfileJson))
+    FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->opts.szProfileJson);
+  FlyDocProfFree(pDoc);
+
+  // with --max-mem, text in the spill file is gone, so the document is done
+  FlyDocSpillFree(pDoc);
+
+  return fWorked;
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -272,17 +786,32 @@ int main(int argc, const char *argv[])
   flyDocOpts_t        opts;
   const flyCliOpt_t   cliOpts[] =
   {
+    { "-j",           &opts.nJobs,      FLYCLI_INT },
     { "-n",           &opts.fNoBuild,   FLYCLI_BOOL },
     { "-o",           &opts.szOut,      FLYCLI_STRING },
     { "-s",           &opts.fSort,      FLYCLI_BOOL },
     { "-v",           &opts.verbose,    FLYCLI_INT },
+    { "--cache",      &opts.szCache,    FLYCLI_STRING },
+    { "--changed",    &opts.fChanged,   FLYCLI_BOOL },
+    { "--copy",       &opts.szCopy,     FLYCLI_STRING },
     { "--debug",      &opts.debug,      FLYCLI_INT },     // hidden option
+    { "--emit-db",    &opts.szEmitDb,   FLYCLI_STRING },
+    { "--exclude",    &opts.szExclude,  FLYCLI_STRING },
     { "--exts",       &opts.szExts,     FLYCLI_STRING },
+    { "--gzip",       &opts.fGzip,      FLYCLI_BOOL },
+    { "--load-db",    &opts.szLoadDb,   FLYCLI_STRING },
     { "--local",      &opts.fLocal,     FLYCLI_BOOL },
     { "--markdown",   &opts.fMarkdown,  FLYCLI_BOOL },
+    { "--max-mem",    &opts.maxMem,     FLYCLI_INT },
     { "--noindex",    &opts.fNoIndex,   FLYCLI_BOOL },
+    { "--nolink",     &opts.fNoLink,    FLYCLI_BOOL },
+    { "--nosearch",   &opts.fNoSearch,  FLYCLI_BOOL },
+    { "--profile",    &opts.fProfile,   FLYCLI_BOOL },
+    { "--profile-json", &opts.szProfileJson, FLYCLI_STRING },
     { "--slug",       &opts.szSlug,     FLYCLI_STRING },  // make a slug from a string
+    { "--split",      &opts.split,      FLYCLI_INT },
     { "--user-guide", &opts.fUserGuide, FLYCLI_BOOL },
+    { "--watch",      &opts.fWatch,     FLYCLI_BOOL },
   };
   const flyCli_t cli =
   {
@@ -291,30 +820,46 @@ int main(int argc, const char *argv[])
     .nOpts      = NumElements(cliOpts),
     .pOpts      = cliOpts,
     .szVersion  = "flydoc v" FLYDOC_VER_STR,
-    .szHelp     = "Usage = flydoc [-n] [-o out/] [-s] [-v] [--combine] [--exts .c.js] [--local] [--markdown] [--noindex] in...\n"
+    .szHelp     = "Usage = flydoc [-j=#] [-n] [-o out/] [-s] [-v] [--cache dir/] [--changed] [--combine] [--copy=how] [--emit-db file] [--exclude pats] [--exts .c.js] [--gzip] [--load-db file] [--local] [--markdown] [--max-mem=#] [--noindex] [--nolink] [--nosearch] [--profile] [--profile-json file] [--split=#] [--watch] in...\n"
     "\n"
     "Options:\n"
+    "-j[=#]           Parse inputs and write pages using # threads. Default: 1\n"
     "-n               Parse inputs only, no output, useful to check for warnings\n"
     "-o               Output folder/\n"
     "-s               Sort modules/functions/classes/methods: -s- (off), -s (on: default)\n"
     "-v[=#]           Verbosity: -v- (none), -v=1 (some), -v=2 (more: default)\n"
+    "--cache dir/     Cache parse results of source files in dir/ for faster rebuilds\n"
+    "--changed        Only write output files whose contents have changed\n"
+    "--copy=how       Copy images with: copy (default, reflink if possible), link (hard) or symlink\n"
+    "--emit-db file   Write the parsed document to file, to render later with --load-db\n"
+    "--exclude pats   Skip files/folders matching comma separated patterns, e.g. \"build,*.min.js\"\n"
     "--exts           List of file exts to search. Default: \".c.c++.cc.cpp.cxx.cs.go.java.js.py.rs.swift.ts\"\n"
+    "--gzip           Also write a precompressed .gz copy of each output file, for web servers\n"
+    "--load-db file   Render the parsed document from --emit-db file rather than parse inputs\n"
     "--local          Create local w3.css file rather than remote link to w3.css\n"
     "--markdown       Create a single combine markdown file rather than HTML pages\n"
+    "--max-mem=#      Keep at most # MB of document text in memory, the rest in a pageable temp file\n"
     "--noindex        Don't create index.html (mainpage). Allows for custom main page\n"
+    "--nolink         Don't link mentions of functions, modules and classes in text\n"
+    "--nosearch       Don't create the search box and search index in HTML pages\n"
+    "--profile        Print time spent in each phase, bytes read/written and slowest files/pages\n"
+    "--profile-json f Same as --profile, but write the report to file f as JSON\n"
     "--slug \"str\"     Print local reference id (slug) from a string\n"
+    "--split=#        Split modules/classes over pages of # functions, and main page lists every # entries\n"
     "--user-guide     Print flydoc user guide to the screen\n"
+    "--watch          Rebuild when inputs change, only reparsing changed files and rewriting changed pages\n"
     "in...            Input files and folders\n"
   };
-  flyDoc_t  flyDoc;
-  int       nArgs;
-  int       i;
-  bool_t    fWorked = TRUE;
+  flyDoc_t              flyDoc;
+  struct flyDocWatch   *pWatch;
+  int                   nArgs;
+  bool_t                fWorked;
 
   memset(&flyDoc, 0, sizeof(flyDoc));
   memset(&opts, 0, sizeof(opts));
   opts.verbose = FLYDOC_VERBOSE_MORE;
   opts.fSort   = TRUE;
+  opts.nJobs   = 1;
   if(FlyCliParse(&cli) != FLYCLI_ERR_NONE)
     exit(1);
 
@@ -335,12 +880,25 @@ int main(int argc, const char *argv[])
   else if(opts.verbose)
     printf("flydoc v" FLYDOC_VER_STR "\n");
   nArgs = FlyCliNumArgs(&cli);
-  if(nArgs < 2)
+  if(nArgs < 2 && !opts.szLoadDb)
   {
     printf("No input files or folders. Try flydoc --help\n");
     exit(1);
   }
 
+  // a db file doesn't change, so there is nothing to watch
+  if(opts.szLoadDb && opts.fWatch)
+  {
+    printf("--watch can't be used with --load-db\n");
+    exit(1);
+  }
+
+  if(FlyDocCopyHow(opts.szCopy) < 0)
+  {
+    printf("--copy must be copy, link or symlink\n");
+    exit(1);
+  }
+
   // initialize document structure
   FlyDocInit(&flyDoc, &opts);
 
@@ -358,66 +916,28 @@ int main(int argc, const char *argv[])
       flyDoc.opts.verbose, flyDoc.opts.fMarkdown, flyDoc.opts.szExts, flyDoc.opts.debug, flyDoc.opts.szOut);
   }
 
-  // parse the input files
-  if((flyDoc.opts.verbose >= FLYDOC_VERBOSE_MORE) || flyDoc.opts.debug)
-    printf("\nProcessing file(s)...\n");
-
-  // collect all images into an array of files (flyDoc.apImagesFiles)
-  for(i = 1; i < nArgs; ++i)
+  // initial build, then with --watch, build again each time an input changes
+  if(opts.fWatch)
+    FlyDocWatchInit(&flyDoc);
+  fWorked = MdBuild(&flyDoc, &cli);
+  while(opts.fWatch)
   {
-    flyDoc.level = 0;
-    FlyDocPreProcess(&flyDoc, FlyCliArg(&cli, i));
+    if(!fWorked)
+      FlyDocWatchPagesForget(&flyDoc);
+    if(opts.verbose)
+      printf("\nWatching for changes, Ctrl-C to stop...\n");
+    FlyDocWatchWait(&flyDoc);
+
+    pWatch = flyDoc.pWatch;
+    FlyDocArenaFree(&flyDoc.arena);
+    FlyDocInit(&flyDoc, &opts);
+    flyDoc.pWatch = pWatch;
+    fWorked = MdBuild(&flyDoc, &cli);
   }
 
-  if(opts.debug >= 12)
-  {
-    FlyDocPrintDoc(&flyDoc, opts.debug);
-    exit(1);
-  }
-
-  // parse all inputs files into the flyDoc_t structure
-  for(i = 1; i < nArgs; ++i)
-  {
-    flyDoc.level = 0;
-    FlyDocProcessFolderTree(&flyDoc, FlyCliArg(&cli, i));
-  }
-
-  // calculate statistics
-  FlyDocStatsUpdate(&flyDoc);
-
-  // print out internal structures
-  if(opts.debug)
-    FlyDocPrintDoc(&flyDoc, opts.debug);
-
-  if(FlyDocNumObjects(&flyDoc) == 0)
-  {
-    FlyDocPrintWarning(&flyDoc, szWarningNoObjects, NULL);
-  }
-
-  else if(!flyDoc.opts.fNoBuild)
-  {
-    if((flyDoc.opts.verbose >= FLYDOC_VERBOSE_MORE) || flyDoc.opts.debug)
-      printf("\nCreating file(s)...\n");
-    if(flyDoc.opts.fMarkdown)
-    {
-      if(!FlyDocWriteMarkdown(&flyDoc))
-        fWorked = FALSE;
-    }
-    else
-    {
-      if(!FlyDocWriteHtml(&flyDoc))
-        fWorked = FALSE;
-    }
-
-    // copy any locally referenced images to out folder
-    if(fWorked)
-      FlyDocCopyReferencedImages(&flyDoc);
-    FlyDocStatsUpdate(&flyDoc);
-  }
-
-  // print # of modules, classes, functions, examples, etc...
-  if(fWorked && flyDoc.opts.verbose && !(opts.debug && opts.fNoBuild))
-    FlyDocPrintStats(&flyDoc);
+  // the whole parsed document is freed at once
+  FlyDocArenaFree(&flyDoc.arena);
 
   return flyDoc.nWarnings ? 1 : 0;
 }
+#endif // FLYDOC_LIB
@@ -0,0 +1,238 @@
+/**************************************************************************************************
+  flydocarena.c - Arena (region) allocator for the parsed document tree
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include "flydoc.h"
+
+#define FLYDOC_ARENA_BLK_SIZE   (64 * 1024)   // normal block size
+#define FLYDOC_ARENA_ALIGN      16            // all allocations are aligned to this
+#define FLYDOC_ARENA_BIG        (FLYDOC_ARENA_BLK_SIZE / 4) // bigger than this gets its own block
+
+#define MdArenaRound(n)         (((n) + (FLYDOC_ARENA_ALIGN - 1)) & ~(size_t)(FLYDOC_ARENA_ALIGN - 1))
+
+/*!
+  @defgroup flydoc_arena   Arena (region) allocator for the parsed document tree
+
+  Everything parsed into a flyDoc_t (modules, functions, examples, images, markdown headers and all
+  of their strings) is allocated from the arena in the flyDoc_t. This is much faster than many small
+  heap allocations, and there is nothing to free piece by piece: the whole arena is freed at once.
+
+  Memory from the arena is always zeroed and can't fail (out of memory asserts). Heap memory or
+  input files that should live as long as the tree, such as the contents of markdown files, can be
+  handed to the arena with FlyDocArenaOwn() or FlyDocArenaOwnInFile() and are freed along with it.
+
+  Each partial doc (see FlyDocParseInputs()) has its own arena, so worker threads never share one.
+  When a partial doc is merged, its arena is moved into the main doc's arena with FlyDocArenaMove().
+*/
+
+// a block of arena memory, allocations follow the header
+typedef struct flyDocArenaBlk
+{
+  struct flyDocArenaBlk  *pNext;
+  size_t                  size;     // usable size of block
+  size_t                  used;     // bytes allocated so far
+} flyDocArenaBlk_t;
+
+// heap memory or an input file owned by the arena
+typedef struct flyDocArenaOwn
+{
+  struct flyDocArenaOwn  *pNext;
+  void                   *pMem;     // heap memory, or NULL if input file
+  flyDocInFile_t          inFile;
+} flyDocArenaOwn_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Allocate a new zeroed block.
+
+  @param    pArena    the arena (for statistics)
+  @param    size      usable size of the block
+  @return   ptr to block
+-------------------------------------------------------------------------------------------------*/
+static flyDocArenaBlk_t * MdArenaBlkNew(flyDocArena_t *pArena, size_t size)
+{
+  flyDocArenaBlk_t *pBlk;
+
+  pBlk = FlyAllocZ(MdArenaRound(sizeof(*pBlk)) + size);
+  FlyDocAllocCheck(pBlk);
+  pBlk->size = size;
+  pArena->size += size;
+
+  return pBlk;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Allocate zeroed memory from the arena. Never returns NULL.
+
+  @param    pArena    the arena
+  @param    n         number of bytes
+  @return   ptr to zeroed memory, aligned for any type
+-------------------------------------------------------------------------------------------------*/
+void * FlyDocArenaAlloc(flyDocArena_t *pArena, size_t n)
+{
+  flyDocArenaBlk_t *pBlk = pArena->pBlkList;
+  uint8_t          *pMem;
+
+  n = n ? MdArenaRound(n) : FLYDOC_ARENA_ALIGN;
+
+  // big allocations get their own block, placed behind the current block so it keeps its space
+  if(n > FLYDOC_ARENA_BIG && pBlk)
+  {
+    pBlk        = MdArenaBlkNew(pArena, n);
+    pBlk->pNext = pArena->pBlkList->pNext;
+    pArena->pBlkList->pNext = pBlk;
+  }
+
+  // current block full, start a new one
+  else if(pBlk == NULL || pBlk->size - pBlk->used < n)
+  {
+    pBlk        = MdArenaBlkNew(pArena, n > FLYDOC_ARENA_BIG ? n : FLYDOC_ARENA_BLK_SIZE);
+    pBlk->pNext = pArena->pBlkList;
+    pArena->pBlkList = pBlk;
+  }
+
+  pMem = (uint8_t *)pBlk + MdArenaRound(sizeof(*pBlk)) + pBlk->used;
+  pBlk->used += n;
+  ++pArena->nAllocs;
+
+  return pMem;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Allocate a '\0' terminated copy of a string (or part of a string) from the arena.
+
+  @param    pArena    the arena
+  @param    sz        string, need not be '\0' terminated
+  @param    len       length of string to copy
+  @return   ptr to copy of string
+-------------------------------------------------------------------------------------------------*/
+char * FlyDocArenaStrAllocN(flyDocArena_t *pArena, const char *sz, size_t len)
+{
+  char *szNew;
+
+  szNew = FlyDocArenaAlloc(pArena, len + 1);
+  if(len)
+    memcpy(szNew, sz, len);
+
+  return szNew;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Allocate a copy of a string from the arena.
+
+  @param    pArena    the arena
+  @param    sz        '\0' terminated string
+  @return   ptr to copy of string
+-------------------------------------------------------------------------------------------------*/
+char * FlyDocArenaStrClone(flyDocArena_t *pArena, const char *sz)
+{
+  return FlyDocArenaStrAllocN(pArena, sz, strlen(sz));
+}
+
+/*!------------------------------------------------------------------------------------------------
+  The arena takes ownership of heap memory (from FlyAlloc()), which is freed with the arena.
+
+  @param    pArena    the arena
+  @param    pMem      heap memory
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocArenaOwn(flyDocArena_t *pArena, void *pMem)
+{
+  flyDocArenaOwn_t *pOwn;
+
+  pOwn = FlyDocArenaAlloc(pArena, sizeof(*pOwn));
+  pOwn->pMem = pMem;
+  pOwn->pNext = pArena->pOwnList;
+  pArena->pOwnList = pOwn;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  The arena takes ownership of an input file from FlyDocInFileRead(), which is freed (or unmapped)
+  with the arena. pIn is left empty.
+
+  @param    pArena    the arena
+  @param    pIn       input file
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocArenaOwnInFile(flyDocArena_t *pArena, flyDocInFile_t *pIn)
+{
+  flyDocArenaOwn_t *pOwn;
+
+  pOwn = FlyDocArenaAlloc(pArena, sizeof(*pOwn));
+  pOwn->inFile = *pIn;
+  pOwn->pNext = pArena->pOwnList;
+  pArena->pOwnList = pOwn;
+  memset(pIn, 0, sizeof(*pIn));
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Move everything in the source arena into the destination arena. Source arena is left empty.
+
+  @param    pDst      the arena to move into
+  @param    pSrc      the arena to move from
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocArenaMove(flyDocArena_t *pDst, flyDocArena_t *pSrc)
+{
+  flyDocArenaBlk_t *pBlk;
+  flyDocArenaOwn_t *pOwn;
+
+  // source blocks go behind the destination's current block
+  if(pSrc->pBlkList)
+  {
+    if(pDst->pBlkList == NULL)
+      pDst->pBlkList = pSrc->pBlkList;
+    else
+    {
+      pBlk = pSrc->pBlkList;
+      while(pBlk->pNext)
+        pBlk = pBlk->pNext;
+      pBlk->pNext = pDst->pBlkList->pNext;
+      pDst->pBlkList->pNext = pSrc->pBlkList;
+    }
+  }
+
+  if(pSrc->pOwnList)
+  {
+    pOwn = pSrc->pOwnList;
+    while(pOwn->pNext)
+      pOwn = pOwn->pNext;
+    pOwn->pNext = pDst->pOwnList;
+    pDst->pOwnList = pSrc->pOwnList;
+  }
+
+  pDst->size    += pSrc->size;
+  pDst->nAllocs += pSrc->nAllocs;
+  memset(pSrc, 0, sizeof(*pSrc));
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Free the arena, all memory allocated from it and all memory it owns. Arena is left empty, ready
+  for reuse.
+
+  @param    pArena    the arena
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocArenaFree(flyDocArena_t *pArena)
+{
+  flyDocArenaBlk_t *pBlk;
+  flyDocArenaOwn_t *pOwn;
+
+  // owned list is in the blocks, so free it first
+  for(pOwn = pArena->pOwnList; pOwn; pOwn = pOwn->pNext)
+  {
+    if(pOwn->pMem)
+      FlyFree(pOwn->pMem);
+    else
+      FlyDocInFileFree(&pOwn->inFile);
+  }
+
+  while(pArena->pBlkList)
+  {
+    pBlk = pArena->pBlkList;
+    pArena->pBlkList = pBlk->pNext;
+    FlyFree(pBlk);
+  }
+
+  memset(pArena, 0, sizeof(*pArena));
+}
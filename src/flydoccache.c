@@ -0,0 +1,801 @@
+/**************************************************************************************************
+  flydoccache.c - Cache parse results of source files for faster rebuilds
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include "flydoc.h"
+#include "FlyList.h"
+#include "FlyStr.h"
+
+/*!
+  @defgroup flydoc_cache   Cache parse results of source files for faster rebuilds
+
+  With `--cache folder/`, the result of parsing each source file (its partial doc, see
+  FlyDocParseInputs()) is saved into the cache folder, one cache file per input file.
+
+  On the next run, if the contents of the source file are the same, the partial doc is loaded from
+  the cache rather than parsed. Warnings from the source file are saved too, so the output of the
+  run is the same whether the cache is used or not.
+
+  A cache file contains:
+
+  1. magic string (changes if the format changes)
+  2. context hash: flydoc version and input image files, as these affect parsing
+  3. hash of the source file contents
+  4. path of the source file
+  5. partial doc: counts, mainpage, modules, classes, image references and warnings
+
+  Any mismatch or problem with a cache file means the source file is simply parsed. Cache files
+  are in native form: numbers little endian, strings length first, so a cache is portable.
+
+  `--watch` keeps the same form in memory, one per source file, see FlyDocCacheSaveMem().
+
+  The same form also holds a whole parsed document. `--emit-db file` writes the merged and sorted
+  document after parsing (see FlyDocDbSave()), and `--load-db file` reads it back in place of
+  parsing (see FlyDocDbLoad()), so one parse can be rendered many times: HTML, `--markdown`, or with
+  different output options. Besides what a cache file has, a db file has the markdown documents
+  with their contents, the language of each function, and the input image files.
+*/
+
+#define FLYDOC_CACHE_NULL   0xffffffffUL    // string length for a NULL string
+
+static const char m_szCacheMagic[]  = "flydoc-cache-1\n";
+static const char m_szCacheExt[]    = ".fdc";
+static const char m_szDbMagic[]     = "flydoc-db-1\n";
+
+// reading a cache file from memory
+typedef struct
+{
+  const uint8_t  *p;
+  const uint8_t  *pEnd;
+  flyDocArena_t  *pArena;   // strings and objects are allocated from the partial doc's arena
+  flyDoc_t       *pDoc;     // doc the arena is in, for text, see MdCacheRdText()
+  bool_t          fOk;
+} flyDocCacheRd_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Get the path of the cache file for this source file, e.g. "cache/0123456789abcdef.fdc"
+
+  @param    pDoc      flydoc state with opts.szCache
+  @param    szCache   receives cache file path (size PATH_MAX)
+  @param    szPath    source file path
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdCachePath(const flyDoc_t *pDoc, char *szCache, const char *szPath)
+{
+  char  szName[24];
+
+  snprintf(szName, sizeof(szName), "%016llx",
+           (unsigned long long)FlyDocHash(szPath, strlen(szPath), FLYDOC_HASH_INIT));
+  FlyStrZCpy(szCache, pDoc->opts.szCache, PATH_MAX);
+  FlyStrPathAppend(szCache, szName, PATH_MAX);
+  FlyStrZCat(szCache, m_szCacheExt, PATH_MAX);
+}
+
+static void MdCacheWrU32(FILE *fp, uint32_t n)
+{
+  uint8_t   a[4];
+
+  a[0] = (uint8_t)n;
+  a[1] = (uint8_t)(n >> 8);
+  a[2] = (uint8_t)(n >> 16);
+  a[3] = (uint8_t)(n >> 24);
+  fwrite(a, 1, sizeof(a), fp);
+}
+
+static void MdCacheWrU64(FILE *fp, uint64_t n)
+{
+  MdCacheWrU32(fp, (uint32_t)n);
+  MdCacheWrU32(fp, (uint32_t)(n >> 32));
+}
+
+static void MdCacheWrStrN(FILE *fp, const char *sz, size_t len)
+{
+  if(sz == NULL)
+    MdCacheWrU32(fp, FLYDOC_CACHE_NULL);
+  else
+  {
+    MdCacheWrU32(fp, (uint32_t)len);
+    fwrite(sz, 1, len, fp);
+  }
+}
+
+static void MdCacheWrStr(FILE *fp, const char *sz)
+{
+  MdCacheWrStrN(fp, sz, sz ? strlen(sz) : 0);
+}
+
+static uint32_t MdCacheRdU32(flyDocCacheRd_t *pRd)
+{
+  uint32_t n = 0;
+
+  if(!pRd->fOk || pRd->pEnd - pRd->p < 4)
+    pRd->fOk = FALSE;
+  else
+  {
+    n = (uint32_t)pRd->p[0] | ((uint32_t)pRd->p[1] << 8) | ((uint32_t)pRd->p[2] << 16) |
+        ((uint32_t)pRd->p[3] << 24);
+    pRd->p += 4;
+  }
+
+  return n;
+}
+
+static uint64_t MdCacheRdU64(flyDocCacheRd_t *pRd)
+{
+  uint64_t n;
+
+  n = MdCacheRdU32(pRd);
+  n |= (uint64_t)MdCacheRdU32(pRd) << 32;
+
+  return n;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Read an allocated string (or NULL) from the cache.
+
+  @param    pRd     cache reader
+  @return   string allocated from arena or NULL
+-------------------------------------------------------------------------------------------------*/
+static char * MdCacheRdStr(flyDocCacheRd_t *pRd)
+{
+  char       *sz = NULL;
+  uint32_t    len;
+
+  len = MdCacheRdU32(pRd);
+  if(pRd->fOk && len != FLYDOC_CACHE_NULL)
+  {
+    if((size_t)(pRd->pEnd - pRd->p) < len)
+      pRd->fOk = FALSE;
+    else
+    {
+      sz = FlyDocArenaStrAllocN(pRd->pArena, (const char *)pRd->p, len);
+      pRd->p += len;
+    }
+  }
+
+  return sz;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Read document text (or NULL) from the cache, the same as MdCacheRdStr(), but allocated with
+  FlyDocTextAlloc() so it can spill with --max-mem.
+
+  @param    pRd     cache reader
+  @return   text or NULL
+-------------------------------------------------------------------------------------------------*/
+static char * MdCacheRdText(flyDocCacheRd_t *pRd)
+{
+  char       *sz = NULL;
+  uint32_t    len;
+
+  len = MdCacheRdU32(pRd);
+  if(pRd->fOk && len != FLYDOC_CACHE_NULL)
+  {
+    if((size_t)(pRd->pEnd - pRd->p) < len)
+      pRd->fOk = FALSE;
+    else
+    {
+      sz = FlyDocTextAlloc(pRd->pDoc, (size_t)len + 1);
+      memcpy(sz, pRd->p, len);
+      pRd->p += len;
+    }
+  }
+
+  return sz;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write a section (mainpage, module or class) to the cache.
+
+  @param    fp        open cache file
+  @param    pSection  section to write
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdCacheWrSection(FILE *fp, const flyDocSection_t *pSection)
+{
+  const flyDocExample_t *pExample;
+
+  MdCacheWrStr(fp, pSection->szTitle);
+  MdCacheWrStr(fp, pSection->szSubtitle);
+  MdCacheWrStr(fp, pSection->szText);
+  MdCacheWrStr(fp, pSection->szBarColor);
+  MdCacheWrStr(fp, pSection->szTitleColor);
+  MdCacheWrStr(fp, pSection->szHeadingColor);
+  MdCacheWrStr(fp, pSection->szFontBody);
+  MdCacheWrStr(fp, pSection->szFontHeadings);
+  MdCacheWrStr(fp, pSection->szLogo);
+  MdCacheWrStr(fp, pSection->szVersion);
+  MdCacheWrU32(fp, (uint32_t)FlyListLen(pSection->pExampleList));
+  for(pExample = pSection->pExampleList; pExample; pExample = pExample->pNext)
+    MdCacheWrStr(fp, pExample->szTitle);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Read a section (mainpage, module or class) from the cache.
+
+  @param    pRd       cache reader
+  @param    pSection  section to fill in (assumed zeroed)
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdCacheRdSection(flyDocCacheRd_t *pRd, flyDocSection_t *pSection)
+{
+  flyDocExample_t  *pExample;
+  uint32_t          n;
+
+  pSection->szTitle         = MdCacheRdStr(pRd);
+  pSection->szSubtitle      = MdCacheRdStr(pRd);
+  pSection->szText          = MdCacheRdText(pRd);
+  pSection->szBarColor      = MdCacheRdStr(pRd);
+  pSection->szTitleColor    = MdCacheRdStr(pRd);
+  pSection->szHeadingColor  = MdCacheRdStr(pRd);
+  pSection->szFontBody      = MdCacheRdStr(pRd);
+  pSection->szFontHeadings  = MdCacheRdStr(pRd);
+  pSection->szLogo          = MdCacheRdStr(pRd);
+  pSection->szVersion       = MdCacheRdStr(pRd);
+  n = MdCacheRdU32(pRd);
+  while(pRd->fOk && n--)
+  {
+    pExample = FlyDocArenaAlloc(pRd->pArena, sizeof(*pExample));
+    pExample->szTitle = MdCacheRdStr(pRd);
+    pSection->pExampleList = FlyListAppend(pSection->pExampleList, pExample);
+    if(pExample->szTitle == NULL)
+      pRd->fOk = FALSE;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write a module or class list to the cache.
+
+  @param    fp      open cache file
+  @param    pList   list of modules or classes
+  @param    fLang   also write the language of each function (db file)
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdCacheWrModList(FILE *fp, const flyDocModule_t *pList, bool_t fLang)
+{
+  const flyDocModule_t  *pMod;
+  const flyDocFunc_t    *pFunc;
+
+  MdCacheWrU32(fp, (uint32_t)FlyListLen(pList));
+  for(pMod = pList; pMod; pMod = pMod->pNext)
+  {
+    MdCacheWrSection(fp, &pMod->section);
+    MdCacheWrU32(fp, (uint32_t)FlyListLen(pMod->pFuncList));
+    for(pFunc = pMod->pFuncList; pFunc; pFunc = pFunc->pNext)
+    {
+      MdCacheWrStr(fp, pFunc->szFunc);
+      MdCacheWrStr(fp, pFunc->szBrief);
+      MdCacheWrStr(fp, pFunc->szPrototype);
+      MdCacheWrStr(fp, pFunc->szText);
+      if(fLang)
+        MdCacheWrStr(fp, pFunc->szLang);
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Read a module or class list from the cache.
+
+  @param    pRd     cache reader
+  @param    szPath  source file path (for language of functions), or NULL if language was written
+  @return   list of modules or classes
+-------------------------------------------------------------------------------------------------*/
+static flyDocModule_t * MdCacheRdModList(flyDocCacheRd_t *pRd, const char *szPath)
+{
+  flyDocModule_t   *pList = NULL;
+  flyDocModule_t   *pMod;
+  flyDocFunc_t     *pFunc;
+  uint32_t          nMods;
+  uint32_t          nFuncs;
+
+  nMods = MdCacheRdU32(pRd);
+  while(pRd->fOk && nMods--)
+  {
+    pMod = FlyDocArenaAlloc(pRd->pArena, sizeof(*pMod));
+    pList = FlyListAppend(pList, pMod);
+    MdCacheRdSection(pRd, &pMod->section);
+    if(pMod->section.szTitle == NULL)
+      pRd->fOk = FALSE;
+
+    nFuncs = MdCacheRdU32(pRd);
+    while(pRd->fOk && nFuncs--)
+    {
+      pFunc = FlyDocArenaAlloc(pRd->pArena, sizeof(*pFunc));
+      pMod->pFuncList = FlyListAppend(pMod->pFuncList, pFunc);
+      pFunc->szFunc       = MdCacheRdStr(pRd);
+      pFunc->szBrief      = MdCacheRdStr(pRd);
+      pFunc->szPrototype  = MdCacheRdText(pRd);
+      pFunc->szText       = MdCacheRdText(pRd);
+      if(szPath == NULL)
+        pFunc->szLang = MdCacheRdStr(pRd);
+      else if(pFunc->szPrototype)
+        pFunc->szLang = FlyStrPathLang(szPath);
+      if(pFunc->szFunc == NULL)
+        pRd->fOk = FALSE;
+      else
+        pFunc->szRef = FlyDocRefNew(pRd->pArena, pFunc->szFunc);
+    }
+  }
+
+  return pList;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Determine the cache context. Cache files from a different context are ignored.
+
+  Besides the source file itself, parsing depends on the flydoc version and on which image files
+  are input (for warnings about missing images).
+
+  @param    pDoc    flydoc state with pImgFileList
+  @return   context hash
+-------------------------------------------------------------------------------------------------*/
+uint64_t FlyDocCacheContext(const flyDoc_t *pDoc)
+{
+  const flyDocFile_t *pImgFile;
+  const char         *szName;
+  uint64_t            hash;
+
+  hash = FlyDocHash(FLYDOC_VER_STR, sizeof(FLYDOC_VER_STR), FLYDOC_HASH_INIT);
+  for(pImgFile = pDoc->pImgFileList; pImgFile; pImgFile = pImgFile->pNext)
+  {
+    szName = FlyStrPathNameOnly(pImgFile->szPath);
+    hash = FlyDocHash(szName, strlen(szName) + 1, hash);
+  }
+
+  return hash;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Read a partial doc from a cache file in memory.
+
+  @param    pPartial    an empty partial doc with hCache and fpWarn set
+  @param    szPath      source file path
+  @param    hContents   hash of source file contents
+  @param    pData       cache file contents, or NULL
+  @param    size        size of cache file contents
+  @return   TRUE if read, FALSE if cache is out of date or not valid
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdCacheRead(flyDoc_t *pPartial, const char *szPath, uint64_t hContents, const uint8_t *pData,
+                          size_t size)
+{
+  flyDocCacheRd_t   rd;
+  flyDocImage_t    *pImage;
+  char             *szStr;
+  uint32_t          n;
+
+  memset(&rd, 0, sizeof(rd));
+  rd.p    = pData;
+  rd.pEnd = pData + (pData ? size : 0);
+  rd.pArena = &pPartial->arena;
+  rd.pDoc   = pPartial;
+  rd.fOk  = (pData && size > sizeof(m_szCacheMagic)) ? TRUE : FALSE;
+
+  // header must match exactly
+  if(rd.fOk && memcmp(rd.p, m_szCacheMagic, sizeof(m_szCacheMagic) - 1) != 0)
+    rd.fOk = FALSE;
+  rd.p += sizeof(m_szCacheMagic) - 1;
+  if(MdCacheRdU64(&rd) != pPartial->hCache || MdCacheRdU64(&rd) != hContents)
+    rd.fOk = FALSE;
+  szStr = MdCacheRdStr(&rd);
+  if(!szStr || strcmp(szStr, szPath) != 0)
+    rd.fOk = FALSE;
+
+  // partial doc
+  if(rd.fOk)
+  {
+    pPartial->nFiles        = 1;
+    pPartial->nDocComments  = MdCacheRdU32(&rd);
+    pPartial->nWarnings     = MdCacheRdU32(&rd);
+    if(MdCacheRdU32(&rd) && rd.fOk)
+    {
+      pPartial->pMainPage = FlyDocArenaAlloc(rd.pArena, sizeof(*pPartial->pMainPage));
+      MdCacheRdSection(&rd, &pPartial->pMainPage->section);
+    }
+    pPartial->pModList    = MdCacheRdModList(&rd, szPath);
+    pPartial->pClassList  = MdCacheRdModList(&rd, szPath);
+    n = MdCacheRdU32(&rd);
+    while(rd.fOk && n--)
+    {
+      pImage = FlyDocArenaAlloc(rd.pArena, sizeof(*pImage));
+      pPartial->pImageList = FlyListAppend(pPartial->pImageList, pImage);
+      pImage->szLink = MdCacheRdStr(&rd);
+      if(pImage->szLink == NULL)
+        rd.fOk = FALSE;
+    }
+    szStr = MdCacheRdStr(&rd);
+    if(rd.fOk && szStr)
+      fputs(szStr, pPartial->fpWarn);
+  }
+
+  return rd.fOk;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write a partial doc in cache file form.
+
+  @param    fp          open cache file or memory stream
+  @param    pPartial    a partial doc parsed from the source file
+  @param    szPath      source file path
+  @param    hContents   hash of source file contents
+  @param    szWarn      warnings issued while parsing the source file
+  @param    lenWarn     length of szWarn
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdCacheWrite(FILE *fp, const flyDoc_t *pPartial, const char *szPath, uint64_t hContents,
+                         const char *szWarn, size_t lenWarn)
+{
+  const flyDocImage_t  *pImage;
+
+  fwrite(m_szCacheMagic, 1, sizeof(m_szCacheMagic) - 1, fp);
+  MdCacheWrU64(fp, pPartial->hCache);
+  MdCacheWrU64(fp, hContents);
+  MdCacheWrStr(fp, szPath);
+
+  MdCacheWrU32(fp, pPartial->nDocComments);
+  MdCacheWrU32(fp, pPartial->nWarnings);
+  MdCacheWrU32(fp, pPartial->pMainPage ? 1 : 0);
+  if(pPartial->pMainPage)
+    MdCacheWrSection(fp, &pPartial->pMainPage->section);
+  MdCacheWrModList(fp, pPartial->pModList, FALSE);
+  MdCacheWrModList(fp, pPartial->pClassList, FALSE);
+  MdCacheWrU32(fp, (uint32_t)FlyListLen(pPartial->pImageList));
+  for(pImage = pPartial->pImageList; pImage; pImage = pImage->pNext)
+    MdCacheWrStr(fp, pImage->szLink);
+  MdCacheWrStrN(fp, szWarn ? szWarn : "", szWarn ? lenWarn : 0);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Read a whole binary file into memory, e.g. a cache or db file. Its size comes from the file, not
+  strlen(), as the contents have '\0' bytes.
+
+  @param    szPath    path of file to read
+  @param    pSize     returns size of file, 0 if empty or couldn't read it
+  @return   allocated file contents (free with FlyFree()), or NULL if empty or couldn't read it
+-------------------------------------------------------------------------------------------------*/
+static uint8_t * MdCacheFileRead(const char *szPath, size_t *pSize)
+{
+  uint8_t          *pData   = NULL;
+  FILE             *fp;
+  long              size    = 0;
+
+  *pSize = 0;
+  fp = fopen(szPath, "rb");
+  if(!fp)
+    return NULL;
+  if(fseek(fp, 0L, SEEK_END) == 0)
+    size = ftell(fp);
+  if(size > 0 && fseek(fp, 0L, SEEK_SET) == 0)
+  {
+    pData = FlyAlloc(size);
+    FlyDocAllocCheck(pData);
+    if(fread(pData, 1, size, fp) == (size_t)size)
+      *pSize = (size_t)size;
+    else
+    {
+      FlyFree(pData);
+      pData = NULL;
+    }
+  }
+  fclose(fp);
+
+  return pData;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Load a partial doc from the cache, if source file contents are unchanged.
+
+  On success, the cached warnings are written to pPartial->fpWarn.
+
+  On failure, pPartial may have some objects in its arena. Caller must clear them.
+
+  @param    pPartial    an empty partial doc with hCache and fpWarn set
+  @param    szPath      source file path
+  @param    hContents   hash of source file contents
+  @param    id          unique id for this file (unused on load)
+  @return   TRUE if loaded from cache, FALSE if not in cache or cache is out of date
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocCacheLoad(flyDoc_t *pPartial, const char *szPath, uint64_t hContents, unsigned id)
+{
+  char              szCache[PATH_MAX];
+  uint8_t          *pData;
+  size_t            size;
+  bool_t            fLoaded;
+
+  (void)id;
+
+  // read the whole cache file into memory
+  MdCachePath(pPartial, szCache, szPath);
+  pData = MdCacheFileRead(szCache, &size);
+  if(!pData)
+    return FALSE;
+
+  fLoaded = MdCacheRead(pPartial, szPath, hContents, pData, size);
+  FlyFreeIf(pData);
+
+  return fLoaded;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Load a partial doc from memory saved by FlyDocCacheSaveMem(). Same as FlyDocCacheLoad() otherwise.
+
+  @param    pPartial    an empty partial doc with hCache and fpWarn set
+  @param    szPath      source file path
+  @param    hContents   hash of source file contents
+  @param    pCache      partial doc in cache form
+  @param    len         length of pCache
+  @return   TRUE if loaded, FALSE if out of date
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocCacheLoadMem(flyDoc_t *pPartial, const char *szPath, uint64_t hContents, const void *pCache,
+                          size_t len)
+{
+  return MdCacheRead(pPartial, szPath, hContents, pCache, len);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Save a partial doc to the cache. Cache is best effort, so errors are silently ignored.
+
+  @param    pPartial    a partial doc parsed from the source file
+  @param    szPath      source file path
+  @param    hContents   hash of source file contents
+  @param    szWarn      warnings issued while parsing the source file
+  @param    lenWarn     length of szWarn
+  @param    id          unique id for this file (for a temporary file name)
+  @return   TRUE if saved
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocCacheSave(const flyDoc_t *pPartial, const char *szPath, uint64_t hContents,
+                       const char *szWarn, size_t lenWarn, unsigned id)
+{
+  char                  szCache[PATH_MAX];
+  char                  szTmp[PATH_MAX];
+  FILE                 *fp;
+  bool_t                fWorked;
+
+  // write to a temporary file then rename, so a cache file is always complete
+  MdCachePath(pPartial, szCache, szPath);
+  snprintf(szTmp, sizeof(szTmp), "%s.%u.tmp", szCache, id);
+  fp = fopen(szTmp, "wb");
+  if(!fp)
+    return FALSE;
+
+  MdCacheWrite(fp, pPartial, szPath, hContents, szWarn, lenWarn);
+
+  fWorked = ferror(fp) ? FALSE : TRUE;
+  if(fclose(fp) != 0)
+    fWorked = FALSE;
+  if(fWorked && rename(szTmp, szCache) != 0)
+    fWorked = FALSE;
+  if(!fWorked)
+    remove(szTmp);
+
+  return fWorked;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Save a partial doc to memory in cache form, for FlyDocCacheLoadMem(). Used by `--watch`.
+
+  @param    pPartial    a partial doc parsed from the source file
+  @param    szPath      source file path
+  @param    hContents   hash of source file contents
+  @param    szWarn      warnings issued while parsing the source file
+  @param    lenWarn     length of szWarn
+  @param    ppCache     receives partial doc in cache form, free with free()
+  @param    pLen        receives length of *ppCache
+  @return   TRUE if saved
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocCacheSaveMem(const flyDoc_t *pPartial, const char *szPath, uint64_t hContents,
+                          const char *szWarn, size_t lenWarn, void **ppCache, size_t *pLen)
+{
+  char     *pCache  = NULL;
+  size_t    len     = 0;
+  FILE     *fp;
+
+  fp = open_memstream(&pCache, &len);
+  FlyDocAllocCheck(fp);
+  MdCacheWrite(fp, pPartial, szPath, hContents, szWarn, lenWarn);
+  if(fclose(fp) != 0)
+  {
+    free(pCache);
+    return FALSE;
+  }
+
+  *ppCache = pCache;
+  *pLen    = len;
+
+  return TRUE;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write the whole parsed document to a db file for `--emit-db`, to be rendered later with
+  `--load-db`, see FlyDocDbLoad(). Lists are written in their current (sorted) order.
+
+  @param    pDoc      flydoc state after parsing (and sorting)
+  @param    szPath    path of db file to write
+  @return   TRUE if written, FALSE if couldn't create or write the file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocDbSave(const flyDoc_t *pDoc, const char *szPath)
+{
+  const flyDocMarkdown_t *pMarkdown;
+  const flyDocMdHdr_t    *pMdHdr;
+  const flyDocImage_t    *pImage;
+  const flyDocFile_t     *pImgFile;
+  FILE                   *fp;
+  bool_t                  fWorked;
+
+  fp = fopen(szPath, "wb");
+  if(!fp)
+    return FALSE;
+
+  fwrite(m_szDbMagic, 1, sizeof(m_szDbMagic) - 1, fp);
+  MdCacheWrStr(fp, FLYDOC_VER_STR);
+  MdCacheWrU32(fp, pDoc->nFiles);
+  MdCacheWrU32(fp, pDoc->nDocComments);
+
+  MdCacheWrU32(fp, pDoc->pMainPage ? 1 : 0);
+  if(pDoc->pMainPage)
+    MdCacheWrSection(fp, &pDoc->pMainPage->section);
+  MdCacheWrModList(fp, pDoc->pModList, TRUE);
+  MdCacheWrModList(fp, pDoc->pClassList, TRUE);
+
+  // markdown documents, contents are section text, see FlyDocParseMarkdownFile()
+  MdCacheWrU32(fp, (uint32_t)FlyListLen(pDoc->pMarkdownList));
+  for(pMarkdown = pDoc->pMarkdownList; pMarkdown; pMarkdown = pMarkdown->pNext)
+  {
+    MdCacheWrSection(fp, &pMarkdown->section);
+    MdCacheWrStr(fp, pMarkdown->szPath);
+    MdCacheWrU32(fp, (uint32_t)FlyListLen(pMarkdown->pHdrList));
+    for(pMdHdr = pMarkdown->pHdrList; pMdHdr; pMdHdr = pMdHdr->pNext)
+      MdCacheWrStr(fp, pMdHdr->szTitle);
+  }
+
+  // image references and the input image files they refer to
+  MdCacheWrU32(fp, (uint32_t)FlyListLen(pDoc->pImageList));
+  for(pImage = pDoc->pImageList; pImage; pImage = pImage->pNext)
+    MdCacheWrStr(fp, pImage->szLink);
+  MdCacheWrU32(fp, (uint32_t)FlyListLen(pDoc->pImgFileList));
+  for(pImgFile = pDoc->pImgFileList; pImgFile; pImgFile = pImgFile->pNext)
+  {
+    MdCacheWrStr(fp, pImgFile->szPath);
+    MdCacheWrU32(fp, pImgFile->fReferenced ? 1 : 0);
+  }
+
+  fWorked = ferror(fp) ? FALSE : TRUE;
+  if(fclose(fp) != 0)
+    fWorked = FALSE;
+
+  return fWorked;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Load a whole parsed document from a db file written by FlyDocDbSave(), in place of walking and
+  parsing the inputs. The lists and indexes of pDoc are built as if parsed, ready for
+  FlyDocWriteHtml() or FlyDocWriteMarkdown().
+
+  On failure, pDoc may have some objects in its arena, but nothing in its lists.
+
+  @param    pDoc      an empty flydoc state, see FlyDocInit()
+  @param    szPath    path of db file to read
+  @return   TRUE if loaded, FALSE if couldn't read file, or it's not a db file from this version
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocDbLoad(flyDoc_t *pDoc, const char *szPath)
+{
+  uint8_t            *pData;
+  size_t              size;
+  flyDocCacheRd_t     rd;
+  flyDocMainPage_t   *pMainPage   = NULL;
+  flyDocModule_t     *pModList    = NULL;
+  flyDocModule_t     *pClassList  = NULL;
+  flyDocModule_t     *pMod;
+  flyDocMarkdown_t   *pMarkdownList = NULL;
+  flyDocMarkdown_t   *pMarkdown;
+  flyDocMdHdr_t      *pMdHdr;
+  flyDocImage_t      *pImageList  = NULL;
+  flyDocImage_t      *pImage;
+  flyDocFile_t       *pImgFileList = NULL;
+  flyDocFile_t       *pImgFile;
+  char               *szStr;
+  unsigned            nFiles;
+  unsigned            nDocComments;
+  uint32_t            n;
+  uint32_t            nHdrs;
+
+  // the db has '\0' in it, so is read with its size, unlike a source file
+  pData = MdCacheFileRead(szPath, &size);
+  if(!pData)
+    return FALSE;
+
+  memset(&rd, 0, sizeof(rd));
+  rd.p      = pData;
+  rd.pEnd   = rd.p + size;
+  rd.pArena = &pDoc->arena;
+  rd.pDoc   = pDoc;
+  rd.fOk    = (size > sizeof(m_szDbMagic)) ? TRUE : FALSE;
+
+  // header and version must match exactly
+  if(rd.fOk && memcmp(rd.p, m_szDbMagic, sizeof(m_szDbMagic) - 1) != 0)
+    rd.fOk = FALSE;
+  rd.p += sizeof(m_szDbMagic) - 1;
+  szStr = MdCacheRdStr(&rd);
+  if(!szStr || strcmp(szStr, FLYDOC_VER_STR) != 0)
+    rd.fOk = FALSE;
+  nFiles        = MdCacheRdU32(&rd);
+  nDocComments  = MdCacheRdU32(&rd);
+
+  if(MdCacheRdU32(&rd) && rd.fOk)
+  {
+    pMainPage = FlyDocArenaAlloc(rd.pArena, sizeof(*pMainPage));
+    MdCacheRdSection(&rd, &pMainPage->section);
+  }
+  pModList    = MdCacheRdModList(&rd, NULL);
+  pClassList  = MdCacheRdModList(&rd, NULL);
+
+  n = MdCacheRdU32(&rd);
+  while(rd.fOk && n--)
+  {
+    pMarkdown = FlyDocArenaAlloc(rd.pArena, sizeof(*pMarkdown));
+    pMarkdownList = FlyListAppend(pMarkdownList, pMarkdown);
+    MdCacheRdSection(&rd, &pMarkdown->section);
+    pMarkdown->szPath = MdCacheRdStr(&rd);
+    pMarkdown->szFile = pMarkdown->section.szText;
+    if(pMarkdown->section.szTitle == NULL || (pMarkdown->szFile == NULL && pMarkdown->szPath == NULL))
+      rd.fOk = FALSE;
+    nHdrs = MdCacheRdU32(&rd);
+    while(rd.fOk && nHdrs--)
+    {
+      pMdHdr = FlyDocArenaAlloc(rd.pArena, sizeof(*pMdHdr));
+      pMdHdr->szTitle = MdCacheRdStr(&rd);
+      pMarkdown->pHdrList = FlyListAppend(pMarkdown->pHdrList, pMdHdr);
+      if(pMdHdr->szTitle == NULL)
+        rd.fOk = FALSE;
+      else
+      {
+        pMdHdr->szRef     = FlyDocRefNew(rd.pArena, pMdHdr->szTitle);
+        pMdHdr->szNbTitle = FlyDocNbNew(rd.pArena, pMdHdr->szTitle);
+      }
+    }
+  }
+
+  n = MdCacheRdU32(&rd);
+  while(rd.fOk && n--)
+  {
+    pImage = FlyDocArenaAlloc(rd.pArena, sizeof(*pImage));
+    pImageList = FlyListAppend(pImageList, pImage);
+    pImage->szLink = MdCacheRdStr(&rd);
+    if(pImage->szLink == NULL)
+      rd.fOk = FALSE;
+  }
+  n = MdCacheRdU32(&rd);
+  while(rd.fOk && n--)
+  {
+    pImgFile = FlyDocArenaAlloc(rd.pArena, sizeof(*pImgFile));
+    pImgFileList = FlyListAppend(pImgFileList, pImgFile);
+    pImgFile->szPath = MdCacheRdStr(&rd);
+    pImgFile->fReferenced = MdCacheRdU32(&rd) ? TRUE : FALSE;
+    if(pImgFile->szPath == NULL)
+      rd.fOk = FALSE;
+  }
+  FlyFree(pData);
+
+  // only a complete db file is put into pDoc, with indexes as if it were parsed
+  if(rd.fOk)
+  {
+    pDoc->nFiles        = nFiles;
+    pDoc->nDocComments  = nDocComments;
+    pDoc->pMainPage     = pMainPage;
+    pDoc->pModList      = pModList;
+    pDoc->pClassList    = pClassList;
+    pDoc->pMarkdownList = pMarkdownList;
+    pDoc->pImageList    = pImageList;
+    pDoc->pImgFileList  = pImgFileList;
+    for(pMod = pModList; pMod; pMod = pMod->pNext)
+      FlyDocIndexMod(pDoc, pMod, FALSE);
+    for(pMod = pClassList; pMod; pMod = pMod->pNext)
+      FlyDocIndexMod(pDoc, pMod, TRUE);
+    for(pMarkdown = pMarkdownList; pMarkdown; pMarkdown = pMarkdown->pNext)
+      FlyDocIndexPage(pDoc, pMarkdown->section.szTitle);
+    for(pImgFile = pImgFileList; pImgFile; pImgFile = pImgFile->pNext)
+      FlyDocIndexImgFile(pDoc, pImgFile);
+  }
+
+  return rd.fOk;
+}
@@ -0,0 +1,351 @@
+/**************************************************************************************************
+  flydoccopy.c - Copy referenced images to the output folder, see --copy
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#ifdef __linux__
+  #define _GNU_SOURCE       // copy_file_range()
+#endif
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+  #include <sys/ioctl.h>
+  #include <linux/fs.h>     // FICLONE
+#endif
+#ifdef __APPLE__
+  #include <sys/clonefile.h>
+#endif
+#include "flydoc.h"
+#include "FlyFile.h"
+#include "FlyStr.h"
+
+#define FLYDOC_COPY_THREADS   4     // copies are disk bound, so use a few threads even without -j
+
+/*!
+  @defgroup flydoc_copy   Copy referenced images to the output folder, see --copy
+
+  Images are often most of the bytes in a documentation build, so they are copied as cheaply as the
+  file system allows, on a small pool of worker threads:
+
+  1. An image already in the output folder with the same size and modified time is left alone.
+     Copies keep the modified time of the source image, so this catches every unchanged image
+  2. `--copy=link` makes a hard link, `--copy=symlink` a symbolic link, rather than a copy. If the
+     link can't be made (e.g. output is on another file system), the image is copied
+  3. A copy is a reflink (copy on write clone) where supported (Btrfs, XFS, APFS), otherwise
+     copy_file_range() on Linux, which stays in the kernel, otherwise a plain read/write loop
+
+  An existing output file is removed before it is replaced, so an old link never writes through to
+  a source image.
+*/
+
+typedef struct
+{
+  flyDoc_t       *pDoc;
+  flyDocFile_t  **apImgFiles;     // images to copy, one per job
+  bool_t         *afWorked;       // afWorked[i] is TRUE if apImgFiles[i] was copied
+} flyDocCopyJobs_t;
+
+/*!------------------------------------------------------------------------------------------------
+  Get the copy method from the `--copy=how` string.
+
+  @param    szHow     "copy", "link", "symlink" or NULL (copy)
+  @return   the method, or -1 if szHow isn't one of them
+-------------------------------------------------------------------------------------------------*/
+int FlyDocCopyHow(const char *szHow)
+{
+  if(szHow == NULL || strcmp(szHow, "copy") == 0)
+    return FLYDOC_COPY_COPY;
+  if(strcmp(szHow, "link") == 0)
+    return FLYDOC_COPY_LINK;
+  if(strcmp(szHow, "symlink") == 0)
+    return FLYDOC_COPY_SYMLINK;
+  return -1;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Do two stat results have the same modified time?
+
+  @param    pSt1      stat of 1st file
+  @param    pSt2      stat of 2nd file
+  @return   TRUE if same modified time, to the nanosecond
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdCopyMtimeSame(const struct stat *pSt1, const struct stat *pSt2)
+{
+#ifdef __APPLE__
+  return (pSt1->st_mtimespec.tv_sec == pSt2->st_mtimespec.tv_sec &&
+          pSt1->st_mtimespec.tv_nsec == pSt2->st_mtimespec.tv_nsec) ? TRUE : FALSE;
+#else
+  return (pSt1->st_mtim.tv_sec == pSt2->st_mtim.tv_sec &&
+          pSt1->st_mtim.tv_nsec == pSt2->st_mtim.tv_nsec) ? TRUE : FALSE;
+#endif
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Is szDst a symbolic link to szFull?
+
+  @param    szDst     destination path
+  @param    szFull    full path to source
+  @return   TRUE if already linked
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdCopySymlinkIs(const char *szDst, const char *szFull)
+{
+  char      szLink[PATH_MAX];
+  ssize_t   len;
+
+  len = readlink(szDst, szLink, sizeof(szLink) - 1);
+  if(len < 0)
+    return FALSE;
+  szLink[len] = '\0';
+  return strcmp(szLink, szFull) == 0 ? TRUE : FALSE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Copy the data from one open file to another: reflink, copy_file_range() or read/write.
+
+  @param    fdDst     destination, open for writing, empty
+  @param    fdSrc     source, open for reading
+  @param    size      size of source
+  @return   TRUE if worked
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdCopyData(int fdDst, int fdSrc, off_t size)
+{
+  uint8_t   aBuf[65536];
+  ssize_t   lenRead;
+  ssize_t   lenWritten;
+  off_t     done = 0;
+
+#ifdef __linux__
+  ssize_t   len;
+
+  // a reflink shares the blocks of the source, no data is copied at all
+#ifdef FICLONE
+  if(ioctl(fdDst, FICLONE, fdSrc) == 0)
+    return TRUE;
+#endif
+
+  // kernel to kernel, may also reflink or use server side copy (e.g. NFS)
+  while(done < size)
+  {
+    len = copy_file_range(fdSrc, NULL, fdDst, NULL, (size_t)(size - done), 0);
+    if(len <= 0)
+      break;
+    done += len;
+  }
+  if(done >= size)
+    return TRUE;
+  if(lseek(fdSrc, done, SEEK_SET) != done || lseek(fdDst, done, SEEK_SET) != done)
+    return FALSE;
+#endif
+
+  // plain copy
+  while((lenRead = read(fdSrc, aBuf, sizeof(aBuf))) > 0)
+  {
+    lenWritten = write(fdDst, aBuf, (size_t)lenRead);
+    if(lenWritten != lenRead)
+      return FALSE;
+    done += lenRead;
+  }
+
+  return (lenRead == 0) ? TRUE : FALSE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Copy szSrc to szDst (which doesn't exist), keeping the source modified time.
+
+  @param    szDst     destination path
+  @param    szSrc     source path
+  @param    pStSrc    stat of source
+  @return   TRUE if worked
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdCopyFile(const char *szDst, const char *szSrc, const struct stat *pStSrc)
+{
+  struct timespec   aTimes[2];
+  int               fdSrc;
+  int               fdDst;
+  bool_t            fWorked;
+
+#ifdef __APPLE__
+  // a clone keeps the source times
+  if(clonefile(szSrc, szDst, 0) == 0)
+    return TRUE;
+#endif
+
+  fdSrc = open(szSrc, O_RDONLY);
+  if(fdSrc < 0)
+    return FALSE;
+  fdDst = open(szDst, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if(fdDst < 0)
+  {
+    close(fdSrc);
+    return FALSE;
+  }
+
+  fWorked = MdCopyData(fdDst, fdSrc, pStSrc->st_size);
+
+  // keep source times, so the next build sees the same size and time and skips the copy
+#ifdef __APPLE__
+  aTimes[0] = pStSrc->st_atimespec;
+  aTimes[1] = pStSrc->st_mtimespec;
+#else
+  aTimes[0] = pStSrc->st_atim;
+  aTimes[1] = pStSrc->st_mtim;
+#endif
+  if(fWorked)
+    futimens(fdDst, aTimes);
+
+  close(fdSrc);
+  if(close(fdDst) != 0)
+    fWorked = FALSE;
+  if(!fWorked)
+    unlink(szDst);
+
+  return fWorked;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Copy a file to the output folder, with the method from `--copy`. The file is left alone (not even
+  touched) if it is already there: same size and modified time, the same file or link, or with
+  `--changed`, the same contents.
+
+  Safe to call from worker threads.
+
+  @param    pDoc      flydoc state with opts
+  @param    szDst     destination path
+  @param    szSrc     source path
+  @return   TRUE if worked (copied or unchanged), FALSE if couldn't copy file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocFileCopy(const flyDoc_t *pDoc, const char *szDst, const char *szSrc)
+{
+  struct stat   stSrc;
+  struct stat   stDst;
+  char          szFull[PATH_MAX];
+  int           how;
+  bool_t        fDst;
+
+  how = FlyDocCopyHow(pDoc->opts.szCopy);
+  if(stat(szSrc, &stSrc) != 0 || !S_ISREG(stSrc.st_mode))
+    return FALSE;
+  if(how == FLYDOC_COPY_SYMLINK && realpath(szSrc, szFull) == NULL)
+    how = FLYDOC_COPY_COPY;
+
+  // lstat() so a symbolic link is seen as a link, not the file it points to
+  fDst = (lstat(szDst, &stDst) == 0) ? TRUE : FALSE;
+  if(fDst)
+  {
+    if(S_ISDIR(stDst.st_mode))
+      return FALSE;
+    if(how == FLYDOC_COPY_SYMLINK)
+    {
+      if(S_ISLNK(stDst.st_mode) && MdCopySymlinkIs(szDst, szFull))
+        return TRUE;
+    }
+    else if(S_ISREG(stDst.st_mode))
+    {
+      if(stDst.st_dev == stSrc.st_dev && stDst.st_ino == stSrc.st_ino)
+        return TRUE;
+      if(stDst.st_size == stSrc.st_size)
+      {
+        if(MdCopyMtimeSame(&stDst, &stSrc))
+          return TRUE;
+        if(pDoc->opts.fChanged && FlyDocFilesSame(szDst, szSrc))
+          return TRUE;
+      }
+    }
+
+    // never write into an existing file, it may be a link to some other source image
+    if(unlink(szDst) != 0)
+      return FALSE;
+  }
+
+  if(how == FLYDOC_COPY_LINK && link(szSrc, szDst) == 0)
+    return TRUE;
+  if(how == FLYDOC_COPY_SYMLINK && symlink(szFull, szDst) == 0)
+    return TRUE;
+
+  return MdCopyFile(szDst, szSrc, &stSrc);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Copy one image: job i for FlyDocJobsRun(), on a worker thread.
+
+  @param    pData     ptr to flyDocCopyJobs_t
+  @param    i         which image to copy
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdCopyJob(void *pData, unsigned i)
+{
+  flyDocCopyJobs_t *pJobs = pData;
+  char              szDst[PATH_MAX];
+
+  FlyStrZCpy(szDst, pJobs->pDoc->opts.szOut, sizeof(szDst));
+  FlyStrPathAppend(szDst, FlyStrPathNameOnly(pJobs->apImgFiles[i]->szPath), sizeof(szDst));
+  pJobs->afWorked[i] = FlyDocFileCopy(pJobs->pDoc, szDst, pJobs->apImgFiles[i]->szPath);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Image i was copied: print it, in order, on the calling thread.
+
+  @param    pData     ptr to flyDocCopyJobs_t
+  @param    i         which image was copied
+  @return   TRUE to keep going
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdCopyDone(void *pData, unsigned i)
+{
+  flyDocCopyJobs_t *pJobs = pData;
+  flyDoc_t         *pDoc  = pJobs->pDoc;
+
+  FlyStrZCpy(pDoc->szPath, pDoc->opts.szOut, sizeof(pDoc->szPath));
+  FlyStrPathAppend(pDoc->szPath, FlyStrPathNameOnly(pJobs->apImgFiles[i]->szPath), sizeof(pDoc->szPath));
+  if(pDoc->opts.verbose >= FLYDOC_DEBUG_MORE)
+    printf("  Copying %s => %s\n", pJobs->apImgFiles[i]->szPath, pDoc->szPath);
+  if(!pJobs->afWorked[i])
+    FlyDocAssertMem();
+
+  return TRUE;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Copy any referenced images to ouput folder. With --watch, only images that changed since the last
+  build are copied. Images are copied on a small pool of threads, see FlyDocFileCopy().
+
+  Uses pDoc->szOutPath, pImgFileList
+
+  @param    pDoc    Filled out flyDoc_t object
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocCopyReferencedImages(flyDoc_t *pDoc)
+{
+  flyDocCopyJobs_t  jobs;
+  flyDocFile_t     *pImgFile;
+  unsigned          nImages = 0;
+  unsigned          nThreads;
+
+  memset(&jobs, 0, sizeof(jobs));
+  jobs.pDoc = pDoc;
+
+  for(pImgFile = pDoc->pImgFileList; pImgFile; pImgFile = pImgFile->pNext)
+  {
+    if(pImgFile->fReferenced)
+      ++nImages;
+  }
+  if(nImages == 0)
+    return;
+
+  // with --watch, an unchanged image is already in the output folder
+  jobs.apImgFiles = FlyDocAlloc(nImages * sizeof(*jobs.apImgFiles));
+  jobs.afWorked   = FlyDocAlloc(nImages * sizeof(*jobs.afWorked));
+  nImages = 0;
+  for(pImgFile = pDoc->pImgFileList; pImgFile; pImgFile = pImgFile->pNext)
+  {
+    if(pImgFile->fReferenced &&
+       !(pDoc->pWatch && FlyDocWatchFileSame(FlyDocWatchFile(pDoc, pImgFile->szPath))))
+      jobs.apImgFiles[nImages++] = pImgFile;
+  }
+
+  nThreads = (pDoc->opts.nJobs > FLYDOC_COPY_THREADS) ? (unsigned)pDoc->opts.nJobs : FLYDOC_COPY_THREADS;
+  FlyDocJobsRun(nThreads, nImages, MdCopyJob, MdCopyDone, &jobs);
+
+  FlyFreeIf(jobs.apImgFiles);
+  FlyFreeIf(jobs.afWorked);
+}
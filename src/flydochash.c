@@ -0,0 +1,314 @@
+/**************************************************************************************************
+  flydochash.c - Hash indexes for finding modules, classes and page names quickly
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <ctype.h>
+#include "flydoc.h"
+#include "FlyStr.h"
+
+#define FLYDOC_HASH_MIN   64      // initial # of slots in a hash table, must be power of 2
+
+/*!
+  @defgroup flydoc_hash   Hash indexes for finding modules, classes and page names quickly
+
+  The lists in flyDoc_t are in output order, which makes finding things in them slow on large
+  projects. Every @defgroup, @class, @ingroup and @inclass looks up a module or class, and every
+  new module, class or markdown document checks for a duplicate page name.
+
+  So alongside the lists, flyDoc_t has hash indexes that are kept up to date as objects are added:
+
+  1. modules by exact title
+  2. classes by exact title
+  3. page names (module, class and markdown file names without extension), case insensitive, as
+     the pages are files and some file systems aren't case sensitive
+  4. input image files by file name without path, as referenced by markdown image links
+
+  The hash tables are allocated from the arena of the flyDoc_t, like the objects they index.
+  FlyDocIndexAdd() and FlyDocIndexFind() are for other exact key tables, such as the `--watch` state
+  kept from build to build.
+*/
+
+// an entry in a hash table, key must be persistent
+typedef struct flyDocHashEntry
+{
+  const char   *szKey;      // NULL if slot is empty
+  size_t        len;        // length of key
+  uint64_t      hash;
+  void         *pValue;
+} flyDocHashEntry_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Hash a key, optionally without regard to case.
+
+  @param    szKey     key, need not be '\0' terminated
+  @param    len       length of key
+  @param    fNoCase   TRUE to ignore case
+  @return   hash of key
+-------------------------------------------------------------------------------------------------*/
+static uint64_t MdHashKey(const char *szKey, size_t len, bool_t fNoCase)
+{
+  uint64_t  hash = FLYDOC_HASH_INIT;
+  uint8_t   c;
+
+  if(!fNoCase)
+    return FlyDocHash(szKey, len, hash);
+
+  while(len--)
+  {
+    c = (uint8_t)tolower((uint8_t)*szKey++);
+    hash = FlyDocHash(&c, 1, hash);
+  }
+
+  return hash;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Find the slot for a key: either the slot with the key or the empty slot where it would go.
+
+  @param    pHash     hash table with at least one slot
+  @param    szKey     key, need not be '\0' terminated
+  @param    len       length of key
+  @param    hash      hash of key
+  @param    fNoCase   TRUE to ignore case
+  @return   ptr to slot
+-------------------------------------------------------------------------------------------------*/
+static flyDocHashEntry_t * MdHashSlot(const flyDocHash_t *pHash, const char *szKey, size_t len,
+                                      uint64_t hash, bool_t fNoCase)
+{
+  flyDocHashEntry_t  *pEntry;
+  unsigned            mask = pHash->size - 1;
+  unsigned            i;
+
+  i = (unsigned)hash & mask;
+  while(TRUE)
+  {
+    pEntry = &pHash->aEntries[i];
+    if(pEntry->szKey == NULL)
+      break;
+    if(pEntry->hash == hash && pEntry->len == len &&
+       (fNoCase ? strncasecmp(pEntry->szKey, szKey, len) : strncmp(pEntry->szKey, szKey, len)) == 0)
+      break;
+    i = (i + 1) & mask;
+  }
+
+  return pEntry;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Add a key to the hash table. If the key is already there, the original value is kept.
+
+  @param    pArena    arena to allocate table from
+  @param    pHash     hash table (may be all zero)
+  @param    szKey     persistent key, need not be '\0' terminated
+  @param    len       length of key
+  @param    pValue    value for key
+  @param    fNoCase   TRUE to ignore case
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdHashAdd(flyDocArena_t *pArena, flyDocHash_t *pHash, const char *szKey, size_t len,
+                      void *pValue, bool_t fNoCase)
+{
+  flyDocHashEntry_t  *aOld;
+  flyDocHashEntry_t  *pEntry;
+  uint64_t            hash;
+  unsigned            oldSize;
+  unsigned            i;
+
+  // keep table at most half full, grow it by rehashing
+  if((pHash->count + 1) * 2 > pHash->size)
+  {
+    aOld    = pHash->aEntries;
+    oldSize = pHash->size;
+    pHash->size     = oldSize ? oldSize * 2 : FLYDOC_HASH_MIN;
+    pHash->aEntries = FlyDocArenaAlloc(pArena, pHash->size * sizeof(*pHash->aEntries));
+    for(i = 0; i < oldSize; ++i)
+    {
+      if(aOld[i].szKey)
+        *MdHashSlot(pHash, aOld[i].szKey, aOld[i].len, aOld[i].hash, fNoCase) = aOld[i];
+    }
+  }
+
+  hash = MdHashKey(szKey, len, fNoCase);
+  pEntry = MdHashSlot(pHash, szKey, len, hash, fNoCase);
+  if(pEntry->szKey == NULL)
+  {
+    pEntry->szKey   = szKey;
+    pEntry->len     = len;
+    pEntry->hash    = hash;
+    pEntry->pValue  = pValue;
+    ++pHash->count;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Find a key in the hash table.
+
+  @param    pHash     hash table (may be all zero)
+  @param    szKey     key, need not be '\0' terminated
+  @param    len       length of key
+  @param    fNoCase   TRUE to ignore case
+  @return   ptr to entry or NULL if not found
+-------------------------------------------------------------------------------------------------*/
+static flyDocHashEntry_t * MdHashFind(const flyDocHash_t *pHash, const char *szKey, size_t len, bool_t fNoCase)
+{
+  flyDocHashEntry_t *pEntry = NULL;
+
+  if(pHash->count)
+  {
+    pEntry = MdHashSlot(pHash, szKey, len, MdHashKey(szKey, len, fNoCase), fNoCase);
+    if(pEntry->szKey == NULL)
+      pEntry = NULL;
+  }
+
+  return pEntry;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Get the page name part of a title, that is, without any file extension, e.g. "myfile.md" is
+  "myfile". Page names are compared without regard to case.
+
+  @param    szTitle   module, class or markdown title
+  @return   length of page name
+-------------------------------------------------------------------------------------------------*/
+size_t FlyDocPageNameLen(const char *szTitle)
+{
+  const char *pszExt;
+
+  pszExt = FlyStrPathExt(szTitle);
+  return pszExt ? (size_t)(pszExt - szTitle) : strlen(szTitle);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Find a module or class by exact title.
+
+  @param    pDoc      document state
+  @param    szTitle   a CName title string
+  @param    fClass    TRUE to find a class, FALSE to find a module
+  @return   ptr to module or class, or NULL if not found
+-------------------------------------------------------------------------------------------------*/
+flyDocModule_t * FlyDocModFind(const flyDoc_t *pDoc, const char *szTitle, bool_t fClass)
+{
+  flyDocHashEntry_t *pEntry;
+
+  pEntry = MdHashFind(fClass ? &pDoc->classIndex : &pDoc->modIndex, szTitle, strlen(szTitle), FALSE);
+  return pEntry ? pEntry->pValue : NULL;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Index a module or class just added to pDoc->pModList or pDoc->pClassList. Also indexes the page
+  name.
+
+  @param    pDoc      document state
+  @param    pMod      module or class with persistent title
+  @param    fClass    TRUE if a class, FALSE if a module
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocIndexMod(flyDoc_t *pDoc, flyDocModule_t *pMod, bool_t fClass)
+{
+  const char *szTitle = pMod->section.szTitle;
+
+  MdHashAdd(&pDoc->arena, fClass ? &pDoc->classIndex : &pDoc->modIndex, szTitle, strlen(szTitle), pMod, FALSE);
+  FlyDocIndexPage(pDoc, szTitle);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Index the page name of a module, class or markdown document. See FlyDocIsDup().
+
+  @param    pDoc      document state
+  @param    szTitle   persistent title, e.g. "MyModule" or "myfile.md"
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocIndexPage(flyDoc_t *pDoc, const char *szTitle)
+{
+  MdHashAdd(&pDoc->arena, &pDoc->pageIndex, szTitle, FlyDocPageNameLen(szTitle), NULL, TRUE);
+  ++pDoc->nPages;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Is there already a page with this name, ignoring case and file extension?
+
+  @param    pDoc      document state
+  @param    szTitle   title, e.g. "MyModule" or "myfile.md"
+  @return   TRUE if a page with the name exists
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocIndexHasPage(const flyDoc_t *pDoc, const char *szTitle)
+{
+  return MdHashFind(&pDoc->pageIndex, szTitle, FlyDocPageNameLen(szTitle), TRUE) ? TRUE : FALSE;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Index an input image file just added to pDoc->pImgFileList by its name without path. If more than
+  one has the same name, the 1st one is found.
+
+  @param    pDoc      document state
+  @param    pImgFile  image file with persistent path
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocIndexImgFile(flyDoc_t *pDoc, flyDocFile_t *pImgFile)
+{
+  const char *szName = FlyStrPathNameOnly(pImgFile->szPath);
+
+  MdHashAdd(&pDoc->arena, &pDoc->imgIndex, szName, strlen(szName), pImgFile, FALSE);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Find an input image file by name.
+
+  @param    pDoc      document state
+  @param    szName    file name without path, e.g. "file.png"
+  @return   ptr to image file, or NULL if not found
+-------------------------------------------------------------------------------------------------*/
+flyDocFile_t * FlyDocImgFileFind(const flyDoc_t *pDoc, const char *szName)
+{
+  flyDocHashEntry_t *pEntry;
+
+  pEntry = MdHashFind(&pDoc->imgIndex, szName, strlen(szName), FALSE);
+  return pEntry ? pEntry->pValue : NULL;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Add a key to a hash table, exact case. If the key is already there, the original value is kept.
+
+  @param    pArena    arena to allocate table from, same one each time
+  @param    pHash     hash table (may be all zero)
+  @param    szKey     persistent key
+  @param    pValue    value for key
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocIndexAdd(flyDocArena_t *pArena, flyDocHash_t *pHash, const char *szKey, void *pValue)
+{
+  MdHashAdd(pArena, pHash, szKey, strlen(szKey), pValue, FALSE);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Find a key in a hash table made with FlyDocIndexAdd().
+
+  @param    pHash     hash table (may be all zero)
+  @param    szKey     key
+  @return   value for key, or NULL if not found
+-------------------------------------------------------------------------------------------------*/
+void * FlyDocIndexFind(const flyDocHash_t *pHash, const char *szKey)
+{
+  flyDocHashEntry_t *pEntry;
+
+  pEntry = MdHashFind(pHash, szKey, strlen(szKey), FALSE);
+  return pEntry ? pEntry->pValue : NULL;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Find a key that isn't '\0' terminated, e.g. a word in text, in a hash table made with
+  FlyDocIndexAdd().
+
+  @param    pHash     hash table (may be all zero)
+  @param    szKey     key, need not be '\0' terminated
+  @param    len       length of key
+  @return   value for key, or NULL if not found
+-------------------------------------------------------------------------------------------------*/
+void * FlyDocIndexFindN(const flyDocHash_t *pHash, const char *szKey, size_t len)
+{
+  flyDocHashEntry_t *pEntry;
+
+  pEntry = MdHashFind(pHash, szKey, len, FALSE);
+  return pEntry ? pEntry->pValue : NULL;
+}
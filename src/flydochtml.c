@@ -68,6 +68,13 @@ static const char m_szTitleBarTitle[] =
   "      <h1>%s</h1>\r\n";   // title
 static const char m_szTitleBarSubtitle[] =
   "      <h3>%s</h3>\r\n";     // brief
+static const char m_szTitleBarSearch[] =  // search box, see FlyDocSearchWrite()
+  "    </div>\r\n"
+  "    <div class=\"w3-container w3-cell w3-cell-middle w3-mobile\">\r\n"
+  "      <script src=\"search.js\"></script>\r\n"
+  "      <input class=\"w3-input w3-round\" type=\"search\" placeholder=\"Search\""
+  " oninput=\"flydocSearch.find(this.value)\" onkeydown=\"flydocSearch.go(event)\">\r\n"
+  "      <div id=\"flydoc-results\" class=\"w3-white w3-text-black\"></div>\r\n";
 static const char m_szTitleBarClose[] =
   "    </div>\r\n"
   "  </div>\r\n"
@@ -141,6 +148,9 @@ static const char m_szModLeftSpacer[] =
 static const char m_szModLeftLine[] =
   "      <a href=\"%s\">%s</a><br>\r\n";  // href, pFunc->szFunc
 
+static const char m_szModLeftBreak[] =
+  "      <br>\r\n";
+
 static const char m_szModLeftBarEnd[] =
   "    </p>\r\n"
   "  </div>\r\n";
@@ -154,6 +164,9 @@ static const char m_szModRightTitle[] =
 // static const char szModRightLine[] = 
 //   "    <p>%.*s</p>\r\n";
 
+static const char m_szModRightPages[] =
+  "    <h3>%s</h3>\r\n";   // "Pages" of a split module or class
+
 static const char m_szModRightFuncHead[] =
   "    <h3 id=\"%s\" class=\"%s\">%s</h3>\r\n"  // href, color, pFunc->szFunc
   "    <p>%s</p>\r\n"   // pFunc->szBrief
@@ -175,6 +188,30 @@ static const char m_szModRightNotesOpen[] =
 // static const char szModRightNotesLine[] =
 //   "    <p>%.*s</p>\r\n";
 
+// --split: previous and next links on each page of a split module or main page
+static const char m_szPageNavOpen[] =
+  "    <p>";
+static const char m_szPageNavPrev[] =
+  "<a href=\"%s\">&laquo; Previous</a> | ";
+static const char m_szPageNavPage[] =
+  "Page %u of %u";
+static const char m_szPageNavNext[] =
+  " | <a href=\"%s\">Next &raquo;</a>";
+static const char m_szPageNavClose[] =
+  "</p>\r\n";
+
+// --split: the contents page of a split module sends Mod.html#function links on to the right page
+static const char m_szModSplitScriptOpen[] =
+  "<script>\r\n"
+  "(function() {\r\n"
+  "  var pages = {";
+static const char m_szModSplitScriptClose[] =
+  "};\r\n"
+  "  var page = pages[decodeURIComponent(location.hash.slice(1))];\r\n"
+  "  if(page) location.replace(location.pathname.replace(/\\.html$/, \"-\" + page + \".html\") + location.hash);\r\n"
+  "})();\r\n"
+  "</script>\r\n";
+
 static const char m_szModEnd[] =
   "  </div>\r\n"
   "</div>\r\n"
@@ -202,7 +239,16 @@ typedef struct
   const char *szHeading;
 } mainpageColType_t;
 
+// --split: which entries of each main page list are on this main page
+typedef struct
+{
+  unsigned    first;      // index of 1st entry on this page
+  unsigned    last;       // index after last entry on this page
+} mainpageRange_t;
+
 static const char   m_szTableOfContents[]           = "Table of Contents";
+static const char   m_szContents[]                  = "Contents";
+static const char   m_szPages[]                     = "Pages";
 static const char   m_szHeadingModulesAndClasses[]  = "Modules & Classes";
 static const char   m_szHeadingModules[]            = "Modules";
 static const char   m_szHeadingClasses[]            = "Classes";
@@ -290,9 +336,7 @@ static char * MdFontStyleAlloc(flyDoc_t *pDoc, const char *szFontBody, const cha
 -------------------------------------------------------------------------------------------------*/
 size_t FlyDocStrToRef(char *szRef, unsigned size, const char *szBase, const char *szTitle)
 {
-  const char  szHtmlExt[]  = ".html";
-  const char  szHash[]     = "#";
-  char       *pszSlug;
+  char       *pszSlug = NULL;
   size_t      len = 0;
 
   // at least one of szBase or szTitle must be defined, otherwise the id makes no sense.
@@ -300,31 +344,227 @@ size_t FlyDocStrToRef(char *szRef, unsigned size, const char *szBase, const char
 
   if(size > 1)
   {
-    if(szRef)
-      *szRef = '\0';
+    // reference has file part, lengths are kept as it goes rather than using strlen()
+    len = FlyDocRefJoin(szRef, size, szBase, szTitle ? "#" : "");
 
-    // reference has file part
-    if(szBase)
+    // reference has local part, slug goes right after the '#' if it fits
+    if(szTitle)
     {
-      if(szRef)
-      {
-        FlyStrZCat(szRef, szBase, size);
-        FlyStrZCat(szRef, szHtmlExt, size);
-      }
-      len = strlen(szBase) + strlen(szHtmlExt);
+      if(szRef && len < size - 1)
+        pszSlug = &szRef[len];
+      len += FlyUtf8SlugCpy(pszSlug, szTitle, pszSlug ? size - len : size, FlyStrLineLen(szTitle));
     }
+  }
 
-    // reference has local part
-    if(szTitle)
+  return len;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Join a page base name and a local reference already made by FlyDocStrToRef() or FlyDocRefNew(),
+  e.g. "MyModule" and "#myfunc" make "MyModule.html#myfunc". Pages and indexes linking to a
+  function or heading use its slug made at parse time, rather than making it again.
+
+  @param  szRef     buffer receive reference string, may be NULL to just get length
+  @param  size      sizeof szRef buffer
+  @param  szBase    file basename, e.g. "MyModule", or NULL if local reference only
+  @param  szLocal   local reference, e.g. "#myfunc", or NULL if file only
+  @return length of ref (even if bigger than size)
+-------------------------------------------------------------------------------------------------*/
+size_t FlyDocRefJoin(char *szRef, size_t size, const char *szBase, const char *szLocal)
+{
+  int   len;
+
+  len = snprintf(szRef, szRef ? size : 0, "%s%s%s", szBase ? szBase : "", szBase ? ".html" : "",
+                 szLocal ? szLocal : "");
+
+  return (len < 0) ? 0 : (size_t)len;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Make the local reference for a title once, e.g. "#my-heading" for "My Heading", to be kept with
+  the parsed document. Functions and headings are linked many times: from the left bar, the
+  right side, --split pages, the search index and auto-links.
+
+  @param  pArena    arena to allocate from
+  @param  szTitle   title, only up to end of line is used
+  @return local reference, persistent
+-------------------------------------------------------------------------------------------------*/
+const char * FlyDocRefNew(flyDocArena_t *pArena, const char *szTitle)
+{
+  char    *szRef;
+  size_t   size;
+
+  size = FlyDocStrToRef(NULL, UINT_MAX, NULL, szTitle) + 1;
+  szRef = FlyDocArenaAlloc(pArena, size);
+  FlyDocStrToRef(szRef, (unsigned)size, NULL, szTitle);
+
+  return szRef;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Make a copy of a title with non-breaking spaces, once, e.g. "My&nbsp;Heading". Used to prevent
+  the browser from making too narrow of a column for links. A title without spaces is used as-is.
+
+  @param  pArena    arena to allocate from
+  @param  sz        a string, persistent
+  @return string with non-breaking spaces, persistent
+-------------------------------------------------------------------------------------------------*/
+const char * FlyDocNbNew(flyDocArena_t *pArena, const char *sz)
+{
+  static const char szNbSp[] = "&nbsp;";
+  const char *psz;
+  char       *szNb;
+  char       *pszNb;
+  size_t      n = 0;
+
+  for(psz = sz; *psz; ++psz)
+  {
+    if(*psz == ' ')
+      ++n;
+  }
+  if(n == 0)
+    return sz;
+
+  szNb = FlyDocArenaAlloc(pArena, (size_t)(psz - sz) + (n * (sizeof(szNbSp) - 2)) + 1);
+  for(psz = sz, pszNb = szNb; *psz; ++psz)
+  {
+    if(*psz == ' ')
     {
-      FlyStrZCat(szRef, szHash, size);
-      len += strlen(szHash);
-      pszSlug = szRef ? szRef + strlen(szRef) : NULL;
-      len += FlyUtf8SlugCpy(pszSlug, szTitle, size, FlyStrLineLen(szTitle));
+      memcpy(pszNb, szNbSp, sizeof(szNbSp) - 1);
+      pszNb += sizeof(szNbSp) - 1;
     }
+    else
+      *pszNb++ = *psz;
   }
 
-  return len;
+  return szNb;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  With `--split=#`, how many pages of functions a module or class is split into.
+
+  @param  pDoc      flydoc state with opts.split
+  @param  nFuncs    # of functions or methods in the module or class
+  @return 0 if not split (all on one page), or # of pages of functions
+-------------------------------------------------------------------------------------------------*/
+unsigned FlyDocHtmlNumParts(const flyDoc_t *pDoc, unsigned nFuncs)
+{
+  unsigned  split = (unsigned)pDoc->opts.split;
+
+  return (split && nFuncs > split) ? (nFuncs + split - 1) / split : 0;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Name of one page of a split module, class or main page, e.g. "MyClass-2" or "index-3".
+
+  @param  szName    receives page name, without .html
+  @param  size      sizeof szName buffer
+  @param  szTitle   base name, e.g. "MyClass" or "index"
+  @param  part      page #, or 0 for szTitle itself
+  @return none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocHtmlPartName(char *szName, size_t size, const char *szTitle, unsigned part)
+{
+  if(part == 0)
+    FlyStrZCpy(szName, szTitle, size);
+  else
+    snprintf(szName, size, "%s-%u", szTitle, part);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write the previous/next links of a split module or main page.
+
+  @param  pPage     page being built
+  @param  szPrev    base name of previous page, or NULL if none
+  @param  part      this page #, 1-n
+  @param  nParts    # of pages
+  @param  szNext    base name of next page, or NULL if none
+  @return none
+-------------------------------------------------------------------------------------------------*/
+static void MdWritePageNav(flyDocPage_t *pPage, const char *szPrev, unsigned part, unsigned nParts,
+                           const char *szNext)
+{
+  char  szRef[PATH_MAX];
+
+  FlyDocPageStr(pPage, m_szPageNavOpen);
+  if(szPrev)
+  {
+    FlyDocStrToRef(szRef, sizeof(szRef), szPrev, NULL);
+    FlyDocPageTpl(pPage, m_szPageNavPrev, szRef);
+  }
+  FlyDocPageTpl(pPage, m_szPageNavPage, part, nParts);
+  if(szNext)
+  {
+    FlyDocStrToRef(szRef, sizeof(szRef), szNext, NULL);
+    FlyDocPageTpl(pPage, m_szPageNavNext, szRef);
+  }
+  FlyDocPageStr(pPage, m_szPageNavClose);
+}
+
+#define FLYDOC_HTML_EST_MIN  256       // initial room for converted HTML, see MdHtmlConvert()
+
+// markdown to HTML conversions done by MdHtmlConvert()
+typedef enum
+{
+  MD_HTML_CONTENT,
+  MD_HTML_CODEBLK,
+  MD_HTML_HEADING
+} mdHtmlConvert_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Convert one piece of markdown to HTML and append it to the page.
+
+  The conversion is done right into the end of the page buffer. The FlyMd2Html functions return
+  the full HTML length even if there isn't room for it, so in the rare case there isn't, room is
+  made and the conversion is done again.
+
+  @param  pDoc      Document state with page being written
+  @param  type      which conversion
+  @param  ppszMd    ptr to markdown, advanced past it for MD_HTML_CODEBLK, MD_HTML_HEADING
+  @param  szEnd     end of markdown for MD_HTML_CONTENT
+  @param  szArg     title for MD_HTML_CODEBLK, color for MD_HTML_HEADING
+  @return none
+-------------------------------------------------------------------------------------------------*/
+static void MdHtmlConvert(flyDoc_t *pDoc, mdHtmlConvert_t type, const char **ppszMd, const char *szEnd, const char *szArg)
+{
+  flyDocPage_t *pPage = &pDoc->page;
+  const char   *psz   = NULL;
+  char         *szHtml;
+  size_t        room;
+  size_t        len   = 0;
+  size_t        offset;
+  unsigned      i;
+
+  // HTML is usually a bit bigger than the markdown it comes from
+  room = (type == MD_HTML_CONTENT) ? 2 * (size_t)(szEnd - *ppszMd) : 0;
+  if(room < FLYDOC_HTML_EST_MIN)
+    room = FLYDOC_HTML_EST_MIN;
+
+  for(i = 0; i < 2; ++i)
+  {
+    szHtml = FlyDocPageSpace(pPage, room);
+    room   = pPage->size - pPage->len;
+    psz    = *ppszMd;
+    if(type == MD_HTML_CONTENT)
+      len = FlyMd2HtmlContent(szHtml, room, psz, szEnd);
+    else if(type == MD_HTML_CODEBLK)
+      len = FlyMd2HtmlCodeBlk(szHtml, room, &psz, szArg, NULL);
+    else
+      len = FlyMd2HtmlHeading(szHtml, room, &psz, szArg);
+    if(len < room)
+      break;
+
+    // not enough room, make enough and convert again
+    room = len;
+  }
+  offset = pPage->len;
+  pPage->len += len;
+  if(type != MD_HTML_CONTENT)
+    *ppszMd = psz;
+
+  // link mentions of functions, modules and classes (not in headings or code blocks)
+  else
+    FlyDocLinkText(pDoc, offset);
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -334,31 +574,28 @@ size_t FlyDocStrToRef(char *szRef, unsigned size, const char *szBase, const char
   2. Uses bar color for headings
   3. Does NOT find @example or # headings in code blocks
 
-  @param  pDoc        Document state with open pDoc->fpOut
+  @param  pDoc        Document state with page being written
   @param  szText      Markdown text, '\0' terminated
   @param  szW3Color   Color for headings, e.g. w3-red-text
-  @return TRUE if worked, FALSE if out of memory
+  @return none
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocHtmlWriteText(flyDoc_t *pDoc, const char *szText, const char *szW3Color)
+void FlyDocHtmlWriteText(flyDoc_t *pDoc, const char *szText, const char *szW3Color)
 {
   const char       *psz;
   const char       *szArg;
   const char       *szLine;
   const char       *szOrgLine;
   const char       *szEnd;
-  char             *szHtml;
   flyDocKeyword_t   keyword;
   char              szBuf[FLYDOC_REF_MAX];
-  size_t            len;
-  bool_t            fWorked = TRUE;
 
-  FlyAssert(pDoc && pDoc->fpOut);
+  FlyAssert(pDoc);
 
   // printf("FlyDocHtmlWriteText(szText len %zu, szW3Wcolor %s)\n", strlen(szText), szW3Color);
   // FlyStrDump(szText, strlen(szText));
 
   szLine = szText;
-  while(fWorked && *szLine)
+  while(*szLine)
   {
     // debugging (make sure line advances)
     szOrgLine = szLine;
@@ -384,25 +621,8 @@ bool_t FlyDocHtmlWriteText(flyDoc_t *pDoc, const char *szText, const char *szW3C
     if(szEnd > szLine)
     {
 
-      len = FlyMd2HtmlContent(NULL, SIZE_MAX, szLine, szEnd);
-
-      // if(len == 0)
-      //   printf("Empty Content at line %u\n", FlyStrLinePos(szText, szLine, NULL));
-
-      // only blank lines until next "thing", just use an empty paragraph
-      if(len)
-      {
-        szHtml = FlyDocAlloc(len + 1);
-// printf("Content at line %u, %.*s, szLine %p, szEnd %p, HTML len %zu\n", 
-//   FlyStrLinePos(szText, szLine, NULL), (int)FlyStrLineLen(szLine), szLine, szLine, szEnd, len);
-
-        FlyMd2HtmlContent(szHtml, len + 1, szLine, szEnd);
-
-// printf("Done Content at line %u\n", FlyStrLinePos(szText, szLine, NULL));
-        if(fwrite(szHtml, 1, strlen(szHtml), pDoc->fpOut) <= 0)
-          fWorked = FALSE;
-        FlyFree(szHtml);
-      }
+      // only blank lines until next "thing" converts to nothing
+      MdHtmlConvert(pDoc, MD_HTML_CONTENT, &szLine, szEnd, NULL);
       szLine = szEnd;
       continue;
     }
@@ -421,13 +641,7 @@ bool_t FlyDocHtmlWriteText(flyDoc_t *pDoc, const char *szText, const char *szW3C
         {
           FlyStrZCpy(szBuf, "Example: ", sizeof(szBuf));
           FlyStrZNCat(szBuf, szArg, sizeof(szBuf), FlyStrLineLen(szArg));
-          psz = szLine;
-          len = FlyMd2HtmlCodeBlk(NULL, SIZE_MAX, &psz, szBuf, NULL);
-          szHtml = FlyDocAlloc(len + 1);
-          FlyMd2HtmlCodeBlk(szHtml, len + 1, &szLine, szBuf, NULL);
-          if(fwrite(szHtml, 1, strlen(szHtml), pDoc->fpOut) <= 0)
-            fWorked = FALSE;
-          FlyFree(szHtml);
+          MdHtmlConvert(pDoc, MD_HTML_CODEBLK, &szLine, NULL, szBuf);
         }
 
         // no code block following example, just make it a level 5 heading
@@ -436,13 +650,7 @@ bool_t FlyDocHtmlWriteText(flyDoc_t *pDoc, const char *szText, const char *szW3C
           FlyStrZCpy(szBuf, "##### ", sizeof(szBuf));
           FlyStrZCat(szBuf, szArg, sizeof(szBuf));
           psz = szBuf;
-          len = FlyMd2HtmlHeading(NULL, SIZE_MAX, &psz, NULL);
-          szHtml = FlyDocAlloc(len + 1);
-          psz = szBuf;
-          FlyMd2HtmlHeading(szHtml, len + 1, &psz, NULL);
-          if(fwrite(szHtml, 1, strlen(szHtml), pDoc->fpOut) <= 0)
-            fWorked = FALSE;
-          FlyFree(szHtml);
+          MdHtmlConvert(pDoc, MD_HTML_HEADING, &psz, NULL, NULL);
         }
         continue;
       }
@@ -455,20 +663,12 @@ bool_t FlyDocHtmlWriteText(flyDoc_t *pDoc, const char *szText, const char *szW3C
     // headings are in the bar color
     else if(FlyMd2HtmlIsHeading(szLine, NULL))
     {
-      psz = szLine;
-      len = FlyMd2HtmlHeading(NULL, SIZE_MAX, &psz, szW3Color);
-      szHtml = FlyDocAlloc(len + 1);
-      FlyMd2HtmlHeading(szHtml, len + 1, &szLine, szW3Color);
-      if(fwrite(szHtml, 1, strlen(szHtml), pDoc->fpOut) <= 0)
-        fWorked = FALSE;
-      FlyFree(szHtml);
+      MdHtmlConvert(pDoc, MD_HTML_HEADING, &szLine, NULL, szW3Color);
     }
 
     // should NEVER get stuck (line should keep advancing)
     FlyAssert(szLine > szOrgLine);
   }
-
-  return fWorked;
 }
 
 /*!-------------------------------------------------------------------------------------------------
@@ -483,16 +683,17 @@ bool_t FlyDocHtmlWriteText(flyDoc_t *pDoc, const char *szText, const char *szW3C
   MyClassFoo               | out_folder/MyClassFoo.html
   bar_module               | out_folder/bar_module.html
 
+  The page is built in pDoc->page, then written by FlyDocHtmlPageWrite().
+
   @param  pDoc      flydoc state
   @param  szPath    markdown file, module, class or index (MainPage)
-  @return FILE * if worked, NULL if not.
+  @return none
 -------------------------------------------------------------------------------------------------*/
-FILE * FlyDocCreateHtmlFile(flyDoc_t *pDoc, const char *szPath)
+void FlyDocHtmlPageNew(flyDoc_t *pDoc, const char *szPath)
 {
   const char  szHtmlExt[] = ".html";
   const char *szBaseName;
   unsigned    len;
-  FILE       *fp          = NULL;
 
   // get filename to display, short form, e.g. ~/folder/file.html
   FlyStrZCpy(pDoc->szPath, pDoc->opts.szOut, sizeof(pDoc->szPath));
@@ -504,11 +705,23 @@ FILE * FlyDocCreateHtmlFile(flyDoc_t *pDoc, const char *szPath)
   if(pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
     printf("  %s\n", pDoc->szPath);
 
-  // create a file for writing (higher layer will issue a warning)
-  if(!pDoc->opts.fNoBuild)
-    fp = fopen(pDoc->szPath, "w");
+  pDoc->page.len = 0;
+  if(pDoc->opts.fProfile)
+    pDoc->page.nsStart = FlyDocProfNow();
+}
+
+/*!-------------------------------------------------------------------------------------------------
+  Write the HTML page started by FlyDocHtmlPageNew() to its file in one go.
+
+  With `--changed`, the file is only written if different from the one already in the output
+  folder.
 
-  return fp;
+  @param  pDoc      flydoc state with pDoc->szPath and pDoc->page
+  @return TRUE if worked, FALSE if couldn't write file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocHtmlPageWrite(flyDoc_t *pDoc)
+{
+  return FlyDocPageWrite(pDoc, &pDoc->page, pDoc->szPath);
 }
 
 /*!-------------------------------------------------------------------------------------------------
@@ -569,12 +782,12 @@ char * FDocAllocImageWithRef(const char *szMdImage, const char *szRef)
   @param  pStyle    page style: @color, @font, @logo, @version, etc...
   @return none
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocHtmlWriteOpen(flyDoc_t *pDoc, const flyDocSection_t *pSection, const flyDocStyle_t *pStyle)
+void FlyDocHtmlWriteOpen(flyDoc_t *pDoc, const flyDocSection_t *pSection, const flyDocStyle_t *pStyle)
 {
+  flyDocPage_t *pPage = &pDoc->page;
   const char   *szTitleColor; 
   char         *szHtml;
   bool_t        fIsMainPage = FALSE;
-  bool_t        fWorked     = TRUE;
 
   // some things are different for main page
   if(pDoc->pMainPage && pSection == &pDoc->pMainPage->section)
@@ -586,75 +799,51 @@ bool_t FlyDocHtmlWriteOpen(flyDoc_t *pDoc, const flyDocSection_t *pSection, cons
     szTitleColor = pStyle->szTitleColor;
 
   // write <head> section, which may include special fonts
-  FlyAssert(FlyStrCount(m_szHtmlHead, "%s") == 3);
   szHtml = MdFontStyleAlloc(pDoc, pStyle->szFontBody, pStyle->szFontHeadings);
   FlyDocAllocCheck(szHtml);
-  if(fWorked && fprintf(pDoc->fpOut, m_szHtmlHead, pSection->szTitle, pDoc->opts.fLocal ? "" : szW3CssPath, szHtml) <= 0)
-    fWorked = FALSE;
+  FlyDocPageTpl(pPage, m_szHtmlHead, pSection->szTitle, pDoc->opts.fLocal ? "" : szW3CssPath, szHtml);
   FlyFreeIf(szHtml);
 
   // write title bar and logo
-  if(fWorked)
-  {
-    FlyAssert(pStyle->szLogo);
-    szHtml = FDocAllocImageWithRef(pStyle->szLogo, fIsMainPage ? NULL : "index.html");
-    FlyDocAllocCheck(szHtml);
-    FlyAssert(FlyStrCount(m_szTitleBarOpen, "%s") == 2);
-    if(fprintf(pDoc->fpOut, m_szTitleBarOpen, szTitleColor, szHtml) <= 0)
-      fWorked = FALSE;
-    FlyFree(szHtml);
-  }
+  FlyAssert(pStyle->szLogo);
+  szHtml = FDocAllocImageWithRef(pStyle->szLogo, fIsMainPage ? NULL : "index.html");
+  FlyDocAllocCheck(szHtml);
+  FlyDocPageTpl(pPage, m_szTitleBarOpen, szTitleColor, szHtml);
+  FlyFree(szHtml);
 
   // optional version goes below logo in same column
-  if(fWorked && pStyle->szVersion && strlen(pStyle->szVersion))
-  {
-    FlyAssert(FlyStrCount(m_szTitleBarVersion, "%s") == 1);
-    if(fprintf(pDoc->fpOut, m_szTitleBarVersion, pStyle->szVersion) <= 0)
-      fWorked = FALSE;
-  }
+  if(pStyle->szVersion && strlen(pStyle->szVersion))
+    FlyDocPageTpl(pPage, m_szTitleBarVersion, pStyle->szVersion);
 
   // close logo column, open a new column and write title heading
-  if(fWorked)
-  {
-    FlyAssert(FlyStrCount(m_szTitleBarTitle, "%s") == 1);
-    if(fprintf(pDoc->fpOut, m_szTitleBarTitle, pSection->szTitle) <= 0)
-      fWorked = FALSE;
-  }
+  FlyDocPageTpl(pPage, m_szTitleBarTitle, pSection->szTitle);
 
   // write optional subtitle, but only for mainpage
-  if(fWorked && pSection->szSubtitle)
-  {
-    FlyAssert(FlyStrCount(m_szTitleBarSubtitle, "%s") == 1);
-    if(fprintf(pDoc->fpOut, m_szTitleBarSubtitle, pSection->szSubtitle) <= 0)
-      fWorked = FALSE;
-  }
+  if(pSection->szSubtitle)
+    FlyDocPageTpl(pPage, m_szTitleBarSubtitle, pSection->szSubtitle);
 
-  if(fWorked)
-  {
-    FlyAssert(FlyStrCount(m_szTitleBarClose, "%s") == 0);
-    if(fprintf(pDoc->fpOut, m_szTitleBarClose) <= 0)
-      fWorked = FALSE;
-  }
+  // search box in its own column
+  if(!pDoc->opts.fNoSearch)
+    FlyDocPageStr(pPage, m_szTitleBarSearch);
 
-  return fWorked;
+  FlyDocPageStr(pPage, m_szTitleBarClose);
 }
 
 /*!-------------------------------------------------------------------------------------------------
-  Write each module into the cell content for this list. File is already open in pDoc->fpOut.
+  Write each module into the cell content for this list. Page is already started in pDoc->page.
 
-  @param    pDoc    flydoc state
-  @param    
-  @return TRUE if worked, FALSE if problem writing to file
+  @param    pDoc      flydoc state
+  @param    pModList  list of modules or classes
+  @param    pRange    which modules or classes are on this main page
+  @return   none
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocHtmlWriteMainModList(flyDoc_t *pDoc, flyDocModule_t *pModList)
+void FlyDocHtmlWriteMainModList(flyDoc_t *pDoc, flyDocModule_t *pModList, const mainpageRange_t *pRange)
 {
   char              szRef[FLYDOC_REF_MAX];
   flyDocModule_t   *pMod;
   const char        *szHeading;
-  bool_t            fWorked = TRUE;
   unsigned          nMods;
-
-  FlyAssert(pDoc && pDoc->fpOut);
+  unsigned          i;
 
   nMods = FlyListLen(pModList);
   if(nMods)
@@ -665,28 +854,23 @@ bool_t FlyDocHtmlWriteMainModList(flyDoc_t *pDoc, flyDocModule_t *pModList)
       szHeading = (nMods == 1) ? m_szHeadingModuleSingular : m_szHeadingModules;
 
     // small heading for objects
-    if(fprintf(pDoc->fpOut, m_szMainColObjects, nMods, szHeading) <= 0)
-      fWorked = FALSE;
+    FlyDocPageTpl(&pDoc->page, m_szMainColObjects, nMods, szHeading);
 
     // write a link to each class or module
     pMod = pModList;
-    while(fWorked && pMod)
+    for(i = 0; pMod && i < pRange->last; ++i)
     {
       // create reference
-      FlyDocStrToRef(szRef, sizeof(szRef), pMod->section.szTitle, NULL);
-
-      // "<p><a href=\"%s.html\">%s</a> - %s</p>";
-      FlyAssert(FlyStrCount(m_szMainColRefLine, "%s") == 3);
-      if(fprintf(pDoc->fpOut, m_szMainColRefLine, szRef, pMod->section.szTitle,
-                 pMod->section.szSubtitle ? pMod->section.szSubtitle : "") <= 0)
+      if(i >= pRange->first)
       {
-        fWorked = FALSE;
+        FlyDocStrToRef(szRef, sizeof(szRef), pMod->section.szTitle, NULL);
+
+        // "<p><a href=\"%s.html\">%s</a> - %s</p>";
+        FlyDocPageTpl(&pDoc->page, m_szMainColRefLine, szRef, pMod->section.szTitle, pMod->section.szSubtitle);
       }
       pMod = pMod->pNext;
     }
   }
-
-  return fWorked;
 }
 
 /*!-------------------------------------------------------------------------------------------------
@@ -707,19 +891,24 @@ bool_t FlyDocHtmlWriteMainModList(flyDoc_t *pDoc, flyDocModule_t *pModList)
   @param    szRefBase       Reference base, e.g. "MyModule.html", "markdown.html" or NULL
   @param    pSection        Section containing example list
   @param    szTItlePrefix   e.g. "Module" so we an print the title :
-  @return   TRUE if worked, FALSE if there is a problem with writing to file
+  @param    pRange          which examples are on this main page
+  @param    pIndex          index of 1st example in this section, updated to be after the last
+  @return   none
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocHtmlWriteExampleList(flyDoc_t *pDoc, const char *szRefBase, flyDocSection_t *pSection, const char *szTitlePrefix)
+void FlyDocHtmlWriteExampleList(flyDoc_t *pDoc, const char *szRefBase, flyDocSection_t *pSection, const char *szTitlePrefix,
+                                const mainpageRange_t *pRange, unsigned *pIndex)
 {
   char              szRef[FLYDOC_REF_MAX];
   flyDocExample_t  *pExample;
-  unsigned          nExamples;
   bool_t            fIsMainPage;
-  bool_t            fWorked = TRUE;
+  unsigned          i;
+  unsigned          nExamples;
 
-  // ignore empty example lists
+  // ignore empty example lists, or lists not on this main page
+  i = *pIndex;
   nExamples = FlyListLen(pSection->pExampleList);
-  if(nExamples)
+  *pIndex += nExamples;
+  if(nExamples && i < pRange->last && i + nExamples > pRange->first)
   {
     fIsMainPage = (pDoc->pMainPage && pSection == &pDoc->pMainPage->section) ? TRUE : FALSE;
 
@@ -728,25 +917,22 @@ bool_t FlyDocHtmlWriteExampleList(flyDoc_t *pDoc, const char *szRefBase, flyDocS
     FlyStrZCat(szRef, " ", sizeof(szRef));
     if(!fIsMainPage)
       FlyStrZCat(szRef, pSection->szTitle, sizeof(szRef));
-    FlyAssert(FlyStrCount(m_szMainColExampleGroup, "%s") == 1);
-    if(fprintf(pDoc->fpOut, m_szMainColExampleGroup, szRef) <= 0)
-      fWorked = FALSE;
+    FlyDocPageTpl(&pDoc->page, m_szMainColExampleGroup, szRef);
 
     pExample = pSection->pExampleList;
-    while(fWorked && pExample)
+    for( ; pExample && i < pRange->last; ++i)
     {
       // create reference
-      FlyDocStrToRef(szRef, sizeof(szRef), szRefBase, pExample->szTitle);
-  
-      // "<p>Example: <a href=\"%s\">%s</a></p>\r\n";
-      FlyAssert(FlyStrCount(m_szMainColExampleLine, "%s") == 2);
-      if(fprintf(pDoc->fpOut, m_szMainColExampleLine, szRef, pExample->szTitle) <= 0)
-        fWorked = FALSE;
+      if(i >= pRange->first)
+      {
+        FlyDocStrToRef(szRef, sizeof(szRef), szRefBase, pExample->szTitle);
+
+        // "<p>Example: <a href=\"%s\">%s</a></p>\r\n";
+        FlyDocPageTpl(&pDoc->page, m_szMainColExampleLine, szRef, pExample->szTitle);
+      }
       pExample = pExample->pNext;
     }
   }
-
-  return fWorked;
 }
 
 /*!-------------------------------------------------------------------------------------------------
@@ -757,56 +943,42 @@ bool_t FlyDocHtmlWriteExampleList(flyDoc_t *pDoc, const char *szRefBase, flyDocS
   Examples might be found in modules, classes and markdown documents.
 
   @pDoc         Document state
-  @return       TRUE if worked, FALSE if there is a problem with writing to file
+  @pRange       which examples are on this main page
+  @return       none
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocHtmlWriteMainExamplesAll(flyDoc_t *pDoc)
+void FlyDocHtmlWriteMainExamplesAll(flyDoc_t *pDoc, const mainpageRange_t *pRange)
 {
   flyDocModule_t   *pMod;       // modules or classes may have examples
   flyDocMarkdown_t *pDocument;  // markdown documents can have examples too
   const char       *szHeading;
   char              szNameBase[FLYDOC_REF_MAX];
-  bool_t            fWorked = TRUE;
-
-  FlyAssert(pDoc && pDoc->fpOut);
+  unsigned          i = 0;
 
   if(pDoc->nExamples)
   {
     // small heading for objects
     szHeading = (pDoc->nExamples == 1) ? m_szHeadingExampleSingular : m_szHeadingExamples;
-    if(fprintf(pDoc->fpOut, m_szMainColObjects, pDoc->nExamples, szHeading) <= 0)
-      fWorked = FALSE;
+    FlyDocPageTpl(&pDoc->page, m_szMainColObjects, pDoc->nExamples, szHeading);
 
     // mainpage examples
-    if(fWorked && pDoc->pMainPage)
-      fWorked = FlyDocHtmlWriteExampleList(pDoc, NULL, &pDoc->pMainPage->section, "Main Page");
+    if(pDoc->pMainPage)
+      FlyDocHtmlWriteExampleList(pDoc, NULL, &pDoc->pMainPage->section, "Main Page", pRange, &i);
 
     // modules
-    pMod = pDoc->pModList;
-    while(fWorked && pMod)
-    {
-      fWorked = FlyDocHtmlWriteExampleList(pDoc, pMod->section.szTitle, &pMod->section, "Module");
-      pMod = pMod->pNext;
-    }
+    for(pMod = pDoc->pModList; pMod; pMod = pMod->pNext)
+      FlyDocHtmlWriteExampleList(pDoc, pMod->section.szTitle, &pMod->section, "Module", pRange, &i);
 
     // classes
-    pMod = pDoc->pClassList;
-    while(fWorked && pMod)
-    {
-      fWorked = FlyDocHtmlWriteExampleList(pDoc, pMod->section.szTitle, &pMod->section, "Class");
-      pMod = pMod->pNext;
-    }
+    for(pMod = pDoc->pClassList; pMod; pMod = pMod->pNext)
+      FlyDocHtmlWriteExampleList(pDoc, pMod->section.szTitle, &pMod->section, "Class", pRange, &i);
 
     // Markdown documents may have examples
-    pDocument = pDoc->pMarkdownList;
-    while(fWorked && pDocument)
+    for(pDocument = pDoc->pMarkdownList; pDocument; pDocument = pDocument->pNext)
     {
       FlyDocMakeNameBase(szNameBase, pDocument->section.szTitle, sizeof(szNameBase));
-      fWorked = FlyDocHtmlWriteExampleList(pDoc, szNameBase, &pDocument->section, "Document");
-      pDocument = pDocument->pNext;
+      FlyDocHtmlWriteExampleList(pDoc, szNameBase, &pDocument->section, "Document", pRange, &i);
     }
   }
-
-  return fWorked;
 }
 
 /*!-------------------------------------------------------------------------------------------------
@@ -816,45 +988,36 @@ bool_t FlyDocHtmlWriteMainExamplesAll(flyDoc_t *pDoc)
 
   @param    pDoc            Document context
   @param    pMarkdownList   List of markdown files (may be NULL)
+  @param    pRange          which documents are on this main page
   @return   none
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocHtmlWriteMainDocList(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdownList)
+void FlyDocHtmlWriteMainDocList(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdownList, const mainpageRange_t *pRange)
 {
   flyDocMarkdown_t *pDocument;
   char              szRef[FLYDOC_REF_MAX];
   char              szNameBase[FLYDOC_REF_MAX];
   const char       *szHeading;
   unsigned          nDocs;
-  bool_t            fWorked = TRUE;
-
-  FlyAssert(pDoc && pDoc->fpOut);
+  unsigned          i;
 
   nDocs = FlyListLen(pMarkdownList);
   szHeading = (nDocs == 1) ? m_szHeadingDocumentSingular : m_szHeadingDocuments;
 
   // small heading for objects
-  FlyAssert(FlyStrCount(m_szMainColObjects, "%u") == 1);
-  FlyAssert(FlyStrCount(m_szMainColObjects, "%s") == 1);
-  if(fprintf(pDoc->fpOut, m_szMainColObjects, nDocs, szHeading) <= 0)
-    fWorked = FALSE;
+  FlyDocPageTpl(&pDoc->page, m_szMainColObjects, nDocs, szHeading);
 
   pDocument = pMarkdownList;
-  while(pDocument)
+  for(i = 0; pDocument && i < pRange->last; ++i)
   {
     // make reference to markdown file
-    FlyDocMakeNameBase(szNameBase, pDocument->section.szTitle, sizeof(szNameBase));
-    FlyDocStrToRef(szRef, sizeof(szRef), szNameBase, NULL);
-
-    FlyAssert(FlyStrCount(m_szMainColRefLine, "%s") == 3);
-    if(fprintf(pDoc->fpOut, m_szMainColRefLine, szRef, pDocument->section.szTitle,
-               pDocument->section.szSubtitle ? pDocument->section.szSubtitle : "") <= 0)
+    if(i >= pRange->first)
     {
-      fWorked = FALSE;
+      FlyDocMakeNameBase(szNameBase, pDocument->section.szTitle, sizeof(szNameBase));
+      FlyDocStrToRef(szRef, sizeof(szRef), szNameBase, NULL);
+      FlyDocPageTpl(&pDoc->page, m_szMainColRefLine, szRef, pDocument->section.szTitle, pDocument->section.szSubtitle);
     }
     pDocument = pDocument->pNext;
   }
-
-  return fWorked;
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -912,6 +1075,129 @@ unsigned FlyDocHtmlMainPageCols(flyDoc_t *pDoc, mainpageColType_t *aColTypes)
   return nCols;
 }
 
+/*-------------------------------------------------------------------------------------------------
+  Add a string to the hash of a page's inputs. NULL and "" hash differently.
+
+  @param  hash    hash so far
+  @param  sz      string or NULL
+  @return new hash
+-------------------------------------------------------------------------------------------------*/
+static uint64_t MdInputsStr(uint64_t hash, const char *sz)
+{
+  return sz ? FlyDocHash(sz, strlen(sz) + 1, hash) : FlyDocHash("", 0, hash ^ 1);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Add a section's title, subtitle and examples to the hash of a page's inputs. These are what the
+  main page shows of each module, class and document.
+
+  @param  hash      hash so far
+  @param  pSection  section
+  @return new hash
+-------------------------------------------------------------------------------------------------*/
+static uint64_t MdInputsListed(uint64_t hash, const flyDocSection_t *pSection)
+{
+  const flyDocExample_t *pExample;
+
+  hash = MdInputsStr(hash, pSection->szTitle);
+  hash = MdInputsStr(hash, pSection->szSubtitle);
+  for(pExample = pSection->pExampleList; pExample; pExample = pExample->pNext)
+    hash = MdInputsStr(hash, pExample->szTitle);
+
+  return MdInputsStr(hash, NULL);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Hash what every page is made from: its section text and its style (which may come from the
+  main page). See FlyDocWatchPageSame().
+
+  @param  pDoc      flydoc state
+  @param  pSection  section of the page
+  @return hash of section and style
+-------------------------------------------------------------------------------------------------*/
+static uint64_t MdInputsSection(flyDoc_t *pDoc, flyDocSection_t *pSection)
+{
+  flyDocStyle_t   style;
+  uint64_t        hash;
+
+  FlyDocStyleGet(pDoc, pSection, &style);
+  hash = MdInputsListed(FLYDOC_HASH_INIT, pSection);
+  hash = MdInputsStr(hash, pSection->szText);
+  hash = MdInputsStr(hash, style.szBarColor);
+  hash = MdInputsStr(hash, style.szTitleColor);
+  hash = MdInputsStr(hash, style.szHeadingColor);
+  hash = MdInputsStr(hash, style.szFontBody);
+  hash = MdInputsStr(hash, style.szFontHeadings);
+  hash = MdInputsStr(hash, style.szLogo);
+  hash = MdInputsStr(hash, style.szVersion);
+  hash = FlyDocHash(&pDoc->hLinks, sizeof(pDoc->hLinks), hash);
+
+  return FlyDocHash(&pDoc->opts.fLocal, sizeof(pDoc->opts.fLocal), hash);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Hash what the main page is made from: its own section, and the titles, subtitles and examples of
+  every module, class and document (see FlyDocHtmlWriteMainModList(),
+  FlyDocHtmlWriteMainExamplesAll() and FlyDocHtmlWriteMainDocList()).
+
+  @param  pDoc      flydoc state with pMainPage
+  @return hash of main page inputs
+-------------------------------------------------------------------------------------------------*/
+static uint64_t MdInputsMainPage(flyDoc_t *pDoc)
+{
+  const flyDocModule_t   *pMod;
+  const flyDocMarkdown_t *pMarkdown;
+  uint64_t                hash;
+  unsigned                i;
+
+  hash = MdInputsSection(pDoc, &pDoc->pMainPage->section);
+  for(i = 0; i < 2; ++i)
+  {
+    for(pMod = i ? pDoc->pClassList : pDoc->pModList; pMod; pMod = pMod->pNext)
+      hash = MdInputsListed(hash, &pMod->section);
+    hash = MdInputsStr(hash, NULL);
+  }
+  for(pMarkdown = pDoc->pMarkdownList; pMarkdown; pMarkdown = pMarkdown->pNext)
+    hash = MdInputsListed(hash, &pMarkdown->section);
+
+  return hash;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Hash what a module, class or markdown page is made from.
+
+  @param  pDoc        flydoc state
+  @param  pMod        module or class, or NULL if markdown
+  @param  pMarkdown   markdown document if pMod is NULL
+  @return hash of page inputs
+-------------------------------------------------------------------------------------------------*/
+static uint64_t MdInputsPage(flyDoc_t *pDoc, flyDocModule_t *pMod, flyDocMarkdown_t *pMarkdown)
+{
+  const flyDocFunc_t   *pFunc;
+  const flyDocMdHdr_t  *pMdHdr;
+  uint64_t              hash;
+
+  if(pMod)
+  {
+    hash = MdInputsSection(pDoc, &pMod->section);
+    for(pFunc = pMod->pFuncList; pFunc; pFunc = pFunc->pNext)
+    {
+      hash = MdInputsStr(hash, pFunc->szFunc);
+      hash = MdInputsStr(hash, pFunc->szBrief);
+      hash = MdInputsStr(hash, pFunc->szPrototype);
+      hash = MdInputsStr(hash, pFunc->szText);
+    }
+  }
+  else
+  {
+    hash = MdInputsSection(pDoc, &pMarkdown->section);
+    for(pMdHdr = pMarkdown->pHdrList; pMdHdr; pMdHdr = pMdHdr->pNext)
+      hash = FlyDocHash(pMdHdr->szTitle, FlyStrLineLen(pMdHdr->szTitle) + 1, hash);
+  }
+
+  return hash;
+}
+
 /*!------------------------------------------------------------------------------------------------
   Write the pDoc mainpage to index.html
 
@@ -925,128 +1211,322 @@ unsigned FlyDocHtmlMainPageCols(flyDoc_t *pDoc, mainpageColType_t *aColTypes)
       |        |          |        |
       +-------+--------------------+
 
+  With `--split=#`, each list shows at most # entries per page, so a long list goes on over
+  index-2.html, index-3.html, etc., with links to the previous and next page. The main page text
+  is only on index.html.
+
   @param  pDoc    document context
   @return TRUE if worked, FALSE if couldn't create folder, files or allocate memory
 -------------------------------------------------------------------------------------------------*/
 bool_t FlyDocHtmlWriteMainPage(flyDoc_t *pDoc)
 {
+  flyDocPage_t       *pPage = &pDoc->page;
   flyDocMainPage_t   *pMainPage;
   flyDocStyle_t       style;
   unsigned            nPages;
-  bool_t              fWorked = TRUE;
   mainpageColType_t   aColTypes[3];
+  mainpageRange_t     range;
+  char                szName[FLYDOC_REF_MAX];
+  char                szPrev[FLYDOC_REF_MAX];
+  char                szNext[FLYDOC_REF_MAX];
+  unsigned            split;
+  unsigned            nParts;
+  unsigned            part;
   unsigned            nCols;
   unsigned            i;
+  bool_t              fWorked = TRUE;
 
   // don't make a maain page if only one HTML page: a single doc, module or class
   nPages = pDoc->nModules + pDoc->nClasses + pDoc->nDocuments;
   if((pDoc->pMainPage == NULL) && (nPages == 1))
-    return fWorked;
+    return TRUE;
 
   // generate pseudo mainpage if multiple modules/classes/docs but no actual mainpage
   if(pDoc->pMainPage == NULL)
   {
-    pMainPage = FlyDocAlloc(sizeof(*pDoc->pMainPage));
-    memset(pMainPage, 0, sizeof(*pDoc->pMainPage));
+    pMainPage = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pDoc->pMainPage));
     pDoc->pMainPage = pMainPage;
   }
 
   // mainpage MUST have a title, so use "Table of Contents"
-  if(fWorked)
-  {
-    pMainPage = pDoc->pMainPage;
-    if(pMainPage->section.szTitle == NULL)
-    {
-      pMainPage->section.szTitle = FlyStrClone(m_szTableOfContents);
-      FlyDocAllocCheck(pMainPage->section.szTitle);
-    }
-  }
-
-  // create the HTML file
-  if(fWorked)
+  pMainPage = pDoc->pMainPage;
+  if(pMainPage->section.szTitle == NULL)
+    pMainPage->section.szTitle = FlyDocArenaStrClone(&pDoc->arena, m_szTableOfContents);
+
+  // --watch: no names or examples changed, so neither has the main page
+  if(pDoc->pWatch && FlyDocWatchPageSame(pDoc, "index", MdInputsMainPage(pDoc)))
+    return TRUE;
+
+  // --split: enough main pages for the longest list
+  split  = (unsigned)pDoc->opts.split;
+  nParts = 1;
+  if(split)
   {
-    pDoc->fpOut = FlyDocCreateHtmlFile(pDoc, "index");
-    if(!pDoc->fpOut)
-      fWorked = FALSE;
+    nParts = (pDoc->nModules > pDoc->nClasses) ? pDoc->nModules : pDoc->nClasses;
+    if(pDoc->nExamples > nParts)
+      nParts = pDoc->nExamples;
+    if(pDoc->nDocuments > nParts)
+      nParts = pDoc->nDocuments;
+    nParts = nParts ? (nParts + split - 1) / split : 1;
   }
 
   // determine style: @color, @font, @logo, @version
-  // and write the opening title bar
   FlyDocStyleGet(pDoc, &pMainPage->section, &style);
-  if(fWorked && !FlyDocHtmlWriteOpen(pDoc, &pMainPage->section, &style))
-    fWorked = FALSE;
-
-  // write any main page text before starting any columns
-  if(pMainPage->section.szText)
-  {
-    if(fprintf(pDoc->fpOut, "%s", m_szMainTextOpen) <= 0)
-      fWorked = FALSE;
-    if(fWorked && !FlyDocHtmlWriteText(pDoc, pMainPage->section.szText, style.szHeadingColor))
-      fWorked = FALSE;
-    if(fWorked && fprintf(pDoc->fpOut, "%s", m_szMainTextClose) <= 0)
-      fWorked = FALSE;
-  }
-
-  // Create columns (1 2 or 3 depending on content)
   nCols = FlyDocHtmlMainPageCols(pDoc, aColTypes);
-  if(fWorked && nCols)
+
+  for(part = 1; fWorked && part <= nParts; ++part)
   {
-    if(fprintf(pDoc->fpOut, m_szMainRowOpen) <= 0)
-        fWorked = FALSE;
+    range.first = split ? (part - 1) * split : 0;
+    range.last  = split ? part * split : UINT_MAX;
+    FlyDocHtmlPartName(szName, sizeof(szName), "index", (part == 1) ? 0 : part);
+    FlyDocHtmlPartName(szPrev, sizeof(szPrev), "index", (part == 2) ? 0 : part - 1);
+    FlyDocHtmlPartName(szNext, sizeof(szNext), "index", part + 1);
+
+    // start the HTML page and write the opening title bar
+    FlyDocHtmlPageNew(pDoc, szName);
+    FlyDocHtmlWriteOpen(pDoc, &pMainPage->section, &style);
+
+    // write any main page text before starting any columns
+    if(part == 1 && pMainPage->section.szText)
+    {
+      FlyDocPageStr(pPage, m_szMainTextOpen);
+      FlyDocHtmlWriteText(pDoc, pMainPage->section.szText, style.szHeadingColor);
+      FlyDocPageStr(pPage, m_szMainTextClose);
+    }
+    if(nParts > 1)
+    {
+      FlyDocPageStr(pPage, m_szMainTextOpen);
+      MdWritePageNav(pPage, (part > 1) ? szPrev : NULL, part, nParts, (part < nParts) ? szNext : NULL);
+      FlyDocPageStr(pPage, m_szMainTextClose);
+    }
 
-    for(i = 0; fWorked && i < nCols; ++i)
+    // Create columns (1 2 or 3 depending on content)
+    if(nCols)
     {
-      if(fprintf(pDoc->fpOut, m_szMainColOpen, aColTypes[i].szHeading) <= 0)
-        fWorked = FALSE;
+      FlyDocPageStr(pPage, m_szMainRowOpen);
 
-      switch(aColTypes[i].type)
+      for(i = 0; i < nCols; ++i)
       {
-        case MP_TYPE_MODULES_CLASSES:
-        if(!FlyDocHtmlWriteMainModList(pDoc, pDoc->pModList))
-          fWorked = FALSE;
-        if(fprintf(pDoc->fpOut, m_szMainColObjectsSep) <= 0)
-          fWorked = FALSE;
-        if(!FlyDocHtmlWriteMainModList(pDoc, pDoc->pClassList))
-          fWorked = FALSE;
-        break;
-        case MP_TYPE_MODULES:
-        if(!FlyDocHtmlWriteMainModList(pDoc, pDoc->pModList))
-          fWorked = FALSE;
-        break;
-        case MP_TYPE_CLASSES:
-        if(!FlyDocHtmlWriteMainModList(pDoc, pDoc->pClassList))
-          fWorked = FALSE;
-        break;
-        case MP_TYPE_EXAMPLES:
-        if(!FlyDocHtmlWriteMainExamplesAll(pDoc))
-          fWorked = FALSE;
-        break;
-        case MP_TYPE_DOCUMENTS:
-        if(!FlyDocHtmlWriteMainDocList(pDoc, pDoc->pMarkdownList))
-          fWorked = FALSE;
-        break;
+        FlyDocPageTpl(pPage, m_szMainColOpen, aColTypes[i].szHeading);
+
+        switch(aColTypes[i].type)
+        {
+          case MP_TYPE_MODULES_CLASSES:
+          FlyDocHtmlWriteMainModList(pDoc, pDoc->pModList, &range);
+          FlyDocPageStr(pPage, m_szMainColObjectsSep);
+          FlyDocHtmlWriteMainModList(pDoc, pDoc->pClassList, &range);
+          break;
+          case MP_TYPE_MODULES:
+          FlyDocHtmlWriteMainModList(pDoc, pDoc->pModList, &range);
+          break;
+          case MP_TYPE_CLASSES:
+          FlyDocHtmlWriteMainModList(pDoc, pDoc->pClassList, &range);
+          break;
+          case MP_TYPE_EXAMPLES:
+          FlyDocHtmlWriteMainExamplesAll(pDoc, &range);
+          break;
+          case MP_TYPE_DOCUMENTS:
+          FlyDocHtmlWriteMainDocList(pDoc, pDoc->pMarkdownList, &range);
+          break;
+        }
+
+        FlyDocPageStr(pPage, m_szMainColClose);
       }
 
-      if(fWorked && fprintf(pDoc->fpOut, m_szMainColClose) <= 0)
-        fWorked = FALSE;
+      // done
+      FlyDocPageStr(pPage, m_szMainRowClose);
     }
 
-    // done
-    if(fWorked && fprintf(pDoc->fpOut, m_szMainRowClose) <= 0)
-      fWorked = FALSE;
+    FlyDocPageStr(pPage, m_szMainEnd);
+
+    // done with page
+    fWorked = FlyDocHtmlPageWrite(pDoc);
   }
 
-  if(fWorked && fprintf(pDoc->fpOut, m_szMainEnd) <= 0)
-    fWorked = FALSE;
+  return fWorked;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write links to functions or methods into the left side bar.
+
+  @param  pPage   page being built
+  @param  pFunc   1st function to link to
+  @param  n       # of functions to link to
+  @return none
+-------------------------------------------------------------------------------------------------*/
+static void MdWriteFuncLinks(flyDocPage_t *pPage, const flyDocFunc_t *pFunc, unsigned n)
+{
+  for( ; pFunc && n; pFunc = pFunc->pNext, --n)
+    FlyDocPageTpl(pPage, m_szModLeftLine, pFunc->szRef, pFunc->szFunc);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write function or method prototypes and notes into the right side.
+
+  @param  pDoc            document state with page being written
+  @param  pFunc           1st function to write
+  @param  n               # of functions to write
+  @param  szHeadingColor  color for headings, e.g. w3-text-red
+  @return none
+-------------------------------------------------------------------------------------------------*/
+static void MdWriteFuncs(flyDoc_t *pDoc, const flyDocFunc_t *pFunc, unsigned n, const char *szHeadingColor)
+{
+  flyDocPage_t     *pPage = &pDoc->page;
+  const char       *szLine;
+
+  for( ; pFunc && n; pFunc = pFunc->pNext, --n)
+  {
+    FlyDocPageTpl(pPage, m_szModRightFuncHead, &pFunc->szRef[1], szHeadingColor, pFunc->szFunc, pFunc->szBrief);
+
+    if(pFunc->szPrototype)
+    {
+      FlyDocPageStr(pPage, m_szModRightProtoOpen);
+      for(szLine = pFunc->szPrototype; *szLine; szLine = FlyStrLineNext(szLine))
+        FlyDocPageTpl(pPage, m_szModRightProtoLine, (int)FlyStrLineLen(szLine), szLine);
+      FlyDocPageStr(pPage, m_szModRightProtoClose);
+    }
+
+    if(pFunc->szText)
+    {
+      FlyDocPageStr(pPage, m_szModRightNotesOpen);
+      FlyDocHtmlWriteText(pDoc, pFunc->szText, szHeadingColor);
+    }
+  }
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write one function or method into pDoc->page as HTML, with no page around it, e.g. to show on
+  hover in an editor. See FlyDocLibWriteFunc().
+
+  @param  pDoc      document state, page is replaced
+  @param  pMod      module or class of the function, for its style
+  @param  pFunc     function to write
+  @return none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocHtmlWriteFunc(flyDoc_t *pDoc, flyDocModule_t *pMod, const flyDocFunc_t *pFunc)
+{
+  flyDocStyle_t   style;
+
+  FlyDocStyleGet(pDoc, &pMod->section, &style);
+
+  // the page it would be on, so a mention of its own module isn't linked
+  FlyStrZCpy(pDoc->szPath, pMod->section.szTitle, sizeof(pDoc->szPath));
+  pDoc->page.len = 0;
+  MdWriteFuncs(pDoc, pFunc, 1, style.szHeadingColor);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write a module or class that has too many functions for one page (`--split=#`).
+
+  Each page of # functions, e.g. MyClass-1.html, MyClass-2.html, links to the previous and next
+  page and back to the contents page, MyClass.html. The contents page has the module or class text
+  and a link to each page. Links from elsewhere to MyClass.html#function go on to the page with
+  that function.
+
+  @param  pDoc    document state
+  @param  pMod    module to write
+  @param  nParts  # of pages of functions, see FlyDocHtmlNumParts()
+  @return TRUE if worked, FALSE if couldn't create files
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdWriteModuleSplit(flyDoc_t *pDoc, flyDocModule_t *pMod, unsigned nParts)
+{
+  flyDocPage_t     *pPage = &pDoc->page;
+  flyDocFunc_t     *pFunc;
+  flyDocFunc_t     *pLast;
+  flyDocStyle_t     style;
+  char              szName[FLYDOC_REF_MAX];
+  char              szPrev[FLYDOC_REF_MAX];
+  char              szNext[FLYDOC_REF_MAX];
+  char              szRef[PATH_MAX];
+  char              szRange[2 * FLYDOC_REF_MAX + 8];
+  char              szPage[16];
+  unsigned          split = (unsigned)pDoc->opts.split;
+  unsigned          part;
+  unsigned          i;
+
+  FlyDocStyleGet(pDoc, &pMod->section, &style);
 
-  // done with file
-  if(pDoc->fpOut)
+  // write each page of functions
+  pFunc = pMod->pFuncList;
+  for(part = 1; part <= nParts; ++part)
   {
-    fclose(pDoc->fpOut);
-    pDoc->fpOut = NULL;
+    FlyDocHtmlPartName(szName, sizeof(szName), pMod->section.szTitle, part);
+    FlyDocHtmlPartName(szPrev, sizeof(szPrev), pMod->section.szTitle, part - 1);
+    FlyDocHtmlPartName(szNext, sizeof(szNext), pMod->section.szTitle, part + 1);
+    FlyDocHtmlPageNew(pDoc, szName);
+    FlyDocHtmlWriteOpen(pDoc, &pMod->section, &style);
+
+    // left side bar: contents page, then functions on this page
+    FlyDocPageTpl(pPage, m_szModLeftOpen, style.szBarColor);
+    FlyDocPageStr(pPage, m_szModLeftSpacer);
+    FlyDocStrToRef(szRef, sizeof(szRef), pMod->section.szTitle, NULL);
+    FlyDocPageTpl(pPage, m_szModLeftLine, szRef, m_szContents);
+    FlyDocPageStr(pPage, m_szModLeftBreak);
+    MdWriteFuncLinks(pPage, pFunc, split);
+    FlyDocPageStr(pPage, m_szModLeftBarEnd);
+
+    // right side: functions on this page
+    FlyDocPageStr(pPage, m_szModRightOpen);
+    if(pMod->section.szSubtitle)
+      FlyDocPageTpl(pPage, m_szModRightTitle, pMod->section.szSubtitle);
+    MdWritePageNav(pPage, szPrev, part, nParts, (part < nParts) ? szNext : NULL);
+    MdWriteFuncs(pDoc, pFunc, split, style.szHeadingColor);
+    MdWritePageNav(pPage, szPrev, part, nParts, (part < nParts) ? szNext : NULL);
+    FlyDocPageStr(pPage, m_szModEnd);
+    if(!FlyDocHtmlPageWrite(pDoc))
+      return FALSE;
+
+    for(i = 0; pFunc && i < split; ++i)
+      pFunc = pFunc->pNext;
   }
 
-  return fWorked;
+  // contents page, e.g. MyClass.html
+  FlyDocHtmlPageNew(pDoc, pMod->section.szTitle);
+  FlyDocHtmlWriteOpen(pDoc, &pMod->section, &style);
+
+  // left side bar: 1st function on each page
+  FlyDocPageTpl(pPage, m_szModLeftOpen, style.szBarColor);
+  FlyDocPageStr(pPage, m_szModLeftSpacer);
+  pFunc = pMod->pFuncList;
+  for(part = 1; part <= nParts; ++part)
+  {
+    FlyDocHtmlPartName(szName, sizeof(szName), pMod->section.szTitle, part);
+    FlyDocStrToRef(szRef, sizeof(szRef), szName, NULL);
+    FlyDocPageTpl(pPage, m_szModLeftLine, szRef, pFunc->szFunc);
+    for(i = 0; pFunc && i < split; ++i)
+      pFunc = pFunc->pNext;
+  }
+  FlyDocPageStr(pPage, m_szModLeftBarEnd);
+
+  // right side: module or class text, then the range of functions on each page
+  FlyDocPageStr(pPage, m_szModRightOpen);
+  if(pMod->section.szSubtitle)
+    FlyDocPageTpl(pPage, m_szModRightTitle, pMod->section.szSubtitle);
+  if(pMod->section.szText)
+    FlyDocHtmlWriteText(pDoc, pMod->section.szText, style.szHeadingColor);
+  FlyDocPageTpl(pPage, m_szModRightPages, m_szPages);
+  pFunc = pMod->pFuncList;
+  for(part = 1; part <= nParts; ++part)
+  {
+    FlyDocHtmlPartName(szName, sizeof(szName), pMod->section.szTitle, part);
+    FlyDocStrToRef(szRef, sizeof(szRef), szName, NULL);
+    pLast = pFunc;
+    for(i = 1; pLast->pNext && i < split; ++i)
+      pLast = pLast->pNext;
+    snprintf(szPage, sizeof(szPage), "Page %u", part);
+    snprintf(szRange, sizeof(szRange), "%s to %s", pFunc->szFunc, pLast->szFunc);
+    FlyDocPageTpl(pPage, m_szMainColRefLine, szRef, szPage, szRange);
+    pFunc = pLast->pNext;
+  }
+
+  // send links to MyClass.html#function on to the page with the function
+  FlyDocPageStr(pPage, m_szModSplitScriptOpen);
+  for(i = 0, pFunc = pMod->pFuncList; pFunc; pFunc = pFunc->pNext, ++i)
+    FlyDocPageTpl(pPage, "\"%s\":%u,", &pFunc->szRef[1], i / split + 1);
+  FlyDocPageStr(pPage, m_szModSplitScriptClose);
+  FlyDocPageStr(pPage, m_szModEnd);
+
+  return FlyDocHtmlPageWrite(pDoc);
 }
 
 /*!-------------------------------------------------------------------------------------------------
@@ -1062,140 +1542,59 @@ bool_t FlyDocHtmlWriteMainPage(flyDoc_t *pDoc)
       |      |                 |
       +------+-----------------+
 
+  With `--split=#`, a module or class with more than # functions is split over several pages, see
+  MdWriteModuleSplit().
+
   @param  pDoc    document state
   @param  pMod    module to write
   @return TRUE if worked, FALSE if couldn't create folder or files
 -------------------------------------------------------------------------------------------------*/
 bool_t FlyDocHtmlWriteModule(flyDoc_t *pDoc, flyDocModule_t *pMod)
 {
-  flyDocFunc_t     *pFunc;
-  const char       *szLine;
+  flyDocPage_t     *pPage = &pDoc->page;
   flyDocStyle_t    style;
-  char              szRef[PATH_MAX];
-  bool_t            fWorked   = TRUE;
+  unsigned         nFuncs;
+  unsigned         nParts;
 
   FlyAssert(pDoc && pMod && pMod->section.szTitle);
 
-  // create the module HTML file, e.g. Person.html or Maths.html
-  pDoc->fpOut = FlyDocCreateHtmlFile(pDoc, pMod->section.szTitle);
-  if(!pDoc->fpOut)
-    fWorked = FALSE;
+  nFuncs = FlyListLen(pMod->pFuncList);
+  nParts = FlyDocHtmlNumParts(pDoc, nFuncs);
+  if(nParts)
+    return MdWriteModuleSplit(pDoc, pMod, nParts);
+
+  // start the module HTML page, e.g. Person.html or Maths.html
+  FlyDocHtmlPageNew(pDoc, pMod->section.szTitle);
 
   // determine style, @color, @font, @logo, @version
   // and write the opening title bar
   FlyDocStyleGet(pDoc, &pMod->section, &style);
-  if(fWorked && !FlyDocHtmlWriteOpen(pDoc, &pMod->section, &style))
-    fWorked = FALSE;
+  FlyDocHtmlWriteOpen(pDoc, &pMod->section, &style);
 
   // no left bar if not functions/methods
-  if(fWorked && FlyListLen(pMod->pFuncList))
+  if(pMod->pFuncList)
   {
-    // create the left side bar: links to functions/methods
-    if(fprintf(pDoc->fpOut, m_szModLeftOpen, style.szBarColor) <= 0)
-      fWorked = FALSE;
-    if(fWorked && fprintf(pDoc->fpOut, m_szModLeftSpacer) <= 0)
-      fWorked = FALSE;
-
-    // create links in left side bar to all functions/methods in module/class
-    pFunc = pMod->pFuncList;
-    while(fWorked && pFunc)
-    {
-      FlyDocStrToRef(szRef, sizeof(szRef), NULL, pFunc->szFunc);
-      if(fprintf(pDoc->fpOut, m_szModLeftLine, szRef, pFunc->szFunc) <= 0)
-        fWorked = FALSE;
-      pFunc = pFunc->pNext;
-    }
-    if(fWorked && fprintf(pDoc->fpOut, m_szModLeftBarEnd) <= 0)
-      fWorked = FALSE;
+    // create the left side bar: links to all functions/methods in module/class
+    FlyDocPageTpl(pPage, m_szModLeftOpen, style.szBarColor);
+    FlyDocPageStr(pPage, m_szModLeftSpacer);
+    MdWriteFuncLinks(pPage, pMod->pFuncList, nFuncs);
+    FlyDocPageStr(pPage, m_szModLeftBarEnd);
   }
 
   // create the right side: start with @class or @defgroup text
-  if(fWorked)
-  {
-    if(fprintf(pDoc->fpOut, m_szModRightOpen) <= 0)
-      fWorked = FALSE;
-    if(fWorked && pMod->section.szSubtitle)
-    {
-      if(fprintf(pDoc->fpOut, m_szModRightTitle, pMod->section.szSubtitle) <= 0)
-        fWorked = FALSE;
-    }
-    if(fWorked && pMod->section.szText && !FlyDocHtmlWriteText(pDoc, pMod->section.szText, style.szHeadingColor))
-      fWorked = FALSE;
-  }
+  FlyDocPageStr(pPage, m_szModRightOpen);
+  if(pMod->section.szSubtitle)
+    FlyDocPageTpl(pPage, m_szModRightTitle, pMod->section.szSubtitle);
+  if(pMod->section.szText)
+    FlyDocHtmlWriteText(pDoc, pMod->section.szText, style.szHeadingColor);
 
   // create the right side function prototypes, notes and examples
-  pFunc = pMod->pFuncList;
-  while(fWorked && pFunc)
-  {
-    FlyDocStrToRef(szRef, sizeof(szRef), NULL, pFunc->szFunc);
-    if(fprintf(pDoc->fpOut, m_szModRightFuncHead, &szRef[1], style.szHeadingColor, pFunc->szFunc,
-              pFunc->szBrief ? pFunc->szBrief : "") <= 0)
-    {
-      fWorked = FALSE;
-    }
-
-    if(fWorked && pFunc->szPrototype)
-    {
-      if(fprintf(pDoc->fpOut, m_szModRightProtoOpen) <= 0)
-        fWorked = FALSE;
-
-      szLine = pFunc->szPrototype;
-      while(fWorked && *szLine)
-      {
-        if(fprintf(pDoc->fpOut, m_szModRightProtoLine, (int)FlyStrLineLen(szLine), szLine) <= 0)
-          fWorked = FALSE;
-        szLine = FlyStrLineNext(szLine);
-      }
-      if(fWorked && fprintf(pDoc->fpOut, m_szModRightProtoClose) <= 0)
-        fWorked = FALSE;
-    }
-
-    if(fWorked && pFunc->szText)
-    {
-      if(fprintf(pDoc->fpOut, m_szModRightNotesOpen) <= 0)
-        fWorked = FALSE;
-      else if(!FlyDocHtmlWriteText(pDoc, pFunc->szText, style.szHeadingColor))
-        fWorked = FALSE;
-    }
-
-    pFunc = pFunc->pNext;
-  }
+  MdWriteFuncs(pDoc, pMod->pFuncList, nFuncs, style.szHeadingColor);
 
   // end the module page
-  if(fWorked && fprintf(pDoc->fpOut, m_szModEnd) <= 0)
-    fWorked = FALSE;
+  FlyDocPageStr(pPage, m_szModEnd);
 
-  if(pDoc->fpOut)
-    fclose(pDoc->fpOut);
-  pDoc->fpOut = NULL;
-
-  return fWorked;
-}
-
-/*-------------------------------------------------------------------------------------------------
-  Allocate a new string of sz that has spaces converted to non-breaking spaces.
-
-  Used to prevent browser from making too narrow of a column for links.
-
-  @param  sz    a string
-  @return Returns newly allocates
--------------------------------------------------------------------------------------------------*/
-static char * FlyDocSpaceToNb(const char *sz)
-{
-  static const char szNbSp[] = "&nbsp;";
-  char       *szNb;
-  size_t      size;
-  unsigned    n;
-
-  n = FlyStrCount(sz, " ");
-  size = strlen(sz) + (n * strlen(szNbSp)) + 1;
-  szNb = FlyAlloc(size);
-  if(szNb)
-  {
-    strcpy(szNb, sz);
-    FlyStrReplace(szNb, size, " ", szNbSp, FLYSTR_REP_ALL);
-  }
-  return szNb;
+  return FlyDocHtmlPageWrite(pDoc);
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -1207,65 +1606,43 @@ static char * FlyDocSpaceToNb(const char *sz)
 -------------------------------------------------------------------------------------------------*/
 bool_t FlyDocHtmlWriteMarkdown(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdown)
 {
+  flyDocPage_t     *pPage       = &pDoc->page;
   flyDocMdHdr_t    *pMdHdr;
   flyDocSection_t  *pSection    = &pMarkdown->section;
   flyDocStyle_t     style;
-  char             *szNbTitle;
-  char              szRef[PATH_MAX];
-  bool_t            fWorked     = TRUE;
 
-  // create the module HTML file
-  pDoc->fpOut = FlyDocCreateHtmlFile(pDoc, pSection->szTitle);
-  if(!pDoc->fpOut)
-    return FALSE;
+  // start the markdown HTML page
+  FlyDocHtmlPageNew(pDoc, pSection->szTitle);
 
   // determine style, @color, @font, @logo, @version
   // and write the opening title bar
   FlyDocStyleGet(pDoc, pSection, &style);
-  if(fWorked && !FlyDocHtmlWriteOpen(pDoc, pSection, &style))
-    fWorked = FALSE;
+  FlyDocHtmlWriteOpen(pDoc, pSection, &style);
 
   // no left bar if no headings
-  if(FlyListLen(pMarkdown->pHdrList))
+  if(pMarkdown->pHdrList)
   {
     // create the left side bar: links to functions/methods
-    if(fWorked && fprintf(pDoc->fpOut, m_szModLeftOpen, style.szBarColor) <= 0)
-      fWorked = FALSE;
-    if(fWorked && fprintf(pDoc->fpOut, m_szModLeftSpacer) <= 0)
-      fWorked = FALSE;
+    FlyDocPageTpl(pPage, m_szModLeftOpen, style.szBarColor);
+    FlyDocPageStr(pPage, m_szModLeftSpacer);
 
     // write headers to left-handle column for easy links to sections in markdown file
-    pMdHdr = pMarkdown->pHdrList;
-    while(fWorked && pMdHdr)
-    {
-      FlyDocStrToRef(szRef, sizeof(szRef), NULL, pMdHdr->szTitle);
-      szNbTitle = FlyDocSpaceToNb(pMdHdr->szTitle);
-      FlyDocAllocCheck(szNbTitle);
-      if(fprintf(pDoc->fpOut, m_szModLeftLine, szRef, szNbTitle) <= 0)
-        fWorked = FALSE;
-      FlyFree(szNbTitle);
-      pMdHdr = pMdHdr->pNext;
-    }
-    if(fWorked && fprintf(pDoc->fpOut, m_szModLeftBarEnd) <= 0)
-      fWorked = FALSE;
+    for(pMdHdr = pMarkdown->pHdrList; pMdHdr; pMdHdr = pMdHdr->pNext)
+      FlyDocPageTpl(pPage, m_szModLeftLine, pMdHdr->szRef, pMdHdr->szNbTitle);
+    FlyDocPageStr(pPage, m_szModLeftBarEnd);
   }
 
   // create the right side: module text
-  if(fWorked && fprintf(pDoc->fpOut, m_szModRightOpen) <= 0)
-    fWorked = FALSE;
+  FlyDocPageStr(pPage, m_szModRightOpen);
 
   // write out the entire markdown document
-  if(fWorked && pSection->szText)
-    fWorked = FlyDocHtmlWriteText(pDoc, pSection->szText, style.szHeadingColor);
+  if(pSection->szText)
+    FlyDocHtmlWriteText(pDoc, pSection->szText, style.szHeadingColor);
 
   // end the markdown page
-  if(fWorked && fprintf(pDoc->fpOut, m_szModEnd) <= 0)
-    fWorked = FALSE;
+  FlyDocPageStr(pPage, m_szModEnd);
 
-  fclose(pDoc->fpOut);
-  pDoc->fpOut = NULL;
-
-  return TRUE;
+  return FlyDocHtmlPageWrite(pDoc);
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -1281,7 +1658,7 @@ bool_t FlyDocHtmlWriteCss(flyDoc_t *pDoc)
   FlyStrPathAppend(pDoc->szPath, "w3.css", sizeof(pDoc->szPath));
   if(pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
     printf("  %s\n", pDoc->szPath);
-  return FlyFileWrite(pDoc->szPath, szW3CssFile);
+  return FlyDocFileWrite(pDoc, pDoc->szPath, szW3CssFile, strlen(szW3CssFile));
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -1297,7 +1674,150 @@ bool_t FlyDocHtmlWriteImgHome(flyDoc_t *pDoc)
   FlyStrPathAppend(pDoc->szPath, "flydoc_home.png", sizeof(pDoc->szPath));
   if(pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
     printf("  %s\n", pDoc->szPath);
-  return FlyFileWriteBin(pDoc->szPath, imgHome, imgHome_size);
+  return FlyDocFileWrite(pDoc, pDoc->szPath, imgHome, imgHome_size);
+}
+
+// each module, class or markdown page is written with its own copy of the flydoc state
+typedef struct
+{
+  flyDocModule_t     *pMod;         // module or class, NULL if a markdown document
+  flyDocMarkdown_t   *pMarkdown;
+  char               *szPath;       // HTML file written
+  uint64_t            ns;           // --profile: time to build and write page
+  size_t              len;          // --profile: length of page
+  bool_t              fWorked;
+  bool_t              fNeedImgHome;
+} flyDocPageJob_t;
+
+typedef struct
+{
+  flyDoc_t           *pDoc;
+  flyDocPageJob_t    *aPages;
+  bool_t              fWorked;
+} flyDocPageJobs_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Write one module, class or markdown page. Runs on a worker thread.
+
+  The writer gets its own page and szPath. Everything else in pDoc (including the arena) is read
+  only while writing.
+
+  @param  pData   ptr to flyDocPageJobs_t
+  @param  i       index into page array
+  @return none
+-------------------------------------------------------------------------------------------------*/
+static void MdWritePageJob(void *pData, unsigned i)
+{
+  flyDocPageJobs_t   *pJobs = pData;
+  flyDocPageJob_t    *pPage = &pJobs->aPages[i];
+  flyDoc_t            writer;
+
+  // file being created is printed in order by MdWritePageDone()
+  writer                = *pJobs->pDoc;
+  writer.opts.verbose   = FLYDOC_VERBOSE_NONE;
+  memset(&writer.page, 0, sizeof(writer.page));
+  writer.fNeedImgHome   = FALSE;
+
+  if(pPage->pMod)
+    pPage->fWorked = FlyDocHtmlWriteModule(&writer, pPage->pMod);
+  else
+    pPage->fWorked = FlyDocHtmlWriteMarkdown(&writer, pPage->pMarkdown);
+  pPage->ns  = writer.page.nsLast;
+  pPage->len = writer.page.lenLast;
+  FlyDocPageFree(&writer.page);
+  pPage->fNeedImgHome = writer.fNeedImgHome;
+  pPage->szPath = FlyStrClone(writer.szPath);
+  FlyDocAllocCheck(pPage->szPath);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  A page has been written. Called in page order on the main thread.
+
+  @param  pData   ptr to flyDocPageJobs_t
+  @param  i       index into page array
+  @return TRUE to continue, FALSE if page couldn't be written
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdWritePageDone(void *pData, unsigned i)
+{
+  flyDocPageJobs_t   *pJobs = pData;
+  flyDocPageJob_t    *pPage = &pJobs->aPages[i];
+  flyDoc_t           *pDoc  = pJobs->pDoc;
+
+  if(pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
+    printf("  %s\n", pPage->szPath);
+  if(pPage->fWorked)
+    FlyDocProfPage(pDoc, pPage->szPath, pPage->ns, pPage->len);
+  if(pPage->fNeedImgHome)
+    pDoc->fNeedImgHome = TRUE;
+  if(!pPage->fWorked)
+  {
+    FlyStrZCpy(pDoc->szPath, pPage->szPath, sizeof(pDoc->szPath));
+    FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->szPath);
+    pJobs->fWorked = FALSE;
+  }
+  FlyFree(pPage->szPath);
+  pPage->szPath = NULL;
+
+  return pPage->fWorked;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write all module, class and markdown pages, in that order, using -j=# threads. With --watch, only
+  pages whose inputs changed since the last build are written.
+
+  @param  pDoc   filled-in document, main page (if any) already written
+  @return TRUE if worked, FALSE if couldn't create a file
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdWritePages(flyDoc_t *pDoc)
+{
+  flyDocPageJobs_t    jobs;
+  flyDocPageJob_t    *pPage;
+  flyDocModule_t     *pMod;
+  flyDocMarkdown_t   *pMarkdown;
+  const char         *szTitle;
+  unsigned            nPages;
+  unsigned            i;
+  unsigned            j;
+
+  nPages = FlyListLen(pDoc->pModList) + FlyListLen(pDoc->pClassList) + FlyListLen(pDoc->pMarkdownList);
+  memset(&jobs, 0, sizeof(jobs));
+  jobs.pDoc     = pDoc;
+  jobs.fWorked  = TRUE;
+  if(nPages)
+  {
+    jobs.aPages = FlyAllocZ(nPages * sizeof(*jobs.aPages));
+    FlyDocAllocCheck(jobs.aPages);
+
+    i = 0;
+    for(pMod = pDoc->pModList; pMod; pMod = pMod->pNext)
+      jobs.aPages[i++].pMod = pMod;
+    for(pMod = pDoc->pClassList; pMod; pMod = pMod->pNext)
+      jobs.aPages[i++].pMod = pMod;
+    for(pMarkdown = pDoc->pMarkdownList; pMarkdown; pMarkdown = pMarkdown->pNext)
+      jobs.aPages[i++].pMarkdown = pMarkdown;
+
+    // --watch: leave out pages whose inputs haven't changed
+    if(pDoc->pWatch)
+    {
+      nPages = 0;
+      for(j = 0; j < i; ++j)
+      {
+        pPage = &jobs.aPages[j];
+        szTitle = pPage->pMod ? pPage->pMod->section.szTitle : pPage->pMarkdown->section.szTitle;
+        if(!FlyDocWatchPageSame(pDoc, szTitle, MdInputsPage(pDoc, pPage->pMod, pPage->pMarkdown)))
+          jobs.aPages[nPages++] = *pPage;
+      }
+    }
+
+    FlyDocJobsRun(pDoc->opts.nJobs, nPages, MdWritePageJob, MdWritePageDone, &jobs);
+
+    // a page that couldn't be written stops the run, pages already written after it aren't done
+    for(i = 0; i < nPages; ++i)
+      FlyFreeIf(jobs.aPages[i].szPath);
+    FlyFree(jobs.aPages);
+  }
+
+  return jobs.fWorked;
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -1308,13 +1828,15 @@ bool_t FlyDocHtmlWriteImgHome(flyDoc_t *pDoc)
 -------------------------------------------------------------------------------------------------*/
 bool_t FlyDocWriteHtml(flyDoc_t *pDoc)
 {
-  flyDocModule_t   *pMod;
-  flyDocMarkdown_t *pMarkdown;
   bool_t            fWorked = TRUE;
 
   if(pDoc->opts.debug)
     printf("-- FlyDocWriteHtml(%s) ---\n", pDoc->opts.szOut);
 
+  // symbols mentioned in text are linked on every page, the library indexes once in FlyDocLibDone()
+  if(!pDoc->fInMemory)
+    FlyDocLinkIndex(pDoc);
+
   // create the folder
   if(!FlyDocCreateFolder(pDoc, pDoc->opts.szOut))
   {
@@ -1334,43 +1856,18 @@ bool_t FlyDocWriteHtml(flyDoc_t *pDoc)
     FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->szPath);
     fWorked = FALSE;
   }
+  else if(fWorked && pDoc->page.lenLast)
+    FlyDocProfPage(pDoc, pDoc->szPath, pDoc->page.nsLast, pDoc->page.lenLast);
 
-  // write out modules first
-  pMod = pDoc->pModList;
-  while(fWorked && pMod)
-  {
-    if(!FlyDocHtmlWriteModule(pDoc, pMod))
-    {
-      FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->szPath);
-      fWorked = FALSE;
-      break;
-    }
-    pMod = pMod->pNext;
-  }
-
-  // write out class list next
-  pMod = pDoc->pClassList;
-  while(fWorked && pMod)
-  {
-    if(!FlyDocHtmlWriteModule(pDoc, pMod))
-    {
-      FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->szPath);
-      fWorked = FALSE;
-      break;
-    }
-    pMod = pMod->pNext;
-  }
+  // write out modules first, then classes, then markdown documents
+  if(fWorked && !MdWritePages(pDoc))
+    fWorked = FALSE;
 
-  pMarkdown = pDoc->pMarkdownList;
-  while(fWorked && pMarkdown)
+  // search index for the search box on every page
+  if(fWorked && !pDoc->opts.fNoSearch && !FlyDocSearchWrite(pDoc))
   {
-    if(!FlyDocHtmlWriteMarkdown(pDoc, pMarkdown))
-    {
-      FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->szPath);
-      fWorked = FALSE;
-      break;
-    }
-    pMarkdown = pMarkdown->pNext;
+    FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->szPath);
+    fWorked = FALSE;
   }
 
   // write the w3.css file if user wants a local reference to that file
@@ -1379,6 +1876,7 @@ bool_t FlyDocWriteHtml(flyDoc_t *pDoc)
     FlyDocPrintWarning(pDoc, szWarningCreateFile, pDoc->szPath);
     fWorked = FALSE;
   }
+  FlyDocPageFree(&pDoc->page);
 
   return fWorked;
 }
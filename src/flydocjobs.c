@@ -0,0 +1,165 @@
+/**************************************************************************************************
+  flydocjobs.c - Run a set of independent jobs on a pool of worker threads
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <pthread.h>
+#include "flydoc.h"
+
+#define FLYDOC_JOBS_MAX_THREADS   64    // sanity limit on -j
+#define FLYDOC_JOBS_AHEAD         8     // jobs per thread allowed to complete ahead of done
+
+/*!
+  @defgroup flydoc_jobs   Run a set of independent jobs on a pool of worker threads
+
+  Jobs are numbered 0 to nJobs-1. Worker threads pick up the next job number in order, and the
+  calling thread gets the "done" callback for each job strictly in job order. This allows the
+  results of the jobs to be combined (and any messages printed) exactly as if the jobs had been
+  run one after another. The "done" callback can stop the remaining jobs, like a break in a loop.
+
+  Workers only run a limited number of jobs ahead of the "done" callback, so the memory used by
+  completed, but not yet done, jobs is bounded.
+*/
+
+typedef struct
+{
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;       // signaled when a job completes or when a job is done
+  pfnFlyDocJob_t      pfnJob;
+  void               *pData;
+  bool_t             *afComplete; // afComplete[i] is TRUE when job i has run
+  unsigned            nJobs;
+  unsigned            nextJob;    // next job for a worker to pick up
+  unsigned            nextDone;   // next job for the done callback
+  unsigned            nAhead;     // max jobs that can be running or complete ahead of nextDone
+  bool_t              fStop;      // done callback returned FALSE, don't start any more jobs
+} flyDocJobs_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Worker thread. Runs jobs in order until there are no more jobs.
+
+  @param    pArg    ptr to flyDocJobs_t
+  @return   NULL
+-------------------------------------------------------------------------------------------------*/
+static void * MdJobsWorker(void *pArg)
+{
+  flyDocJobs_t *pJobs = pArg;
+  unsigned      i;
+
+  pthread_mutex_lock(&pJobs->mutex);
+  while(TRUE)
+  {
+    // don't get too far ahead of the done callback
+    while(!pJobs->fStop && pJobs->nextJob < pJobs->nJobs && pJobs->nextJob >= pJobs->nextDone + pJobs->nAhead)
+      pthread_cond_wait(&pJobs->cond, &pJobs->mutex);
+    if(pJobs->fStop || pJobs->nextJob >= pJobs->nJobs)
+      break;
+    i = pJobs->nextJob++;
+
+    pthread_mutex_unlock(&pJobs->mutex);
+    pJobs->pfnJob(pJobs->pData, i);
+    pthread_mutex_lock(&pJobs->mutex);
+
+    pJobs->afComplete[i] = TRUE;
+    pthread_cond_broadcast(&pJobs->cond);
+  }
+  pthread_mutex_unlock(&pJobs->mutex);
+
+  return NULL;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Run nJobs jobs using up to nThreads worker threads.
+
+  pfnJob() is called from the worker threads, so it must only touch data private to job i.
+  pfnDone() is called from the calling thread, once per job, in job order 0 to nJobs-1. If
+  pfnDone() returns FALSE, no more jobs are started and pfnDone() isn't called again, even for jobs
+  that were already running.
+
+  If nThreads is 0 or 1, or if threads can't be created, jobs are run on the calling thread.
+
+  @param    nThreads    number of worker threads
+  @param    nJobs       number of jobs
+  @param    pfnJob      function to run a job
+  @param    pfnDone     function called when a job is complete (in order)
+  @param    pData       ptr to data for pfnJob() and pfnDone()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocJobsRun(unsigned nThreads, unsigned nJobs, pfnFlyDocJob_t pfnJob, pfnFlyDocJobDone_t pfnDone, void *pData)
+{
+  flyDocJobs_t    jobs;
+  pthread_t      *aThreads  = NULL;
+  unsigned        nCreated  = 0;
+  unsigned        i;
+
+  if(nThreads > FLYDOC_JOBS_MAX_THREADS)
+    nThreads = FLYDOC_JOBS_MAX_THREADS;
+  if(nThreads > nJobs)
+    nThreads = nJobs;
+
+  // create the worker threads
+  memset(&jobs, 0, sizeof(jobs));
+  if(nThreads > 1)
+  {
+    jobs.pfnJob     = pfnJob;
+    jobs.pData      = pData;
+    jobs.nJobs      = nJobs;
+    jobs.nAhead     = nThreads * FLYDOC_JOBS_AHEAD;
+    jobs.afComplete = FlyAllocZ(nJobs * sizeof(*jobs.afComplete));
+    aThreads        = FlyAlloc(nThreads * sizeof(*aThreads));
+    FlyDocAllocCheck(jobs.afComplete);
+    FlyDocAllocCheck(aThreads);
+    pthread_mutex_init(&jobs.mutex, NULL);
+    pthread_cond_init(&jobs.cond, NULL);
+    for(i = 0; i < nThreads; ++i)
+    {
+      if(pthread_create(&aThreads[nCreated], NULL, MdJobsWorker, &jobs) == 0)
+        ++nCreated;
+    }
+  }
+
+  // no threads, run all the jobs right here
+  if(nCreated == 0)
+  {
+    for(i = 0; i < nJobs; ++i)
+    {
+      pfnJob(pData, i);
+      if(!pfnDone(pData, i))
+        break;
+    }
+  }
+
+  // wait for each job to complete, in order
+  else
+  {
+    for(i = 0; i < nJobs; ++i)
+    {
+      pthread_mutex_lock(&jobs.mutex);
+      while(!jobs.afComplete[i])
+        pthread_cond_wait(&jobs.cond, &jobs.mutex);
+      jobs.nextDone = i + 1;
+      pthread_cond_broadcast(&jobs.cond);
+      pthread_mutex_unlock(&jobs.mutex);
+
+      if(!pfnDone(pData, i))
+      {
+        pthread_mutex_lock(&jobs.mutex);
+        jobs.fStop = TRUE;
+        pthread_cond_broadcast(&jobs.cond);
+        pthread_mutex_unlock(&jobs.mutex);
+        break;
+      }
+    }
+
+    for(i = 0; i < nCreated; ++i)
+      pthread_join(aThreads[i], NULL);
+  }
+
+  if(nThreads > 1)
+  {
+    pthread_cond_destroy(&jobs.cond);
+    pthread_mutex_destroy(&jobs.mutex);
+    FlyFree(jobs.afComplete);
+    FlyFree(aThreads);
+  }
+}
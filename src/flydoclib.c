@@ -0,0 +1,171 @@
+/**************************************************************************************************
+  flydoclib.c - Use flydoc in-process: parse from memory, write to a callback
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include "flydoc.h"
+#include "FlyStr.h"
+
+/*!
+  @defgroup flydoc_lib   Use flydoc in-process: parse from memory, write to a callback
+
+  A doc server or editor plugin can link `libflydoc.a` (`make libflydoc.a` in `src/`) rather than
+  run the flydoc program and read its files back. Inputs are given as text in memory, and each
+  output file (HTML page, search index, w3.css, markdown) is handed to a callback rather than
+  written to disk. Nothing is written to the file system and nothing is printed, other than
+  warnings.
+
+  All state is in the flyDoc_t, so any number can be used at once, one per thread. A flyDoc_t can
+  be parsed once and written many times, e.g. one function on each hover with FlyDocLibWriteFunc().
+
+  @example  Render in memory
+
+      flyDocOpts_t  opts;
+      flyDoc_t      doc;
+
+      memset(&opts, 0, sizeof(opts));
+      opts.fSort = TRUE;
+      FlyDocLibInit(&doc, &opts);
+      FlyDocLibParse(&doc, "src/foo.c", szFooC, strlen(szFooC));
+      FlyDocLibParse(&doc, "docs/guide.md", szGuide, strlen(szGuide));
+      FlyDocLibDone(&doc);
+      FlyDocLibWriteFunc(&doc, "FooOpen", MyShowHover, pEditor);
+      FlyDocLibWrite(&doc, MyServeFile, pServer);
+      FlyDocLibFree(&doc);
+*/
+
+/*!------------------------------------------------------------------------------------------------
+  Initialize a flyDoc_t for in-process use. Same as FlyDocInit(), but output paths start with "."
+  if pOpts->szOut is NULL. Free with FlyDocLibFree().
+
+  Options that read or write files (`--cache`, `--emit-db`, `--load-db`, `--watch`, etc.) don't
+  apply, nor does `-j`.
+
+  @param    pDoc      flyDoc_t to initialize
+  @param    pOpts     options, e.g. fSort, fMarkdown, fLocal, fNoSearch, split
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocLibInit(flyDoc_t *pDoc, const flyDocOpts_t *pOpts)
+{
+  FlyDocInit(pDoc, pOpts);
+  if(pDoc->opts.szOut == NULL)
+    pDoc->opts.szOut = ".";
+  pDoc->opts.nJobs  = 1;
+  pDoc->fInMemory   = TRUE;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Parse a source or markdown file from memory. The text is copied, so need not be kept. It is parsed
+  at once into pDoc, as FlyDocParseInputs() does for each queued file without -j, as there is no
+  folder walk and no image files to find first.
+
+  szPath need not exist. Its extension picks the language (see `--exts`), its name is the title of
+  a markdown document and it is used in warnings.
+
+  @param    pDoc      flyDoc_t from FlyDocLibInit()
+  @param    szPath    path of file, e.g. "src/foo.c" or "guide.md"
+  @param    szText    file contents, need not be '\0' terminated
+  @param    len       length of file contents
+  @return   TRUE if worked, FALSE if not parsed
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocLibParse(flyDoc_t *pDoc, const char *szPath, const char *szText, size_t len)
+{
+  flyDocInFile_t  inFile;
+
+  memset(&inFile, 0, sizeof(inFile));
+  inFile.szFile = FlyDocAlloc(len + 1);
+  memcpy(inFile.szFile, szText, len);
+  inFile.szFile[len] = '\0';
+  inFile.len = len;
+
+  return FlyDocParseFileEx(pDoc, szPath, &inFile);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  All files are parsed: sort (if opts.fSort), count and index the document for writing. May be
+  called again after parsing more files. The link index is built here, not by each
+  FlyDocLibWrite(), so writing the same document many times doesn't grow the arena.
+
+  @param    pDoc      flyDoc_t with files parsed by FlyDocLibParse()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocLibDone(flyDoc_t *pDoc)
+{
+  if(pDoc->opts.fSort)
+    FlyDocSortLists(pDoc);
+  FlyDocStatsUpdate(pDoc);
+  FlyDocLinkIndex(pDoc);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write the whole document, HTML pages or a markdown file (opts.fMarkdown), to a callback. The
+  callback gets each output file in turn, all in memory, with its path in the output folder, e.g.
+  "./index.html" or "./search/fl.js". Images aren't copied; the pages link to them by name.
+
+  @param    pDoc      flyDoc_t after FlyDocLibDone()
+  @param    pfnOut    called with each output file
+  @param    pData     ptr passed to pfnOut()
+  @return   TRUE if worked, FALSE if pfnOut() returned FALSE
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocLibWrite(flyDoc_t *pDoc, pfnFlyDocOut_t pfnOut, void *pData)
+{
+  bool_t  fWorked;
+
+  pDoc->pfnOut   = pfnOut;
+  pDoc->pOutData = pData;
+  if(FlyDocNumObjects(pDoc) == 0)
+    fWorked = TRUE;
+  else if(pDoc->opts.fMarkdown)
+    fWorked = FlyDocWriteMarkdown(pDoc);
+  else
+    fWorked = FlyDocWriteHtml(pDoc);
+  pDoc->pfnOut   = NULL;
+  pDoc->pOutData = NULL;
+
+  return fWorked;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write the HTML of one function or method (name, brief, prototype and notes) to a callback, with
+  no page around it, e.g. to show on hover. Links in it are relative to the output folder.
+
+  @param    pDoc      flyDoc_t after FlyDocLibDone()
+  @param    szFunc    function or method name, e.g. "FooOpen"
+  @param    pfnOut    called once with the HTML, path is szFunc
+  @param    pData     ptr passed to pfnOut()
+  @return   TRUE if worked, FALSE if no such function or pfnOut() returned FALSE
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocLibWriteFunc(flyDoc_t *pDoc, const char *szFunc, pfnFlyDocOut_t pfnOut, void *pData)
+{
+  flyDocModule_t     *pMod;
+  const flyDocFunc_t *pFunc = NULL;
+  unsigned            i;
+
+  for(i = 0; pFunc == NULL && i < 2; ++i)
+  {
+    for(pMod = i ? pDoc->pClassList : pDoc->pModList; pMod; pMod = pMod->pNext)
+    {
+      pFunc = FlyDocFuncInList(pMod->pFuncList, szFunc);
+      if(pFunc)
+        break;
+    }
+  }
+  if(pFunc == NULL)
+    return FALSE;
+
+  FlyDocHtmlWriteFunc(pDoc, pMod, pFunc);
+  return pfnOut(pData, szFunc, pDoc->page.szBuf ? pDoc->page.szBuf : "", pDoc->page.len);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Free everything in a flyDoc_t from FlyDocLibInit(). It may then be initialized again.
+
+  @param    pDoc      flyDoc_t from FlyDocLibInit()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocLibFree(flyDoc_t *pDoc)
+{
+  FlyDocPageFree(&pDoc->page);
+  FlyDocArenaFree(&pDoc->arena);
+  memset(pDoc, 0, sizeof(*pDoc));
+}
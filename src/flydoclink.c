@@ -0,0 +1,301 @@
+/**************************************************************************************************
+  flydoclink.c - Auto-link mentions of functions, modules and classes in text, see --nolink
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <ctype.h>
+#include "flydoc.h"
+#include "FlyList.h"
+#include "FlyStr.h"
+
+/*!
+  @defgroup flydoc_link   Auto-link mentions of functions, modules and classes in text
+
+  Text written to HTML pages is scanned once, after it is converted from markdown, for mentions of
+  any documented function, method, module or class. Each mention becomes a link to where that
+  symbol is documented, so "see FlyDocParseHdr()" links to FlyDocParseHdr() without anyone writing
+  the link.
+
+  Every symbol is a C name, so rather than search the text for each of (possibly tens of thousands
+  of) symbols, each C name in the text is looked up in a hash index of all symbols. This is a single
+  pass over the text, and costs the same no matter how many symbols there are.
+
+  To keep ordinary words ordinary, a mention is only linked if:
+
+  1. It isn't a plain word (is "snake_case", "CamelCase", or has a digit), or it's a function or
+     method followed by `(`, e.g. "init()" but not "init"
+  2. It isn't already in a link, a code block or an HTML tag
+  3. It's only documented once. A name documented in more than one place, e.g. a method in many
+     classes, isn't linked, as it's not known which is meant
+  4. It isn't the page it's on, e.g. a module doesn't link to itself
+*/
+
+// a symbol that mentions link to
+typedef struct
+{
+  const char *szRef;        // e.g. "MyModule.html#myfunc"
+  const char *szPage;       // page name, e.g. "MyModule" or "MyModule-2" with --split
+  bool_t      fFunc;        // function or method, rather than module or class
+  bool_t      fAmbiguous;   // documented more than once, don't link
+} flyDocLink_t;
+
+static const char m_szLink[] = "<a href=\"%s\">%.*s</a>";
+
+/*-------------------------------------------------------------------------------------------------
+  Is this C name an ordinary word, e.g. "point" or "Point", but not "MyPoint", "point_t" or "p2"?
+
+  @param    sz      C name
+  @param    len     length of C name
+  @return   TRUE if a plain word
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdLinkIsPlain(const char *sz, size_t len)
+{
+  size_t  i;
+
+  for(i = 0; i < len; ++i)
+  {
+    if(!isalpha((uint8_t)sz[i]) || (i && isupper((uint8_t)sz[i])))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Add a symbol to the link index. A symbol already there is marked ambiguous.
+
+  @param    pDoc      flydoc state with arena and linkIndex
+  @param    szName    symbol name, persistent
+  @param    szPage    page name the symbol is on
+  @param    szAnchor  local reference on the page, e.g. "#myfunc", or NULL for the page itself
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdLinkAdd(flyDoc_t *pDoc, const char *szName, const char *szPage, const char *szAnchor)
+{
+  flyDocLink_t   *pLink;
+  char            szRef[PATH_MAX];
+
+  // only C names can be found in text
+  if(FlyStrCNameLen(szName) != strlen(szName))
+    return;
+
+  pLink = FlyDocIndexFind(&pDoc->linkIndex, szName);
+  if(pLink)
+  {
+    pLink->fAmbiguous = TRUE;
+    pDoc->hLinks = FlyDocHash(szName, strlen(szName) + 1, pDoc->hLinks ^ 1);
+    return;
+  }
+
+  FlyDocRefJoin(szRef, sizeof(szRef), szPage, szAnchor);
+  pLink = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pLink));
+  pLink->szRef  = FlyDocArenaStrClone(&pDoc->arena, szRef);
+  pLink->szPage = FlyDocArenaStrClone(&pDoc->arena, szPage);
+  pLink->fFunc  = szAnchor ? TRUE : FALSE;
+  FlyDocIndexAdd(&pDoc->arena, &pDoc->linkIndex, szName, pLink);
+
+  // with --watch, any change to the symbols may change the links on any page
+  pDoc->hLinks = FlyDocHash(szName, strlen(szName) + 1, pDoc->hLinks);
+  pDoc->hLinks = FlyDocHash(pLink->szRef, strlen(pLink->szRef) + 1, pDoc->hLinks);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Add the modules (or classes) and their functions (or methods) to the link index.
+
+  @param    pDoc      flydoc state with arena and linkIndex
+  @param    pModList  list of modules or classes
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdLinkAddMods(flyDoc_t *pDoc, const flyDocModule_t *pModList)
+{
+  const flyDocModule_t  *pMod;
+  const flyDocFunc_t    *pFunc;
+  char                   szName[FLYDOC_REF_MAX];
+  unsigned               nParts;
+  unsigned               i;
+
+  for(pMod = pModList; pMod; pMod = pMod->pNext)
+  {
+    MdLinkAdd(pDoc, pMod->section.szTitle, pMod->section.szTitle, NULL);
+
+    // with --split, link right to the page the function is on
+    nParts = FlyDocHtmlNumParts(pDoc, FlyListLen(pMod->pFuncList));
+    for(i = 0, pFunc = pMod->pFuncList; pFunc; pFunc = pFunc->pNext, ++i)
+    {
+      FlyDocHtmlPartName(szName, sizeof(szName), pMod->section.szTitle, nParts ? i / pDoc->opts.split + 1 : 0);
+      MdLinkAdd(pDoc, pFunc->szFunc, szName, pFunc->szRef);
+    }
+  }
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Build the index of symbols to auto-link, from all modules, classes, functions and methods. Call
+  once, after parsing and before writing any HTML page. Also sets pDoc->hLinks, a hash of all the
+  links, for --watch.
+
+  @param    pDoc      flydoc state, fully parsed
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocLinkIndex(flyDoc_t *pDoc)
+{
+  memset(&pDoc->linkIndex, 0, sizeof(pDoc->linkIndex));
+  pDoc->hLinks = FLYDOC_HASH_INIT;
+  if(pDoc->opts.fNoLink)
+    return;
+
+  MdLinkAddMods(pDoc, pDoc->pModList);
+  MdLinkAddMods(pDoc, pDoc->pClassList);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Is this HTML tag the given tag name, e.g. "<a href=" or "</a>" is "a"?
+
+  @param    szTag     ptr to '<' or "</"
+  @param    szName    lower case tag name
+  @return   TRUE if it is the tag
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdLinkIsTag(const char *szTag, const char *szName)
+{
+  size_t  len = strlen(szName);
+
+  ++szTag;
+  if(*szTag == '/')
+    ++szTag;
+  return (strncasecmp(szTag, szName, len) == 0 && !isalnum((uint8_t)szTag[len])) ? TRUE : FALSE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Find the next mention of a symbol to link in HTML text.
+
+  @param    pDoc      flydoc state with linkIndex and szPath of page being written
+  @param    psz       HTML to search, '\0' terminated, updated to end of mention
+  @param    pDepth    nesting depth of <a> and <pre>, kept from call to call
+  @param    ppLink    receives the symbol, if one was found
+  @return   ptr to start of mention, or NULL if none
+-------------------------------------------------------------------------------------------------*/
+static const char * MdLinkNext(const flyDoc_t *pDoc, const char **psz, unsigned *pDepth,
+                               const flyDocLink_t **ppLink)
+{
+  const flyDocLink_t *pLink;
+  const char         *sz = *psz;
+  const char         *szName;
+  const char         *szPage;
+  unsigned            lenPage;
+  unsigned            len;
+
+  szPage = FlyStrPathNameBase(pDoc->szPath, &lenPage);
+  while(*sz)
+  {
+    // skip tags, but keep track of being in a link or preformatted block
+    if(*sz == '<')
+    {
+      if(MdLinkIsTag(sz, "a") || MdLinkIsTag(sz, "pre"))
+      {
+        if(sz[1] == '/')
+        {
+          if(*pDepth)
+            --(*pDepth);
+        }
+        else
+          ++(*pDepth);
+      }
+      while(*sz && *sz != '>')
+        ++sz;
+      if(*sz)
+        ++sz;
+      continue;
+    }
+
+    // skip entities, e.g. &amp;
+    if(*sz == '&')
+    {
+      ++sz;
+      while(isalnum((uint8_t)*sz) || *sz == '#')
+        ++sz;
+      continue;
+    }
+
+    // a whole word of letters, digits and '_', that isn't a number, e.g. not the "x" of "0x1f"
+    if(!(isalnum((uint8_t)*sz) || *sz == '_'))
+    {
+      ++sz;
+      continue;
+    }
+    szName = sz;
+    while(isalnum((uint8_t)*sz) || *sz == '_')
+      ++sz;
+    len = (unsigned)(sz - szName);
+    if(*pDepth || isdigit((uint8_t)*szName))
+      continue;
+
+    pLink = FlyDocIndexFindN(&pDoc->linkIndex, szName, len);
+    if(pLink == NULL || pLink->fAmbiguous)
+      continue;
+    if(MdLinkIsPlain(szName, len) && !(pLink->fFunc && *sz == '('))
+      continue;
+    if(!pLink->fFunc && strlen(pLink->szPage) == lenPage && strncmp(pLink->szPage, szPage, lenPage) == 0)
+      continue;
+
+    // "name()" is linked whole
+    if(pLink->fFunc && sz[0] == '(' && sz[1] == ')')
+      sz += 2;
+    *psz    = sz;
+    *ppLink = pLink;
+    return szName;
+  }
+
+  *psz = sz;
+  return NULL;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Auto-link mentions of symbols in the HTML at the end of the page being written. Nothing is
+  copied unless there is something to link. See FlyDocLinkIndex().
+
+  @param    pDoc      flydoc state with page being written
+  @param    offset    offset of the HTML in pDoc->page to link, to end of page
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocLinkText(flyDoc_t *pDoc, size_t offset)
+{
+  flyDocPage_t       *pPage = &pDoc->page;
+  const flyDocLink_t *pLink = NULL;
+  const char         *szMention;
+  const char         *szEnd;
+  const char         *psz;
+  char               *szHtml;
+  unsigned            depth = 0;
+
+  if(pDoc->linkIndex.count == 0 || offset >= pPage->len)
+    return;
+
+  // find the 1st mention, in place
+  FlyDocPageSpace(pPage, 1)[0] = '\0';
+  psz = pPage->szBuf + offset;
+  szMention = MdLinkNext(pDoc, &psz, &depth, &pLink);
+  if(szMention == NULL)
+    return;
+
+  // copy the text from the 1st mention on, then put it back with the links
+  offset += (size_t)(szMention - (pPage->szBuf + offset));
+  szHtml = FlyDocAlloc(pPage->len - offset + 1);
+  memcpy(szHtml, pPage->szBuf + offset, pPage->len - offset);
+  szHtml[pPage->len - offset] = '\0';
+  szEnd = szHtml + (psz - szMention);
+  psz = szHtml;
+  pPage->len = offset;
+  do
+  {
+    FlyDocPageTpl(pPage, m_szLink, pLink->szRef, (int)(szEnd - psz), psz);
+    psz = szEnd;
+    szMention = MdLinkNext(pDoc, &szEnd, &depth, &pLink);
+    if(szMention)
+    {
+      FlyDocPageAppend(pPage, psz, (size_t)(szMention - psz));
+      psz = szMention;
+    }
+  } while(szMention);
+  FlyDocPageStr(pPage, psz);
+
+  FlyFreeIf(szHtml);
+}
@@ -123,6 +123,9 @@ void FlyDocWriteMarkdownModList(flyDoc_t *pDoc, flyDocModule_t *pList, const cha
 
   Basically, as-is exept headers which may increase level.
 
+  Markdown files not kept in memory (see FlyDocParseMarkdownFile()) are read again, written, then
+  freed one at a time, so only one document is in memory at once.
+
   @param  pDoc    flydoc state with open file ptr pDoc->fpOut
   @param  pList   text to write
   @param  level   level to add to any headers
@@ -131,6 +134,8 @@ void FlyDocWriteMarkdownModList(flyDoc_t *pDoc, flyDocModule_t *pList, const cha
 void FlyDocWriteMarkdownList(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdownList, unsigned level)
 {
   flyDocMarkdown_t *pMarkdown;
+  flyDocInFile_t    inFile;
+  const char       *szFile;
   const char       *szLine;
   const char       *szLineBeg;
   char             *szNext;
@@ -148,13 +153,28 @@ void FlyDocWriteMarkdownList(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdownList, un
   pMarkdown = pMarkdownList;
   while(pMarkdown)
   {
+    // read the markdown file again if not kept
+    memset(&inFile, 0, sizeof(inFile));
+    szFile = pMarkdown->szFile;
+    if(szFile == NULL)
+    {
+      FlyDocInFileRead(&inFile, pMarkdown->szPath);
+      szFile = inFile.szFile;
+      if(szFile == NULL)
+      {
+        FlyDocPrintWarning(pDoc, szWarningReadFile, pMarkdown->szPath);
+        pMarkdown = pMarkdown->pNext;
+        continue;
+      }
+    }
+
     // if not adding level to headers, just write the markdown file as-is
     if(level == 0)
-      fputs(pMarkdown->szFile, pDoc->fpOut);
+      fputs(szFile, pDoc->fpOut);
     else
     {
       // add level to each header
-      szLine = szLineBeg = pMarkdown->szFile;
+      szLine = szLineBeg = szFile;
       while(szLine && *szLine)
       {
         if(FlyMd2HtmlIsHeading(szLine, &thisLevel))
@@ -191,10 +211,11 @@ void FlyDocWriteMarkdownList(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdownList, un
     // if last line is not blank, add a line
     if(pMarkdown->pNext)
     {
-      len = strlen(pMarkdown->szFile);
-      if(len > 2 && (pMarkdown->szFile[len - 1] != '\n' || pMarkdown->szFile[len - 2] != '\n'))
+      len = strlen(szFile);
+      if(len > 2 && (szFile[len - 1] != '\n' || szFile[len - 2] != '\n'))
         fputs("\n", pDoc->fpOut);
     }
+    FlyDocInFileFree(&inFile);
 
     // on to next markdown file
     pMarkdown = pMarkdown->pNext;
@@ -202,14 +223,18 @@ void FlyDocWriteMarkdownList(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdownList, un
 }
 
 /*!------------------------------------------------------------------------------------------------
-  Write the pDoc to a single markdown file (everything)
+  Write the pDoc to a single markdown file (everything). The file is written as it is made, one
+  markdown document at a time, so memory use stays low. With `--changed` it is written to a
+  temporary file that only replaces the old one if it differs, see FlyDocFileWriteDone(). If used
+  as a library with an output callback, the file is built in memory for the callback.
 
-  @param  pDoc    flydoc state with open file ptr pDoc->fpOut
-  @return none
+  @param  pDoc    flydoc state
+  @return TRUE if worked, FALSE if couldn't create file
 -------------------------------------------------------------------------------------------------*/
 bool_t FlyDocWriteMarkdown(flyDoc_t *pDoc)
 {
   static const char szMdExt[] = ".md";
+  static const char szTmpExt[] = ".tmp";
   flyDocMainPage_t *pMainPage = pDoc->pMainPage;
   unsigned          level = 0;
   unsigned          countMods;
@@ -217,10 +242,18 @@ bool_t FlyDocWriteMarkdown(flyDoc_t *pDoc)
   unsigned          size;
   char             *szNameLast;
   char             *szOutFile;
+  char             *szTmpFile = NULL;
   char             *szFullPath;
+  char             *szBuf = NULL;
+  size_t            lenBuf = 0;
+  long              lenOut;
+  uint64_t          nsStart = 0;
+  bool_t            fWorked;
 
   if(pDoc->opts.debug)
     printf("-- FlyDocWriteMarkdown(%s) ---\n", pDoc->opts.szOut);
+  if(pDoc->opts.fProfile)
+    nsStart = FlyDocProfNow();
 
   // create the folder
   if(!FlyDocCreateFolder(pDoc, pDoc->opts.szOut))
@@ -241,13 +274,28 @@ bool_t FlyDocWriteMarkdown(flyDoc_t *pDoc)
   FlyStrZCpy(szOutFile, pDoc->opts.szOut, size);
   FlyStrPathAppend(szOutFile, szNameLast, size);
   FlyStrZCat(szOutFile, szMdExt, size);
-  printf("  %s\n", szOutFile);
+  if(pDoc->opts.verbose)
+    printf("  %s\n", szOutFile);
 
-  // open the file to write
-  pDoc->fpOut = fopen(szOutFile, "w");
+  // library: build the file in memory; --changed: write to a temporary file to compare
+  if(pDoc->pfnOut)
+    pDoc->fpOut = open_memstream(&szBuf, &lenBuf);
+  else
+  {
+    if(pDoc->opts.fChanged)
+    {
+      szTmpFile = FlyDocAlloc(size + sizeof(szTmpExt));
+      FlyStrZCpy(szTmpFile, szOutFile, size + sizeof(szTmpExt));
+      FlyStrZCat(szTmpFile, szTmpExt, size + sizeof(szTmpExt));
+    }
+    pDoc->fpOut = fopen(szTmpFile ? szTmpFile : szOutFile, "w");
+  }
   if(!pDoc->fpOut)
   {
     FlyDocPrintWarning(pDoc, szWarningCreateFile, szOutFile);
+    FlyFreeIf(szTmpFile);
+    FlyFreeIf(szOutFile);
+    FlyFreeIf(szFullPath);
     return FALSE;
   }
 
@@ -295,8 +343,27 @@ bool_t FlyDocWriteMarkdown(flyDoc_t *pDoc)
   FlyDocWriteMarkdownModList(pDoc, pDoc->pClassList, "Class ", level);
   FlyDocWriteMarkdownList(pDoc, pDoc->pMarkdownList, level);
 
+  // finish the file
+  lenOut = ftell(pDoc->fpOut);
+  fWorked = (fclose(pDoc->fpOut) == 0) ? TRUE : FALSE;
+  pDoc->fpOut = NULL;
+  if(fWorked && pDoc->pfnOut)
+    fWorked = FlyDocFileWrite(pDoc, szOutFile, szBuf ? szBuf : "", lenBuf);
+  else if(fWorked)
+    fWorked = FlyDocFileWriteDone(pDoc, szOutFile, szTmpFile ? szTmpFile : szOutFile);
+  if(!fWorked)
+  {
+    if(szTmpFile)
+      remove(szTmpFile);
+    FlyDocPrintWarning(pDoc, szWarningCreateFile, szOutFile);
+  }
+  if(pDoc->pProf)
+    FlyDocProfPage(pDoc, szOutFile, FlyDocProfNow() - nsStart, lenOut > 0 ? (size_t)lenOut : 0);
+
+  free(szBuf);
+  FlyFreeIf(szTmpFile);
   FlyFreeIf(szOutFile);
   FlyFreeIf(szFullPath);
 
-  return TRUE;
+  return fWorked;
 }
@@ -0,0 +1,169 @@
+/**************************************************************************************************
+  flydocpage.c - Page writer: builds an output page in memory, then writes it all at once
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <stdarg.h>
+#include "flydoc.h"
+
+#define FLYDOC_PAGE_MIN   (64 * 1024)   // initial size of a page buffer
+
+/*!
+  @defgroup flydoc_page   Page writer: builds an output page in memory, then writes it all at once
+
+  Each HTML page is a few hundred small pieces: template fragments, titles, links and HTML converted
+  from markdown. Rather than an fprintf() per piece, each with its own format parsing and its own
+  return value to check, pieces are appended to a flyDocPage_t. Appending can't fail (out of memory
+  asserts), so the only thing that can fail is FlyDocPageWrite(), which writes the whole page at
+  once. With `--changed`, that is also where the page is compared to the one already there.
+
+  The buffer is kept from page to page, so after the first few pages there is no allocation at all.
+*/
+
+/*!------------------------------------------------------------------------------------------------
+  Make room for at least n more bytes (plus a '\0') at the end of the page.
+
+  @param    pPage     page
+  @param    n         number of bytes about to be appended
+  @return   ptr to end of page, with at least n + 1 bytes available
+-------------------------------------------------------------------------------------------------*/
+char * FlyDocPageSpace(flyDocPage_t *pPage, size_t n)
+{
+  char   *szNew;
+  size_t  size;
+
+  if(pPage->size - pPage->len <= n)
+  {
+    size = pPage->size ? pPage->size : FLYDOC_PAGE_MIN;
+    while(size - pPage->len <= n)
+      size *= 2;
+    szNew = FlyDocAlloc(size);
+    if(pPage->len)
+      memcpy(szNew, pPage->szBuf, pPage->len);
+    FlyFreeIf(pPage->szBuf);
+    pPage->szBuf = szNew;
+    pPage->size  = size;
+  }
+
+  return pPage->szBuf + pPage->len;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Append bytes to the page.
+
+  @param    pPage     page
+  @param    pData     data to append, need not be '\0' terminated
+  @param    len       length of data
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocPageAppend(flyDocPage_t *pPage, const void *pData, size_t len)
+{
+  memcpy(FlyDocPageSpace(pPage, len), pData, len);
+  pPage->len += len;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Append a '\0' terminated string to the page.
+
+  @param    pPage     page
+  @param    sz        string to append
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocPageStr(flyDocPage_t *pPage, const char *sz)
+{
+  FlyDocPageAppend(pPage, sz, strlen(sz));
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Append a template to the page, filling in its holes from the arguments in order. Text between
+  holes is copied as-is. A template only understands the holes flydoc uses:
+
+  Hole   | Argument
+  ------ | --------
+  `%s`   | const char *, NULL is the same as ""
+  `%u`   | unsigned
+  `%.*s` | int length, then const char *
+
+  @param    pPage     page
+  @param    szTpl     template, e.g. "<a href=\"%s\">%s</a>"
+  @param    ...       one argument per hole
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocPageTpl(flyDocPage_t *pPage, const char *szTpl, ...)
+{
+  va_list       args;
+  const char   *pszHole;
+  const char   *sz;
+  char          szNum[12];
+  int           len;
+
+  va_start(args, szTpl);
+  while(*szTpl)
+  {
+    pszHole = strchr(szTpl, '%');
+    if(pszHole == NULL)
+    {
+      FlyDocPageStr(pPage, szTpl);
+      break;
+    }
+    if(pszHole > szTpl)
+      FlyDocPageAppend(pPage, szTpl, (size_t)(pszHole - szTpl));
+
+    if(pszHole[1] == 's')
+    {
+      sz = va_arg(args, const char *);
+      if(sz)
+        FlyDocPageStr(pPage, sz);
+      szTpl = pszHole + 2;
+    }
+    else if(pszHole[1] == 'u')
+    {
+      len = snprintf(szNum, sizeof(szNum), "%u", va_arg(args, unsigned));
+      FlyDocPageAppend(pPage, szNum, (size_t)len);
+      szTpl = pszHole + 2;
+    }
+    else
+    {
+      FlyAssert(strncmp(pszHole, "%.*s", 4) == 0);
+      len = va_arg(args, int);
+      sz  = va_arg(args, const char *);
+      FlyDocPageAppend(pPage, sz, (size_t)len);
+      szTpl = pszHole + 4;
+    }
+  }
+  va_end(args);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write the page to a file and empty it, ready for the next page. With `--changed`, the file is
+  left alone if it already has the same contents. See FlyDocFileWrite().
+
+  @param    pDoc      flydoc state with opts
+  @param    pPage     page
+  @param    szPath    path to file
+  @return   TRUE if worked, FALSE if couldn't write file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocPageWrite(const flyDoc_t *pDoc, flyDocPage_t *pPage, const char *szPath)
+{
+  bool_t  fWorked;
+
+  fWorked = FlyDocFileWrite(pDoc, szPath, pPage->szBuf ? pPage->szBuf : "", pPage->len);
+  if(pPage->nsStart)
+    pPage->nsLast = FlyDocProfNow() - pPage->nsStart;
+  pPage->lenLast = pPage->len;
+  pPage->len     = 0;
+
+  return fWorked;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Free the page buffer. OK if already freed.
+
+  @param    pPage     page
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocPageFree(flyDocPage_t *pPage)
+{
+  FlyFreeIf(pPage->szBuf);
+  memset(pPage, 0, sizeof(*pPage));
+}
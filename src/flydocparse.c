@@ -4,6 +4,7 @@
   License MIT <https://mit-license.org>
 **************************************************************************************************/
 #include <sys/stat.h>
+#include <fnmatch.h>
 #include "flydoc.h"
 #include "FlyCli.h"
 #include "FlyFile.h"
@@ -39,7 +40,7 @@ static const char m_szMarkdownExts[] = ".md.mdown.markdown";
 -------------------------------------------------------------------------------------------------*/
 const char * FlyDocIsKeyword(const char *szLine, flyDocKeyword_t *pKeyword)
 {
-  // IMPORTANT! Adjust enum flyDocKeyword_t to match
+  // IMPORTANT! Adjust enum flyDocKeyword_t and the switch below to match
   static const char *aszKeywords[] =
   {
     "@class",    // @class    name description
@@ -67,15 +68,37 @@ const char * FlyDocIsKeyword(const char *szLine, flyDocKeyword_t *pKeyword)
   if(*szLine == '@')
   {
     fIsKeyword  = TRUE;
-    for(i = 0; i < NumElements(aszKeywords); ++i)
+
+    // keyword must be followed by whitespace, so length of word and a letter or two picks the only
+    // possible keyword; no need to compare against all of them
+    for(len = 1; szLine[len] && !isspace(szLine[len]); ++len)
+      ;
+    switch(len)
     {
-      len = strlen(aszKeywords[i]);
-      if((strncmp(szLine, aszKeywords[i], len) == 0) && isspace(szLine[len]))
-      {
-        keyword = (flyDocKeyword_t)i;
-        break;
-      }
+      case 3:  i = FLYDOC_KEYWORD_FN; break;
+      case 5:  i = (szLine[1] == 'f') ? FLYDOC_KEYWORD_FONT : FLYDOC_KEYWORD_LOGO; break;
+      case 6:
+        if(szLine[1] == 'c')
+          i = (szLine[2] == 'l') ? FLYDOC_KEYWORD_CLASS : FLYDOC_KEYWORD_COLOR;
+        else
+          i = FLYDOC_KEYWORD_PARAM;
+      break;
+      case 7:  i = FLYDOC_KEYWORD_RETURN; break;
+      case 8:
+        if(szLine[1] == 'e')
+          i = FLYDOC_KEYWORD_EXAMPLE;
+        else if(szLine[1] == 'r')
+          i = FLYDOC_KEYWORD_RETURNS;
+        else if(szLine[1] == 'v')
+          i = FLYDOC_KEYWORD_VERSION;
+        else
+          i = (szLine[3] == 'c') ? FLYDOC_KEYWORD_INCLASS : FLYDOC_KEYWORD_INGROUP;
+      break;
+      case 9:  i = (szLine[1] == 'd') ? FLYDOC_KEYWORD_DEFGROUP : FLYDOC_KEYWORD_MAINPAGE; break;
+      default: i = FLYDOC_KEYWORD_UNKNOWN; break;
     }
+    if(i < NumElements(aszKeywords) && isspace(szLine[len]) && strncmp(szLine, aszKeywords[i], len) == 0)
+      keyword = (flyDocKeyword_t)i;
 
     if(pKeyword)
       *pKeyword = keyword;
@@ -136,7 +159,7 @@ const char * FlyDocFixupPos(flyDoc_t *pDoc, const char *szPos)
   const char *pszFilePos = szPos;
 
   // if position is already in the file, we're done
-  if(!(szPos >= pDoc->szFile && szPos <= pDoc->szFile + strlen(pDoc->szFile)))
+  if(!(szPos >= pDoc->szFile && szPos <= pDoc->szFile + pDoc->lenFile))
   {
     if(pDoc->pCurHdr)
     {
@@ -168,29 +191,6 @@ unsigned FlyDocMakeNameBase(char *szNameBase, const char *szTitle, size_t size)
   return len;
 }
 
-/*!------------------------------------------------------------------------------------------------
-  Calculate space needed for text field adding 2 spaces per line for markdown line break.
-
-  Allows room for '\0' and 2 spaces per line, in addition to what's in each line.
-
-  @param    szLine    ptr to a line in the comment header
-  @param    szEnd     end of section to process
-  @return   total size of text area
--------------------------------------------------------------------------------------------------*/
-size_t FlyDocTextLenCalc(const char *szLine, const char *szEnd)
-{
-  size_t    size = (szEnd - szLine) + 1;
-  unsigned  extra = strlen(szFlyDocExtra);
-
-  while(*szLine && szLine < szEnd)
-  {
-    size += extra;
-    szLine = FlyStrLineNext(szLine);
-  }
-
-  return size;
-}
-
 /*!------------------------------------------------------------------------------------------------
   Returns TRUE if this line has at least 2 spaces at end. 
 
@@ -332,21 +332,18 @@ bool_t FlyDocGetNameDescription(const char *szLine, const char **ppszName, const
 
   would return "snake_case_name"
 
+  @param    pDoc        document state with arena
   @param    szCName     pointer to the CName variable
   @return   allocated C Name, or NULL if not a CName
 -------------------------------------------------------------------------------------------------*/
-char * FlyDocCNameAlloc(const char *sz)
+char * FlyDocCNameAlloc(flyDoc_t *pDoc, const char *sz)
 {
   char       *szCName = NULL;
   unsigned    len;
 
   len = FlyStrCNameLen(sz);
   if(len)
-  {
-    szCName = FlyAlloc(len + 1);
-    if(szCName)
-      FlyStrZNCpy(szCName, sz, len + 1, len);
-  }
+    szCName = FlyDocArenaStrAllocN(&pDoc->arena, sz, len);
 
   return szCName;
 }
@@ -354,50 +351,13 @@ char * FlyDocCNameAlloc(const char *sz)
 /*!------------------------------------------------------------------------------------------------
   Allocate a copy of string to end of line
 
+  @param    pDoc    document state with arena
   @param    sz      string
-  @return   ptr to allocated string or NULL if failed
--------------------------------------------------------------------------------------------------*/
-char * FlyDocAllocToLineEnd(const char *sz)
-{
-  char     *szNew;
-  unsigned  len;
-
-  len = FlyStrLineEnd(sz) - sz;
-  szNew = FlyAlloc(len + 1);
-  if(szNew)
-  {
-    if(len)
-      strncpy(szNew, sz, len);
-    szNew[len] = '\0';
-  }
-
-  return szNew;
-}
-
-/*!------------------------------------------------------------------------------------------------
-  Create a new function for a module or class
-
-  @param    pList      list of functions for this module (may be NULL if 1st)
-  @param    szCName    ptr to allocated or static string
-  @param    szModule   ptr to allocated or static string
-  @return   TRUE if worked, FALSE if there was an error
+  @return   ptr to allocated string
 -------------------------------------------------------------------------------------------------*/
-flyDocFunc_t * FlyDocFuncFree(flyDocFunc_t *pFunc)
+char * FlyDocAllocToLineEnd(flyDoc_t *pDoc, const char *sz)
 {
-  if(pFunc)
-  {
-    if(pFunc->szFunc)
-      FlyFree(pFunc->szFunc);
-    if(pFunc->szBrief)
-      FlyFree(pFunc->szBrief);
-    if(pFunc->szPrototype)
-      FlyFree(pFunc->szPrototype);
-    if(pFunc->szText)
-      FlyFree(pFunc->szText);
-    memset(pFunc, 0, sizeof(*pFunc));
-  }
-
-  return NULL;
+  return FlyDocArenaStrAllocN(&pDoc->arena, sz, FlyStrLineEnd(sz) - sz);
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -405,10 +365,11 @@ flyDocFunc_t * FlyDocFuncFree(flyDocFunc_t *pFunc)
 
   szFunc can point "main(int argc..." or "main   (..." or "main"
 
+  @param    pDoc      document state with arena
   @param    szFunc    name of function may or may not be '\0' terminated
-  @return   ptr to function or NULL
+  @return   ptr to function or NULL if not a CName
 -------------------------------------------------------------------------------------------------*/
-flyDocFunc_t * FlyDocFuncNew(const char *szFunc)
+flyDocFunc_t * FlyDocFuncNew(flyDoc_t *pDoc, const char *szFunc)
 {
   flyDocFunc_t *pFunc = NULL;
   unsigned      len = 0;
@@ -417,14 +378,9 @@ flyDocFunc_t * FlyDocFuncNew(const char *szFunc)
     len = FlyStrCNameLen(szFunc);
   if(len)
   {
-    pFunc = FlyAlloc(sizeof(*pFunc));
-    if(pFunc)
-    {
-      memset(pFunc, 0, sizeof(*pFunc));
-      pFunc->szFunc  = FlyStrAllocN(szFunc, len);
-      if(!pFunc->szFunc)
-        pFunc = FlyDocFuncFree(pFunc);
-    }
+    pFunc = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pFunc));
+    pFunc->szFunc = FlyDocArenaStrAllocN(&pDoc->arena, szFunc, len);
+    pFunc->szRef  = FlyDocRefNew(&pDoc->arena, pFunc->szFunc);
   }
 
   return pFunc;
@@ -446,23 +402,6 @@ int FlyDocFuncListCmp(const void *pThis, const void *pThat)
   return strcasecmp(pFunc1->szFunc, pFunc2->szFunc);
 }
 
-/*!------------------------------------------------------------------------------------------------
-  Add this function to the list.
-
-  @param    pList   list of functions for this module (may be NULL if 1st)
-  @param    pFunc   a function object to add to list
-  @return   ptr new list
--------------------------------------------------------------------------------------------------*/
-flyDocFunc_t * FlyDocFuncListAdd(flyDocFunc_t *pList, flyDocFunc_t *pFunc, bool_t fSort)
-{
-  if(fSort)
-    pList = FlyListAddSorted(pList, pFunc, FlyDocFuncListCmp);
-  else
-    pList = FlyListAppend(pList, pFunc);
-
-  return pList;
-}
-
 /*!------------------------------------------------------------------------------------------------
   Is this in the function list?
 
@@ -487,31 +426,14 @@ flyDocFunc_t * FlyDocFuncInList(flyDocFunc_t *pList, const char *szFunc)
   return pFunc;
 }
 
-/*!------------------------------------------------------------------------------------------------
-  Free an example
-
-  @param    pExample  ptr to example
-  @return   NULL
--------------------------------------------------------------------------------------------------*/
-flyDocExample_t * FlyDocExampleFree(flyDocExample_t *pExample)
-{
-  if(pExample)
-  {
-    if(pExample->szTitle)
-      FlyFree(pExample->szTitle);
-    memset(pExample, 0, sizeof(*pExample));
-  }
-
-  return NULL;
-}
-
 /*!------------------------------------------------------------------------------------------------
   Create a new example
 
+  @param    pDoc      document state with arena
   @param    szTitle   title of the example, line or '\0' terminated
-  @return   ptr to example or NULL if couldn't allocat ememory
+  @return   ptr to example or NULL if no title
 -------------------------------------------------------------------------------------------------*/
-flyDocExample_t * FlyDocExampleNew(const char *szTitle)
+flyDocExample_t * FlyDocExampleNew(flyDoc_t *pDoc, const char *szTitle)
 {
   const char        szExamplePrefix[] = "Example: ";
   unsigned          size;
@@ -521,21 +443,12 @@ flyDocExample_t * FlyDocExampleNew(const char *szTitle)
   titleLen = FlyStrLineLen(szTitle);
   if(szTitle)
   {
-    pExample = FlyAlloc(sizeof(*pExample));
-    if(pExample)
-    {
-      memset(pExample, 0, sizeof(*pExample));
-      size = sizeof(szExamplePrefix) + titleLen;
-      pExample->szTitle = FlyAlloc(size);
-      if(pExample->szTitle == NULL)
-        pExample = FlyDocExampleFree(pExample);
-      else
-      {
-        FlyStrZCpy(pExample->szTitle, szExamplePrefix, size);
-        FlyStrZNCat(pExample->szTitle, szTitle, size, titleLen);
-        FlyStrBlankRemove(pExample->szTitle);
-      }
-    }
+    pExample = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pExample));
+    size = sizeof(szExamplePrefix) + titleLen;
+    pExample->szTitle = FlyDocArenaAlloc(&pDoc->arena, size);
+    FlyStrZCpy(pExample->szTitle, szExamplePrefix, size);
+    FlyStrZNCat(pExample->szTitle, szTitle, size, titleLen);
+    FlyStrBlankRemove(pExample->szTitle);
   }
 
   return pExample;
@@ -565,57 +478,14 @@ flyDocExample_t * FlyDocExampleInList(flyDocExample_t *pList, const char *szTitl
   return pExample;
 }
 
-/*!------------------------------------------------------------------------------------------------
-  Free the module and all it's fields
-
-  @param    pSection    the section to free
-  @return   ptr to new head of list
--------------------------------------------------------------------------------------------------*/
-void FlyDocSectionFree(flyDocSection_t *pSection)
-{
-  if(pSection->szTitle)
-    FlyFree(pSection->szTitle);
-  if(pSection->szSubtitle)
-    FlyFree(pSection->szSubtitle);
-  if(pSection->szText)
-    FlyFree(pSection->szText);
-  if(pSection->szVersion)
-    FlyFree(pSection->szVersion);
-  if(pSection->szBarColor)
-    FlyFree(pSection->szBarColor);
-  if(pSection->szTitleColor)
-    FlyFree(pSection->szTitleColor);
-  if(pSection->szLogo)
-    FlyFree(pSection->szLogo);
-  memset(pSection, 0, sizeof(*pSection));
-}
-
-/*!------------------------------------------------------------------------------------------------
-  Free the module and all it's fields
-
-  @param    pMod    The module to free
-  @return   ptr to new head of list
--------------------------------------------------------------------------------------------------*/
-flyDocModule_t * FlyDocModFree(flyDocModule_t *pMod)
-{
-  if(pMod)
-  {
-    FlyDocSectionFree(&pMod->section);
-
-    // TODO: free chain of functions and examples
-    FlyFree(pMod);
-  }
-
-  return NULL;
-}
-
 /*!------------------------------------------------------------------------------------------------
   Create a new module
 
+  @param    pDoc      document state with arena
   @param    szTitle   ptr to CName title, need not be '\0' terminated
-  @return   ptr to new head of list
+  @return   ptr to new module or NULL if no title
 -------------------------------------------------------------------------------------------------*/
-flyDocModule_t * FlyDocModNew(const char *szTitle)
+flyDocModule_t * FlyDocModNew(flyDoc_t *pDoc, const char *szTitle)
 {
   flyDocModule_t *pMod = NULL;
   size_t          len;
@@ -625,14 +495,8 @@ flyDocModule_t * FlyDocModNew(const char *szTitle)
     len = FlyStrArgLen(szTitle);
     if(len)
     {
-      pMod = FlyAlloc(sizeof(*pMod));
-      if(pMod)
-      {
-        memset(pMod, 0, sizeof(*pMod));
-        pMod->section.szTitle = FlyStrAllocN(szTitle, len);
-        if(!pMod->section.szTitle)
-          pMod = FlyDocModFree(pMod);
-      }
+      pMod = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pMod));
+      pMod->section.szTitle = FlyDocArenaStrAllocN(&pDoc->arena, szTitle, len);
     }
   }
 
@@ -656,43 +520,21 @@ int FlyDocModListCmp(const void *pThis, const void *pThat)
 }
 
 /*!------------------------------------------------------------------------------------------------
-  Add the allocated module to the list.
+  Add the allocated module or class to pDoc, both to the list and the index. See FlyDocModFind().
+  Lists are in parse order until sorted by FlyDocSortLists().
 
-  @param    pList   list of modules or classes
-  @return   ptr to new head of list
+  @param    pDoc    document state
+  @param    pMod    allocated module or class
+  @param    fClass  TRUE if a class, FALSE if a module
+  @return   none
 -------------------------------------------------------------------------------------------------*/
-flyDocModule_t * FlyDocModListAdd(flyDocModule_t *pList, flyDocModule_t *pMod, bool_t fSort)
+void FlyDocModAdd(flyDoc_t *pDoc, flyDocModule_t *pMod, bool_t fClass)
 {
-  if(fSort)
-    pList = FlyListAddSorted(pList, pMod, FlyDocModListCmp);
+  if(fClass)
+    pDoc->pClassList = FlyListAppend(pDoc->pClassList, pMod);
   else
-    pList = FlyListAppend(pList, pMod);
-
-  return pList;
-}
-
-/*!------------------------------------------------------------------------------------------------
-  Is this title found in the module or class list?
-
-  @param    pList      list of modules or classes
-  @param    szTitle    a CName title string
-  @return   ptr function or NULL if not found
--------------------------------------------------------------------------------------------------*/
-flyDocModule_t * FlyDocModInList(const flyDocModule_t *pList, const char *szTitle)
-{
-  flyDocModule_t *pMod = NULL;
-
-  while(pList)
-  {
-    if(strcmp(szTitle, pList->section.szTitle) == 0)
-    {
-      pMod = (flyDocModule_t *)pList;
-      break;
-    }
-    pList = pList->pNext;
-  }
-
-  return pMod;
+    pDoc->pModList = FlyListAppend(pDoc->pModList, pMod);
+  FlyDocIndexMod(pDoc, pMod, fClass);
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -815,20 +657,17 @@ void FlyDocParseColor(flyDoc_t *pDoc, const char *pszArg, flyDocSection_t *pSect
   argLen = FlyStrArgLen(pszArg);
   if(argLen)
   {
-    pSection->szBarColor = FlyStrAllocN(pszArg, argLen);
-    FlyDocAllocCheck(pSection->szBarColor);
+    pSection->szBarColor = FlyDocArenaStrAllocN(&pDoc->arena, pszArg, argLen);
     pszArg = FlyStrArgNext(pszArg);
     argLen = FlyStrArgLen(pszArg);
     if(argLen)
     {
-      pSection->szTitleColor = FlyStrAllocN(pszArg, argLen);
-      FlyDocAllocCheck(pSection->szTitleColor);
+      pSection->szTitleColor = FlyDocArenaStrAllocN(&pDoc->arena, pszArg, argLen);
       pszArg = FlyStrArgNext(pszArg);
       argLen = FlyStrArgLen(pszArg);
       if(argLen)
       {
-        szHeadingColor = pSection->szHeadingColor = FlyStrAllocN(pszArg, argLen);
-        FlyDocAllocCheck(pSection->szHeadingColor);
+        szHeadingColor = pSection->szHeadingColor = FlyDocArenaStrAllocN(&pDoc->arena, pszArg, argLen);
       }
     }
   }
@@ -837,7 +676,7 @@ void FlyDocParseColor(flyDoc_t *pDoc, const char *pszArg, flyDocSection_t *pSect
   if(pSection->szBarColor && !szHeadingColor)
   {
     psz = pSection->szBarColor + 3;   // skip "w3-"
-    pSection->szHeadingColor = FlyDocAlloc(sizeof(szHeadingClass) + strlen(psz));
+    pSection->szHeadingColor = FlyDocArenaAlloc(&pDoc->arena, sizeof(szHeadingClass) + strlen(psz));
     {
       strcpy(pSection->szHeadingColor, szHeadingClass);
       strcat(pSection->szHeadingColor, psz);
@@ -863,29 +702,12 @@ void FlyDocParseFont(flyDoc_t *pDoc, const char *pszArg, char **ppszFontBody, ch
   argLen = FlyStrArgLen(pszArg);
   if(argLen)
   {
-    *ppszFontBody = FlyStrAllocN(pszArg, argLen);
+    *ppszFontBody = FlyDocArenaStrAllocN(&pDoc->arena, pszArg, argLen);
     pszArg = FlyStrArgNext(pszArg);
     argLen = FlyStrArgLen(pszArg);
     if(argLen)
-      *ppszFontHeadings = FlyStrAllocN(pszArg, argLen);  
-  }
-}
-
-/*!------------------------------------------------------------------------------------------------
-  Free the image structure. Does not remove fron any list.
-
-  @param    pImage    ponter to flyDocImage_t structure
-  @return   ptr to allocated and filled in image structure
--------------------------------------------------------------------------------------------------*/
-flyDocImage_t * FlyDocImageFree(flyDocImage_t *pImage)
-{
-  if(pImage)
-  {
-    if(pImage->szLink)
-      FlyFree(pImage->szLink);
-    FlyFree(pImage);
+      *ppszFontHeadings = FlyDocArenaStrAllocN(&pDoc->arena, pszArg, argLen);
   }
-  return NULL;
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -907,9 +729,8 @@ flyDocImage_t * FlyDocImageAlloc(flyDoc_t *pDoc, const char *szMdImage)
   FlyAssert(altLink.refType == MD_REF_TYPE_IMAGE && altLink.szLink && altLink.linkLen);
 
   // should not get here unless it's an image
-  pImage = FlyAllocZ(sizeof(*pImage));
-  if(pImage)
-    pImage->szLink = FlyStrAllocN(altLink.szLink, altLink.linkLen);
+  pImage = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pImage));
+  pImage->szLink = FlyDocArenaStrAllocN(&pDoc->arena, altLink.szLink, altLink.linkLen);
 
   return pImage;
 }
@@ -937,32 +758,25 @@ bool_t FlyDocImageHasPath(const char *szLink)
 
   If the link/URL has a path part it is ignored as it's assumed it's handled outside of flydoc.
 
-  @param    pImgFileList    image file list
+  @param    pDoc            document state with pImgFileList and imgIndex
   @param    szLink          e.g. "http://foo.com/path/image.png" or "file.jpeg"
+  @param    fReference      mark the image file as referenced if found
   @return   FALSE if expected to find file but didn't
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocImageFileFind(flyDocFile_t  *pImgFileList, const char *szLink)
+bool_t FlyDocImageFileFind(const flyDoc_t *pDoc, const char *szLink, bool_t fReference)
 {
-  flyDocFile_t   *pImgFile  = pImgFileList;
+  flyDocFile_t   *pImgFile;
   bool_t          fOk       = TRUE;
-  bool_t          fFound    = FALSE;
 
   // ignore links with paths
   if(strchr(szLink, '/') == NULL)
   {
-    while(pImgFile)
-    {
-      // if link is the same as the image file namem then it's found and referenced
-      if(strcmp(FlyStrPathNameOnly(pImgFile->szPath), szLink) == 0)
-      {
-        pImgFile->fReferenced = TRUE;
-        fFound = TRUE;
-        break;
-      }
-      pImgFile = pImgFile->pNext;
-    }
-    if(!fFound)
+    // if link is the same as the image file name then it's found and referenced
+    pImgFile = FlyDocImgFileFind(pDoc, szLink);
+    if(pImgFile == NULL)
       fOk = FALSE;
+    else if(fReference)
+      pImgFile->fReferenced = TRUE;
   }
 
   return fOk;
@@ -994,7 +808,8 @@ const char * FlyDocParseImage(flyDoc_t *pDoc, const char *pszMdImage)
   if(!FlyDocImageHasPath(pImage->szLink))
   {
     // for simple img links, warn if the image file doesn't exist in the list of input images
-    if(!FlyDocImageFileFind(pDoc->pImgFileList, pImage->szLink))
+    // partial docs only read the shared image list, references are marked when merged
+    if(!FlyDocImageFileFind(pDoc, pImage->szLink, !pDoc->fPartial))
       FlyDocPrintWarningEx(pDoc, szWarningNoImage, pImage->szLink, pDoc->szFile, FlyDocFixupPos(pDoc, pszMdImage));
   }
 
@@ -1026,7 +841,7 @@ void FlyDocParseLogo(flyDoc_t *pDoc, const char *pszArg, char **ppszLogo)
   else
   {
     pszAfter = FlyDocParseImage(pDoc, pszArg);
-    *ppszLogo = FlyStrAllocN(pszArg, pszAfter - pszArg);
+    *ppszLogo = FlyDocArenaStrAllocN(&pDoc->arena, pszArg, pszAfter - pszArg);
   }
 }
 
@@ -1044,7 +859,6 @@ void FlyDocParseLogo(flyDoc_t *pDoc, const char *pszArg, char **ppszLogo)
 bool_t FlyDocParseInGroup(flyDoc_t *pDoc, const char *szLine)
 {
   flyDocKeyword_t   keyword;
-  flyDocModule_t   *pList;
   flyDocModule_t   *pMod;
   const char       *szArg;
   char             *szModName = NULL;
@@ -1057,7 +871,7 @@ bool_t FlyDocParseInGroup(flyDoc_t *pDoc, const char *szLine)
   FlyAssert(szArg && (keyword == FLYDOC_KEYWORD_INCLASS || keyword == FLYDOC_KEYWORD_INGROUP));
 
   // make sure the arg is a valid CName, allocate the string if it is
-  szModName = FlyDocCNameAlloc(szArg);
+  szModName = FlyDocCNameAlloc(pDoc, szArg);
   if(!szModName)
   {
     FlyDocPrintWarningEx(pDoc, szWarningSyntax, NULL, pDoc->szFile, FlyDocFixupPos(pDoc, szArg));
@@ -1068,20 +882,14 @@ bool_t FlyDocParseInGroup(flyDoc_t *pDoc, const char *szLine)
   else
   {
     // does the module already exist? great! we can use it
-    pList = (keyword == FLYDOC_KEYWORD_INCLASS) ? pDoc->pClassList : pDoc->pModList;
-    pMod = FlyDocModInList(pList, szModName);
+    pMod = FlyDocModFind(pDoc, szModName, (keyword == FLYDOC_KEYWORD_INCLASS));
 
     // create stub module/class if it doesn't already exist
     if(pMod == NULL)
     {
-      pMod = FlyDocModNew(szModName);
+      pMod = FlyDocModNew(pDoc, szModName);
       if(pMod)
-      {
-        if(keyword == FLYDOC_KEYWORD_INCLASS)
-          pDoc->pClassList = FlyDocModListAdd(pDoc->pClassList, pMod, pDoc->opts.fSort);
-        else
-          pDoc->pModList = FlyDocModListAdd(pDoc->pModList, pMod, pDoc->opts.fSort);
-      }
+        FlyDocModAdd(pDoc, pMod, (keyword == FLYDOC_KEYWORD_INCLASS));
     }
 
     // adjust current module for all other processing
@@ -1146,7 +954,7 @@ const char * FlyDocParseExample(flyDoc_t *pDoc, flyDocSection_t *pSection, const
   }
 
   // allocate example
-  pExample = FlyDocExampleNew(szTitle);
+  pExample = FlyDocExampleNew(pDoc, szTitle);
   FlyDocAllocCheck(pExample);
   *ppExample = pExample;
 
@@ -1213,6 +1021,35 @@ static void MdParseTextForImages(flyDoc_t *pDoc, const char *szText, const char
   }
 }
 
+/*-------------------------------------------------------------------------------------------------
+  Copy lines of text, leaving out known keyword lines other than @example. See FlyDocParseText().
+
+  @param    psz       where to copy to
+  @param    szLine    1st line to copy
+  @param    szEnd     copy up to here
+  @return   ptr to after copied text (not '\0' terminated)
+-------------------------------------------------------------------------------------------------*/
+static char * MdTextCopy(char *psz, const char *szLine, const char *szEnd)
+{
+  flyDocKeyword_t   keyword;
+  const char       *szNext;
+
+  while(*szLine && szLine < szEnd)
+  {
+    szNext = FlyStrLineNext(szLine);
+    if(szNext > szEnd)
+      szNext = szEnd;
+    if(!(FlyDocIsKeyword(szLine, &keyword) && keyword != FLYDOC_KEYWORD_EXAMPLE && keyword != FLYDOC_KEYWORD_UNKNOWN))
+    {
+      memcpy(psz, szLine, szNext - szLine);
+      psz += szNext - szLine;
+    }
+    szLine = szNext;
+  }
+
+  return psz;
+}
+
 /*-------------------------------------------------------------------------------------------------
   Parse style keywords for the section: @color, @font, @logo, @version
 
@@ -1233,7 +1070,7 @@ static void MdParseStyleKeyword(flyDoc_t *pDoc, flyDocSection_t *pSection, const
   else if(keyword == FLYDOC_KEYWORD_LOGO)
     FlyDocParseLogo(pDoc, pszArg, &pSection->szLogo);
   else if(keyword == FLYDOC_KEYWORD_VERSION)
-    pSection->szVersion = FlyDocAllocToLineEnd(pszArg);
+    pSection->szVersion = FlyDocAllocToLineEnd(pDoc, pszArg);
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -1256,13 +1093,13 @@ char * FlyDocParseText(flyDoc_t *pDoc, flyDocSection_t *pSection, const char *sz
 {
   char             *szText        = NULL;
   const char       *szLine        = NULL;
+  const char       *szNext;
   const char       *szEndExample  = NULL;
   const char       *pszArg        = NULL;
   char             *psz           = NULL;
   flyDocExample_t  *pExample      = NULL;
   flyDocKeyword_t   keyword;
-  unsigned          size;
-  unsigned          len;
+  size_t            len;
 
   // check parmeters
   FlyAssert(szStart && szEnd && szStart <= szEnd);
@@ -1272,70 +1109,52 @@ char * FlyDocParseText(flyDoc_t *pDoc, flyDocSection_t *pSection, const char *sz
   if(pDoc->opts.debug >= FLYDOC_DEBUG_MAX)
     FlyStrDump(szStart, (szEnd - szStart));
 
-  // parse @example, @logo, @version, @color, @font
-  // all these lines will be removed or modified in the text
-  // also parse any images found on the line
+  // in one pass: parse @example, @logo, @version, @color, @font and copy the text
+  // keyword lines are removed from the text, except @example and unknown, which are left as-is
+  // @example will be adjusted in flydochtml.c or flydocmd.c
+  szText = FlyDocTextAlloc(pDoc, (szEnd - szStart) + 1);
+  psz = szText;
   szLine = szStart;
   while(*szLine && szLine < szEnd)
   {
-    // parse any @keywords
     pszArg = FlyDocIsKeyword(szLine, &keyword);
-    if(pszArg)
+    if(pszArg && keyword == FLYDOC_KEYWORD_EXAMPLE)
     {
-      if(keyword == FLYDOC_KEYWORD_EXAMPLE)
+      // parse the example and add to pSection->pExampleLine, example text copied as-is
+      szEndExample = FlyDocParseExample(pDoc, pSection, szLine, &pExample);
+      if(szEndExample)
       {
-        // parse the example and add to pSection->pExampleLine
-        szEndExample = FlyDocParseExample(pDoc, pSection, szLine, &pExample);
-        if(szEndExample)
-        {
-          szLine = szEndExample;
-          pSection->pExampleList = FlyListAppend(pSection->pExampleList, pExample);
-          continue;
-        }
+        pSection->pExampleList = FlyListAppend(pSection->pExampleList, pExample);
+        psz = MdTextCopy(psz, szLine, (szEndExample < szEnd) ? szEndExample : szEnd);
+        szLine = szEndExample;
+        continue;
       }
-      else
-        MdParseStyleKeyword(pDoc, pSection, pszArg, keyword);
     }
-    szLine = FlyStrLineNext(szLine);
-  }
-
-  // allocate space for text
-  szLine = szStart;
-  size = FlyDocTextLenCalc(szLine, szEnd);
-  szText = FlyAllocZ(size);
-  FlyDocAllocCheck(szText);
-
-  // add appropriate lines into text (will remove keyword lines)
-  psz = szText;
-  szLine = szStart;
-  while(*szLine && szLine < szEnd)
-  {
-    // throw out keywords lines, as they've already been processed
-    // exception is example and unknown, both which are left as-is
-    // @example will be adjusted in flydochtml.c or flydocmd.c
-    if(FlyDocIsKeyword(szLine, &keyword) && !((keyword == FLYDOC_KEYWORD_EXAMPLE || keyword == FLYDOC_KEYWORD_UNKNOWN)))
+    else if(pszArg && keyword != FLYDOC_KEYWORD_UNKNOWN)
     {
+      MdParseStyleKeyword(pDoc, pSection, pszArg, keyword);
       szLine = FlyStrLineNext(szLine);
       continue;
     }
 
-    // copy the line from the original text to our modified one
-    len = FlyStrLineLenEx(szLine);
-    memcpy(psz, szLine, len);
-    psz += len;
-    szLine = FlyStrLineNext(szLine);
+    // copy the line from the original text to our modified one, text never goes past szEnd
+    szNext = FlyStrLineNext(szLine);
+    if(szNext > szEnd)
+      szNext = szEnd;
+    memcpy(psz, szLine, szNext - szLine);
+    psz += szNext - szLine;
+    szLine = szNext;
   }
+  *psz = '\0';
 
   FlyStrLineBlankRemove(szText);
-  if(strlen(szText) == 0)
-  {
-    FlyFree(szText);
+  len = strlen(szText);
+  if(len == 0)
     szText = NULL;
-  }
 
-  // reecord found images in case image files need to be copied and for stats
-  if(szText)
-    MdParseTextForImages(pDoc, szText, szText + strlen(szText));
+  // record found images in case image files need to be copied and for stats
+  else if(memchr(szText, '!', len))
+    MdParseTextForImages(pDoc, szText, szText + len);
 
   return szText;
 }
@@ -1350,7 +1169,6 @@ char * FlyDocParseText(flyDoc_t *pDoc, flyDocSection_t *pSection, const char *sz
 -------------------------------------------------------------------------------------------------*/
 void FlyDocParseModule(flyDoc_t *pDoc, const char *szSection, const char *szSectionEnd, bool_t fClass)
 {
-  flyDocModule_t   *pList;
   flyDocModule_t   *pMod;
   const char       *szTitle     = NULL;
   const char       *szSubtitle  = NULL;
@@ -1372,7 +1190,7 @@ void FlyDocParseModule(flyDoc_t *pDoc, const char *szSection, const char *szSect
   // Duplicate modules ignored. Not considered duplicate if title only as created by @ingroup or @inclass
   if(fWorked)
   {
-    szCName = FlyDocCNameAlloc(szTitle);
+    szCName = FlyDocCNameAlloc(pDoc, szTitle);
     if(!szCName)
     {
       FlyDocPrintWarningEx(pDoc, szWarningSyntax, NULL, pDoc->szFile, FlyDocFixupPos(pDoc, szSection));
@@ -1380,8 +1198,7 @@ void FlyDocParseModule(flyDoc_t *pDoc, const char *szSection, const char *szSect
     }
     else
     {
-      pList = fClass ? pDoc->pClassList : pDoc->pModList;
-      pMod = FlyDocModInList(pList, szCName);
+      pMod = FlyDocModFind(pDoc, szCName, fClass);
       if(pMod && (pMod->section.szSubtitle || pMod->section.szText))
       {
         FlyDocPrintWarningEx(pDoc, szWarningDuplicate, szCName, pDoc->szFile, FlyDocFixupPos(pDoc, szSection));
@@ -1393,20 +1210,15 @@ void FlyDocParseModule(flyDoc_t *pDoc, const char *szSection, const char *szSect
   // create the module if needed
   if(fWorked && pMod == NULL)
   {
-    pMod = FlyDocModNew(szCName);
+    pMod = FlyDocModNew(pDoc, szCName);
     FlyDocAllocCheck(pMod);
     FlyDocDupCheck(pDoc, pMod->section.szTitle, FlyDocFixupPos(pDoc, szSection));
-    if(fClass)
-      pDoc->pClassList = FlyDocModListAdd(pDoc->pClassList, pMod, pDoc->opts.fSort);
-    else
-      pDoc->pModList = FlyDocModListAdd(pDoc->pModList, pMod, pDoc->opts.fSort);
+    FlyDocModAdd(pDoc, pMod, fClass);
   }
 
   if(fWorked)
   {
-    FlyFreeIf(pMod->section.szSubtitle);
-    pMod->section.szSubtitle = FlyDocAllocToLineEnd(szSubtitle);
-    FlyDocAllocCheck(pMod->section.szSubtitle);
+    pMod->section.szSubtitle = FlyDocAllocToLineEnd(pDoc, szSubtitle);
   }
  
   // this is now the current module
@@ -1416,90 +1228,64 @@ void FlyDocParseModule(flyDoc_t *pDoc, const char *szSection, const char *szSect
   szLine = FlyStrLineNext(szSection);
   pMod->section.szText = FlyDocParseText(pDoc, &pMod->section, szLine, szSectionEnd);
 
-  FlyFreeIf(szCName);
-
   // print newly created module if we're debugging
   if(pDoc->opts.debug)
     FlyDocPrintModule(pMod, pDoc->opts.debug);
 }
 
 /*!------------------------------------------------------------------------------------------------
-  Check in all lists for a duplicate output filename.
-
-  For example, if there is a module, class and document, all named "Foo", it would issue 2 warnings
-  indicating the 2nd two are duplicates.
+  Would this title create a duplicate output filename? Checks all lists. See FlyDocDupCheck().
 
   This is case insensitive because both macOS and Windows are case insensitive for filenames.
 
   @param    pDoc      document state
   @param    szTitle   title of a module, class or document
-  @param    szPos     position in file where duplicate occurred
-  @return   none
+  @return   TRUE if the title is a duplicate
 -------------------------------------------------------------------------------------------------*/
-void FlyDocDupCheck(flyDoc_t *pDoc, const char *szTitle, const char *szPos)
+bool_t FlyDocIsDup(const flyDoc_t *pDoc, const char *szTitle)
 {
-  flyDocModule_t    *pMod;
-  flyDocMarkdown_t  *pDocument;
-  flyStrSmart_t     title;
-  flyStrSmart_t     thisTitle;
-  char             *psz;
-  size_t            nPages    = 0;
-  bool_t            fIsDup    = FALSE;
-
-  // title might be in myfile.md form, convert to just myfile for comparison
-  FlyStrSmartInitEx(&title, 128);
-  FlyStrSmartInitEx(&thisTitle, 128);
-  FlyStrSmartCpy(&title, szTitle);
-  psz = (char *)FlyStrPathExt(title.sz);
-  if(psz)
-    *psz = '\0';
-
-  // check module list
-  pMod = pDoc->pModList;
-  while(!fIsDup && pMod)
-  {
-    if(strcasecmp(title.sz, pMod->section.szTitle) == 0)
-      fIsDup = TRUE;
-    ++nPages;
-    pMod = pMod->pNext;
-  }
+  size_t            len;
+  bool_t            fIsDup;
 
-  // check class list
-  pMod = pDoc->pClassList;
-  while(!fIsDup && pMod)
+  // title might be in myfile.md form, the page index ignores the extension
+  fIsDup = FlyDocIndexHasPage(pDoc, szTitle);
+
+  // check for conflict with index (mainpage), a mainpage is always created if more than 1 page
+  if(!fIsDup && (pDoc->pMainPage || pDoc->nPages > 1))
   {
-    if(strcasecmp(title.sz, pMod->section.szTitle) == 0)
+    len = FlyDocPageNameLen(szTitle);
+    if(len == 5 && strncasecmp(szTitle, "index", len) == 0)
       fIsDup = TRUE;
-    ++nPages;
-    pMod = pMod->pNext;
   }
 
-  // check markdown document list
-  pDocument = pDoc->pMarkdownList;
-  while(pDocument)
-  {
-    // title is in myfile.md form, convert to myfile for comparison
-    FlyStrSmartCpy(&thisTitle, pDocument->section.szTitle);
-    psz = FlyStrPathExt(thisTitle.sz);
-    if(psz)
-      *psz = '\0';
+  return fIsDup;
+}
 
-    if(strcasecmp(title.sz, thisTitle.sz) == 0)
-      fIsDup = TRUE;
-    ++nPages;
-    pDocument = pDocument->pNext;
-  }
+/*!------------------------------------------------------------------------------------------------
+  Check in all lists for a duplicate output filename.
 
-  // check for conflict with index (mainpage), a mainpage is always created if more than 1 page
-  if((strcasecmp(title.sz, "index") == 0) && (pDoc->pMainPage || nPages > 1))
-    fIsDup = TRUE;
+  For example, if there is a module, class and document, all named "Foo", it would issue 2 warnings
+  indicating the 2nd two are duplicates.
+
+  @param    pDoc      document state
+  @param    szTitle   title of a module, class or document
+  @param    szPos     position in file where duplicate occurred
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocDupCheck(flyDoc_t *pDoc, const char *szTitle, const char *szPos)
+{
+  char              szName[PATH_MAX];
 
-  if(fIsDup)
+  if(FlyDocIsDup(pDoc, szTitle))
   {
     if(szPos)
       FlyDocPrintWarningEx(pDoc, szWarningDuplicate, szTitle, pDoc->szFile, szPos);
     else
-      FlyDocPrintWarning(pDoc, szWarningDuplicate, title.sz);
+    {
+      // title might be in myfile.md form, warning is for just myfile
+      FlyStrZNCpy(szName, szTitle, sizeof(szName), FlyDocPageNameLen(szTitle));
+      FlyDocPrintWarning(pDoc, szWarningDuplicate, szName);
+    }
   }
 }
 
@@ -1543,43 +1329,39 @@ void FlyDocParseMainPage(flyDoc_t *pDoc, const char *szSection, const char *szSe
     return;
   }
 
-  pMainPage = FlyAlloc(sizeof(*pMainPage));
-  if(pMainPage)
-  {
-    pDoc->pMainPage = pMainPage;
-    memset(pMainPage, 0, sizeof(*pMainPage));
+  pMainPage = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pMainPage));
+  pDoc->pMainPage = pMainPage;
 
-    // the title follows the mainpage keyword to end of line
-    pMainPage->section.szTitle = FlyDocAllocToLineEnd(FlyStrArgNext(FlyStrSkipWhite(szSection)));
-    szSection = FlyStrLineNext(szSection);
+  // the title follows the mainpage keyword to end of line
+  pMainPage->section.szTitle = FlyDocAllocToLineEnd(pDoc, FlyStrArgNext(FlyStrSkipWhite(szSection)));
+  szSection = FlyStrLineNext(szSection);
 
-    // check for subtitle and section settings
-    szLine = szSection;
-    pSection = &pMainPage->section;
-    while(*szLine && szLine < szSectionEnd)
+  // check for subtitle and section settings
+  szLine = szSection;
+  pSection = &pMainPage->section;
+  while(*szLine && szLine < szSectionEnd)
+  {
+    pszArg = FlyDocIsKeyword(szLine, &keyword);
+    if(pszArg)
+      MdParseStyleKeyword(pDoc, pSection, pszArg, keyword);
+    else if(!FlyStrLineIsBlank(szLine))
     {
-      pszArg = FlyDocIsKeyword(szLine, &keyword);
-      if(pszArg)
-        MdParseStyleKeyword(pDoc, pSection, pszArg, keyword);
-      else if(!FlyStrLineIsBlank(szLine))
+      // subtitle must be a single line, otherwise no subtitle
+      if(FlyStrLineIsBlank(FlyStrLineNext(szLine)))
       {
-        // subtitle must be a single line, otherwise no subtitle
-        if(FlyStrLineIsBlank(FlyStrLineNext(szLine)))
-        {
-          pMainPage->section.szSubtitle = FlyDocAllocToLineEnd(szLine);
-          szSection = FlyStrLineNext(szLine);
-        }
-        break;
+        pMainPage->section.szSubtitle = FlyDocAllocToLineEnd(pDoc, szLine);
+        szSection = FlyStrLineNext(szLine);
       }
-      szLine = FlyStrLineNext(szLine);
+      break;
     }
+    szLine = FlyStrLineNext(szLine);
+  }
 
-    if(szSection < szSectionEnd)
-      pMainPage->section.szText = FlyDocParseText(pDoc, &pMainPage->section, szSection, szSectionEnd);
+  if(szSection < szSectionEnd)
+    pMainPage->section.szText = FlyDocParseText(pDoc, &pMainPage->section, szSection, szSectionEnd);
 
-    if(pDoc->opts.debug)
-      FlyDocPrintMainPage(pMainPage, pDoc->opts.debug);
-  }
+  if(pDoc->opts.debug)
+    FlyDocPrintMainPage(pMainPage, pDoc->opts.debug);
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -1604,6 +1386,8 @@ void FlyDocParseFunction(flyDoc_t *pDoc, const char *szSection, const char *szSe
   const char       *szFuncName  = NULL;
   const char       *szBrief     = NULL;
   flyDocKeyword_t   keyword;
+  const char       *szProtoFirst = NULL;
+  const char       *szProtoLast  = NULL;
   flyDocFunc_t     *pFunc       = NULL;
   unsigned          protoLen;
   unsigned          sizeProto = 0;
@@ -1615,7 +1399,7 @@ void FlyDocParseFunction(flyDoc_t *pDoc, const char *szSection, const char *szSe
       FlyStrDump(FlyStrHdrContentStart(pHdr), (unsigned)(FlyStrHdrContentEnd(pHdr) - FlyStrHdrContentStart(pHdr)) + 1);
   }
 
-  // first things first, handle @inclass, @ingroup and brief
+  // in one pass, handle @inclass, @ingroup and brief, and find the @param/@return lines
   szLine = szSection;
   while(*szLine && szLine < szSectionEnd)
   {
@@ -1624,11 +1408,23 @@ void FlyDocParseFunction(flyDoc_t *pDoc, const char *szSection, const char *szSe
       // process @inclass or @ingroup (may change current module)
       if((keyword == FLYDOC_KEYWORD_INCLASS) || (keyword == FLYDOC_KEYWORD_INGROUP))
         FlyDocParseInGroup(pDoc, szLine);
+
+      // @param, @return lines go into the prototype paragraph, if after the brief
+      else if(FlyDocIsKeywordProto(keyword))
+      {
+        sizeProto += FlyStrLineLenEx(szLine) + strlen(szFlyDocExtra);
+        if(szProtoFirst == NULL)
+          szProtoFirst = szLine;
+        szProtoLast = szLine;
+      }
     }
 
     // 1st non-blank line is the brief for the function
     else if(szBrief == NULL && !FlyStrLineIsBlank(szLine))
+    {
       szBrief = szLine;
+      szProtoFirst = NULL;
+    }
     szLine = FlyStrLineNext(szLine);
   }
 
@@ -1672,55 +1468,39 @@ void FlyDocParseFunction(flyDoc_t *pDoc, const char *szSection, const char *szSe
   }
 
   // add function into the module list
-  pFunc = FlyDocFuncNew(szFuncName);
+  pFunc = FlyDocFuncNew(pDoc, szFuncName);
   FlyDocAllocCheck(pFunc);
-  pDoc->pCurMod->pFuncList = FlyDocFuncListAdd(pDoc->pCurMod->pFuncList, pFunc, pDoc->opts.fSort);
+  pDoc->pCurMod->pFuncList = FlyListAppend(pDoc->pCurMod->pFuncList, pFunc);
 
   // allocate a copy of the szBrief line
   if(szBrief)
-    pFunc->szBrief = FlyStrAllocN(szBrief, FlyStrLineLen(szBrief));
+    pFunc->szBrief = FlyDocArenaStrAllocN(&pDoc->arena, szBrief, FlyStrLineLen(szBrief));
 
-  // determine size of prototype paragraph, which includes the @params and @return
-  sizeProto = protoLen + strlen(szTwoLines) + 1;
-  szLine = szSection;
-  while(*szLine && szLine < szSectionEnd)
-  {
-    if(FlyDocIsKeyword(szLine, &keyword) && FlyDocIsKeywordProto(keyword))
-      sizeProto += FlyStrLineLenEx(szLine) + strlen(szFlyDocExtra);
-    szLine = FlyStrLineNext(szLine);
-  }
+  // size of prototype paragraph, which includes the @params and @return
+  sizeProto += protoLen + strlen(szTwoLines) + 1;
 
   // allocate and copy prototype paragraph, which includes @param and @return
-  pFunc->szPrototype = FlyAlloc(sizeProto);
-  if(pFunc->szPrototype)
-  {
-    memset(pFunc->szPrototype, 0, sizeProto);
-    psz = pFunc->szPrototype;
-
-    // copy in function prototype
-    memcpy(psz, szPrototype, protoLen);
-    psz += protoLen;
-    strcpy(psz, szTwoLines);
-    psz += strlen(szTwoLines);
+  pFunc->szPrototype = FlyDocTextAlloc(pDoc, sizeProto);
+  psz = pFunc->szPrototype;
 
-    // copy in any @keyword lines like @param and @return into prototype lines
-    if(szBrief)
-      szLine = FlyStrLineNext(szBrief);
-    else
-      szLine = szSection;
-    while(*szLine)
-    {
-      if(FlyDocIsKeyword(szLine, &keyword) && FlyDocIsKeywordProto(keyword))
-        psz = FlyDocExtraLineCopy(psz, szLine);
-      szLine = FlyStrLineNext(szLine);
-    }
-    *psz = '\0';
-    FlyAssert((psz - pFunc->szPrototype) < sizeProto);
-    FlyStrLineBlankRemove(pFunc->szPrototype);
+  // copy in function prototype
+  memcpy(psz, szPrototype, protoLen);
+  psz += protoLen;
+  strcpy(psz, szTwoLines);
+  psz += strlen(szTwoLines);
 
-    // determine language based on filename
-    pFunc->szLang = FlyStrPathLang(pDoc->szPath);
+  // copy in any @keyword lines like @param and @return into prototype lines
+  for(szLine = szProtoFirst; szLine && szLine <= szProtoLast; szLine = FlyStrLineNext(szLine))
+  {
+    if(FlyDocIsKeyword(szLine, &keyword) && FlyDocIsKeywordProto(keyword))
+      psz = FlyDocExtraLineCopy(psz, szLine);
   }
+  *psz = '\0';
+  FlyAssert((psz - pFunc->szPrototype) < sizeProto);
+  FlyStrLineBlankRemove(pFunc->szPrototype);
+
+  // determine language based on filename
+  pFunc->szLang = FlyStrPathLang(pDoc->szPath);
 
   // allocate and copy the text (notes) section of the function
   // may also add examples to module/class
@@ -1729,7 +1509,7 @@ void FlyDocParseFunction(flyDoc_t *pDoc, const char *szSection, const char *szSe
   else
     szLine = szSection;
   FlyAssert(pDoc->pCurMod);
-  pFunc->szText = FlyDocParseText(pDoc, &pDoc->pCurMod->section, szLine, szLine + strlen(szLine));
+  pFunc->szText = FlyDocParseText(pDoc, &pDoc->pCurMod->section, szLine, szSectionEnd);
 
   if((pDoc->opts.debug >= FLYDOC_DEBUG_MORE) && pFunc)
     FlyDocPrintFunc(pFunc, FLYDOC_DEBUG_SOME, 2);
@@ -1758,8 +1538,8 @@ void FlyDocParseHdr(flyDoc_t *pDoc, const char *szHdr, flyStrHdr_t *pHdr)
   {
     unsigned  row;
     unsigned  col;
-    szLine = FlyDocFixupPos(pDoc, szHdr);
-    row = FlyStrLinePos(pDoc->szFile, szLine, &col);
+    col = 1;
+    row = FlyDocLinePos(pDoc, FlyDocFixupPos(pDoc, szHdr), &col, &szLine);
     printf("--- FlyDocParseHdr(%u:%u:%.*s) ---\n", row, col, (int)FlyStrLineLen(szHdr), szHdr);
   }
 
@@ -1844,22 +1624,20 @@ void FlyDocParseHdr(flyDoc_t *pDoc, const char *szHdr, flyStrHdr_t *pHdr)
 
   Warning: szFile MUST be persistent!
 
+  @param    pDoc      document state with arena
   @param    szFile    ptr to markdown file in memory (MUST be persistent)
   @param    szTitle   header text, will cloned
-  @return   ptr to markdown structure or NULL if no memory
+  @return   ptr to markdown structure
 -------------------------------------------------------------------------------------------------*/
-flyDocMarkdown_t * FlyDocMarkdownNew(const char *szFile, const char *szTitle)
+flyDocMarkdown_t * FlyDocMarkdownNew(flyDoc_t *pDoc, const char *szFile, const char *szTitle)
 {
   flyDocMarkdown_t *pMarkdown;
 
-  pMarkdown = FlyAlloc(sizeof(*pMarkdown));
-  if(pMarkdown)
-  {
-    memset(pMarkdown, 0, sizeof(*pMarkdown));
-    pMarkdown->szFile = szFile;
-    if(szTitle)
-      pMarkdown->section.szTitle = FlyStrClone(szTitle);
-  }
+  pMarkdown = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pMarkdown));
+  pMarkdown->szFile = szFile;
+  if(szTitle)
+    pMarkdown->section.szTitle = FlyDocArenaStrClone(&pDoc->arena, szTitle);
+
   return pMarkdown;
 }
 
@@ -1881,29 +1659,45 @@ int FlyDocMarkdownCmp(const void *pThis, const void *pThat)
   return strcmp(pMd1->section.szTitle, pMd2->section.szTitle);
 }
 
+/*!------------------------------------------------------------------------------------------------
+  Add the allocated markdown document to pDoc, both to the list and the page index. The list is in
+  parse order until sorted by FlyDocSortLists().
+
+  @param    pDoc        document state
+  @param    pMarkdown   allocated markdown document
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocMarkdownAdd(flyDoc_t *pDoc, flyDocMarkdown_t *pMarkdown)
+{
+  pDoc->pMarkdownList = FlyListAppend(pDoc->pMarkdownList, pMarkdown);
+  FlyDocIndexPage(pDoc, pMarkdown->section.szTitle);
+}
+
 /*!------------------------------------------------------------------------------------------------
   Create a new markdown header structure
 
-  @param    pDoc    ptr to flyDocMdHeader_t
-  @param    szPath  ptr to flyDocMdHeader_t
-  @return   < 0 less than, 0 equal, > 0 greater than
+  @param    pDoc      document state with arena
+  @param    szTitle   persistent header title
+  @return   ptr to markdown header structure
 -------------------------------------------------------------------------------------------------*/
-flyDocMdHdr_t * FlyDocMdHdrNew(const char *szTitle)
+flyDocMdHdr_t * FlyDocMdHdrNew(flyDoc_t *pDoc, const char *szTitle)
 {
   flyDocMdHdr_t *pMdHdr;
 
-  pMdHdr = FlyAlloc(sizeof(*pMdHdr));
-  if(pMdHdr)
-  {
-    memset(pMdHdr, 0, sizeof(*pMdHdr));
-    pMdHdr->szTitle = szTitle;
-  }
+  pMdHdr = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pMdHdr));
+  pMdHdr->szTitle   = szTitle;
+  pMdHdr->szRef     = FlyDocRefNew(&pDoc->arena, szTitle);
+  pMdHdr->szNbTitle = FlyDocNbNew(&pDoc->arena, szTitle);
+
   return pMdHdr;
 }
 
 /*!-------------------------------------------------------------------------------------------------
   Parse a markdown file into the pDoc->pMarkdownList
 
+  With --markdown, the markdown file is written as-is, so its contents are not kept: only the
+  title, headings and images are. FlyDocWriteMarkdownList() reads each file again as it is written.
+
   @param    pDoc    ptr to document context
   @param    szFile  ptr to file contents
   @return   TRUE if worked, FALSE if not a markdown file
@@ -1937,15 +1731,10 @@ bool_t FlyDocParseMarkdownFile(flyDoc_t *pDoc, const char *szFile)
   }
 
   // allocate a new markdown file with title of the filename only
-  pMarkdown = FlyDocMarkdownNew(szFile, FlyStrPathNameOnly(pDoc->szPath));
+  pMarkdown = FlyDocMarkdownNew(pDoc, szFile, FlyStrPathNameOnly(pDoc->szPath));
   FlyDocAllocCheck(pMarkdown);
   FlyDocDupCheck(pDoc, pMarkdown->section.szTitle, NULL);
-
-  // add into list of documents
-  if(pDoc->opts.fSort)
-    pDoc->pMarkdownList = FlyListAddSorted(pDoc->pMarkdownList, pMarkdown, FlyDocMarkdownCmp);
-  else
-    pDoc->pMarkdownList = FlyListAppend(pDoc->pMarkdownList, pMarkdown);
+  FlyDocMarkdownAdd(pDoc, pMarkdown);
 
   pSection  = &pMarkdown->section;
   pSection->szText = (char *)szFile;
@@ -1979,18 +1768,16 @@ bool_t FlyDocParseMarkdownFile(flyDoc_t *pDoc, const char *szFile)
     {
       // allocate title
       pszArg = FlyMd2HtmlHeadingText(szLine);
-      szHeading = FlyStrAllocN(pszArg, FlyStrLineLen(pszArg));
-      FlyDocAllocCheck(szHeading);
+      szHeading = FlyDocArenaStrAllocN(&pDoc->arena, pszArg, FlyStrLineLen(pszArg));
 
       // subtitle is 1st header
       if(!fGotHdr)
       {
-        FlyFreeIf(pMarkdown->section.szSubtitle);
         pMarkdown->section.szSubtitle = szHeading;
         fGotHdr = TRUE;
       }
 
-      pMdHdr = FlyDocMdHdrNew(szHeading);
+      pMdHdr = FlyDocMdHdrNew(pDoc, szHeading);
       pMarkdown->pHdrList = FlyListAppend(pMarkdown->pHdrList, pMdHdr);
     }
 
@@ -2000,9 +1787,54 @@ bool_t FlyDocParseMarkdownFile(flyDoc_t *pDoc, const char *szFile)
   if(fWorked)
     MdParseTextForImages(pDoc, szFile, szFile + strlen(szFile));
 
+  // --markdown only needs the contents again to write them, so don't keep them in memory until then
+  // (unless --emit-db, which writes the contents too, or there is no file to read, see FlyDocLibParse())
+  if(pDoc->opts.fMarkdown && !pDoc->opts.szEmitDb && !pDoc->fInMemory)
+  {
+    pMarkdown->szPath = FlyDocArenaStrClone(&pDoc->arena, pDoc->szPath);
+    pMarkdown->szFile = NULL;
+    pSection->szText  = NULL;
+    pDoc->fFileDone   = TRUE;
+  }
+
   return fWorked;
 }
 
+/*-------------------------------------------------------------------------------------------------
+  Find the next place a flydoc comment header may start, without looking at every line.
+
+  Every flydoc comment has a bang right after the comment opener (see "Flydoc Comments By Language"
+  in the user guide), so this uses memchr() (vectorized in most C libraries) to jump from '!' to
+  '!', only stopping on those that follow a comment character. Most source files have none, and
+  those are skipped entirely.
+
+  Python doc strings come after the function they document, so for those it returns szLine rather
+  than skip ahead, leaving the search to FlyStrHdrFind() as before.
+
+  @param    szLine    where to start looking
+  @param    szEnd     end of file
+  @return   start of the line to search from with FlyStrHdrFind(), or NULL if no headers
+-------------------------------------------------------------------------------------------------*/
+static const char * MdHdrCandidate(const char *szLine, const char *szEnd)
+{
+  const char *psz = szLine;
+
+  while(psz < szEnd && (psz = memchr(psz, '!', szEnd - psz)) != NULL)
+  {
+    if(psz > szLine && strchr("*/#-;%", psz[-1]))
+    {
+      while(psz > szLine && psz[-1] != '\n')
+        --psz;
+      return psz;
+    }
+    if(psz > szLine && strchr("\"'", psz[-1]))
+      return szLine;
+    ++psz;
+  }
+
+  return NULL;
+}
+
 /*!------------------------------------------------------------------------------------------------
   Parse a source file into flydoc.
 
@@ -2017,6 +1849,7 @@ bool_t FlyDocParseSrcFile(flyDoc_t *pDoc, const char *szFile)
 {
   const char   *szRawHdr;
   const char   *szLine;
+  const char   *szEnd;
   char         *szHdr;
   flyStrHdr_t   hdr;
   size_t        len;
@@ -2029,8 +1862,9 @@ bool_t FlyDocParseSrcFile(flyDoc_t *pDoc, const char *szFile)
 
   // don't know the current module/class for functions at this point
   pDoc->pCurMod = NULL;
-  szLine = szFile;
-  while(TRUE)
+  szEnd  = szFile + pDoc->lenFile;
+  szLine = MdHdrCandidate(szFile, szEnd);
+  while(szLine)
   {
     // if no more flydoc headers, we're done
     szRawHdr = FlyStrHdrFind(szLine, TRUE, &hdr);
@@ -2051,7 +1885,7 @@ bool_t FlyDocParseSrcFile(flyDoc_t *pDoc, const char *szFile)
     }
 
     // on to next header
-    szLine = FlyStrRawHdrEnd(&hdr);
+    szLine = MdHdrCandidate(FlyStrRawHdrEnd(&hdr), szEnd);
     pDoc->pCurHdr  = NULL;
     pDoc->szCurHdr = NULL;
   }
@@ -2068,6 +1902,19 @@ bool_t FlyDocParseSrcFile(flyDoc_t *pDoc, const char *szFile)
   @return   TRUE if worked, FALSE if can't read file
 -------------------------------------------------------------------------------------------------*/
 bool_t FlyDocParseFile(flyDoc_t *pDoc, const char *szPath)
+{
+  return FlyDocParseFileEx(pDoc, szPath, NULL);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Same as FlyDocParseFile(), but the file may already be read into memory.
+
+  @param    pDoc        ptr to document context
+  @param    szPath      ptr to file path (relative or absolute)
+  @param    pIn         file from FlyDocInFileRead() (now owned by pDoc), or NULL to read the file
+  @return   TRUE if worked, FALSE if can't read file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocParseFileEx(flyDoc_t *pDoc, const char *szPath, flyDocInFile_t *pIn)
 {
   typedef enum
   {
@@ -2077,8 +1924,10 @@ bool_t FlyDocParseFile(flyDoc_t *pDoc, const char *szPath)
     FLYDOC_FILE_TYPE_SRC,
   } fileType_t;
 
-  fileType_t    fileType;
-  bool_t        fWorked   = TRUE;
+  flyDocInFile_t  inFile;
+  fileType_t      fileType;
+  uint64_t        nsStart   = 0;
+  bool_t          fWorked   = TRUE;
 
   if(pDoc->opts.debug)
     printf("--- FlyDocParseFile(%s)---\n", szPath);
@@ -2095,6 +1944,9 @@ bool_t FlyDocParseFile(flyDoc_t *pDoc, const char *szPath)
   pDoc->pCurHdr = NULL;
   *pDoc->szPath = '\0';
   pDoc->szFile  = NULL;
+  pDoc->lenFile = 0;
+  pDoc->fFileDone = FALSE;
+  memset(&pDoc->fileProf, 0, sizeof(pDoc->fileProf));
   if(fileType != FLYDOC_FILE_TYPE_NONE)
   {
     ++pDoc->nFiles;
@@ -2103,8 +1955,22 @@ bool_t FlyDocParseFile(flyDoc_t *pDoc, const char *szPath)
       printf("%s\n", pDoc->szPath);
 
     // read in the file
-    pDoc->szFile = FlyFileRead(szPath);
-    if(!pDoc->szFile || strlen(pDoc->szFile) == 0)
+    if(pDoc->opts.fProfile)
+      nsStart = FlyDocProfNow();
+    if(pIn)
+      inFile = *pIn;
+    else
+      FlyDocInFileRead(&inFile, szPath);
+    pDoc->szFile  = inFile.szFile;
+    pDoc->lenFile = inFile.len;
+    if(pDoc->opts.fProfile)
+    {
+      pDoc->fileProf.nsRead    = FlyDocProfNow() - nsStart;
+      pDoc->fileProf.len       = inFile.len;
+      pDoc->fileProf.fMarkdown = (fileType == FLYDOC_FILE_TYPE_MARKDOWN) ? TRUE : FALSE;
+      nsStart += pDoc->fileProf.nsRead;
+    }
+    if(!pDoc->szFile || inFile.len == 0)
       FlyDocPrintWarning(pDoc, szWarningReadFile, szPath);
     else
     {
@@ -2113,16 +1979,118 @@ bool_t FlyDocParseFile(flyDoc_t *pDoc, const char *szPath)
       else if(fileType == FLYDOC_FILE_TYPE_MARKDOWN)
         fWorked = FlyDocParseMarkdownFile(pDoc, pDoc->szFile);
     }
+    if(pDoc->opts.fProfile)
+      pDoc->fileProf.nsParse = FlyDocProfNow() - nsStart;
 
-    if(fileType != FLYDOC_FILE_TYPE_MARKDOWN && pDoc->szFile)
-      FlyFree((char *)pDoc->szFile);
+    // markdown file contents are the document text, so they live as long as the arena
+    if(fileType == FLYDOC_FILE_TYPE_MARKDOWN && inFile.szFile && !pDoc->fFileDone)
+      FlyDocArenaOwnInFile(&pDoc->arena, &inFile);
+    else
+      FlyDocInFileFree(&inFile);
 
-    pDoc->szFile = NULL;
+    FlyDocLinesFree(pDoc);
+    pDoc->szFile  = NULL;
+    pDoc->lenFile = 0;
   }
+  else if(pIn)
+    FlyDocInFileFree(pIn);
 
   return fWorked;
 }
 
+// any flylibc list, pNext is always the 1st field
+typedef struct mdListNode
+{
+  struct mdListNode *pNext;
+} mdListNode_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Stable merge sort of a linked list in O(n log n). Items that compare equal keep their order, so
+  the result is the same as inserting items one at a time with FlyListAddSorted().
+
+  @param    pList     list to sort (may be NULL)
+  @param    pfnCmp    compare function, e.g. FlyDocFuncListCmp()
+  @return   ptr to new head of list
+-------------------------------------------------------------------------------------------------*/
+static void * MdListSort(void *pList, int (*pfnCmp)(const void *pThis, const void *pThat))
+{
+  mdListNode_t   *pHead = pList;
+  mdListNode_t   *pLeft;
+  mdListNode_t   *pRight;
+  mdListNode_t   *pNode;
+  mdListNode_t  **ppTail;
+  size_t          width;
+  size_t          nLeft;
+  size_t          nRight;
+  bool_t          fMerged = TRUE;
+
+  // bottom up: merge runs of width 1, 2, 4... until a single run remains
+  for(width = 1; pHead && fMerged; width *= 2)
+  {
+    fMerged = FALSE;
+    pRight  = pHead;
+    ppTail  = &pHead;
+    while(pRight)
+    {
+      // split off left run, then right run
+      pLeft = pRight;
+      for(nLeft = 0; pRight && nLeft < width; ++nLeft)
+        pRight = pRight->pNext;
+      nRight = pRight ? width : 0;
+      if(pRight)
+        fMerged = TRUE;
+
+      // merge, taking from left on ties to keep it stable
+      while(nLeft || (nRight && pRight))
+      {
+        if(nLeft && (!nRight || !pRight || pfnCmp(pLeft, pRight) <= 0))
+        {
+          pNode = pLeft;
+          pLeft = pLeft->pNext;
+          --nLeft;
+        }
+        else
+        {
+          pNode  = pRight;
+          pRight = pRight->pNext;
+          --nRight;
+        }
+        *ppTail = pNode;
+        ppTail  = &pNode->pNext;
+      }
+      *ppTail = pRight;
+    }
+  }
+
+  return pHead;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Sort modules, classes, the functions in each and markdown documents by name for -s. Call once all
+  input files are parsed: lists are kept in parse order until then, as sorting on every add made
+  parsing quadratic.
+
+  @param    pDoc      document state
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocSortLists(flyDoc_t *pDoc)
+{
+  flyDocModule_t   *pMod;
+  unsigned          i;
+
+  if(pDoc->opts.debug)
+    printf("--- FlyDocSortLists() ---\n");
+
+  pDoc->pModList      = MdListSort(pDoc->pModList, FlyDocModListCmp);
+  pDoc->pClassList    = MdListSort(pDoc->pClassList, FlyDocModListCmp);
+  pDoc->pMarkdownList = MdListSort(pDoc->pMarkdownList, FlyDocMarkdownCmp);
+  for(i = 0; i < 2; ++i)
+  {
+    for(pMod = i ? pDoc->pClassList : pDoc->pModList; pMod; pMod = pMod->pNext)
+      pMod->pFuncList = MdListSort(pMod->pFuncList, FlyDocFuncListCmp);
+  }
+}
+
 /*!------------------------------------------------------------------------------------------------
   Updates statistics fields in flydoc from lists
 
@@ -2170,76 +2138,326 @@ void FlyDocImgFileListAdd(flyDoc_t *pDoc, const char *szPath)
   if(pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
     printf("%s\n", szPath);
 
-  pImgFile = FlyAllocZ(sizeof(*pImgFile));
-  if(pImgFile)
+  pImgFile = FlyDocArenaAlloc(&pDoc->arena, sizeof(*pImgFile));
+  pImgFile->szPath = FlyDocArenaStrClone(&pDoc->arena, szPath);
+  pDoc->pImgFileList = FlyListAppend(pDoc->pImgFileList, pImgFile);
+  FlyDocIndexImgFile(pDoc, pImgFile);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Add an input file to the queue of files to be parsed by FlyDocParseInputs().
+
+  @param    pDoc      flydoc state
+  @param    szPath    path to input file
+  @param    fInvalid  TRUE if not a valid input, so only a warning is issued when parsed
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocInputAdd(flyDoc_t *pDoc, const char *szPath, bool_t fInvalid)
+{
+  flyDocInput_t  *aInputs;
+
+  // grow the array as needed
+  if(pDoc->nInputs >= pDoc->maxInputs)
+  {
+    pDoc->maxInputs = pDoc->maxInputs ? 2 * pDoc->maxInputs : 256;
+    aInputs = FlyDocAlloc(pDoc->maxInputs * sizeof(*aInputs));
+    if(pDoc->nInputs)
+      memcpy(aInputs, pDoc->aInputs, pDoc->nInputs * sizeof(*aInputs));
+    FlyFreeIf(pDoc->aInputs);
+    pDoc->aInputs = aInputs;
+  }
+
+  pDoc->aInputs[pDoc->nInputs].szPath = FlyStrClone(szPath);
+  FlyDocAllocCheck(pDoc->aInputs[pDoc->nInputs].szPath);
+  pDoc->aInputs[pDoc->nInputs].fInvalid = fInvalid;
+  ++pDoc->nInputs;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Are input files parsed into partial docs by FlyDocParseInputs(), rather than directly into pDoc?
+
+  @param    pDoc      flydoc state
+  @return   TRUE if using -j=# threads, --cache or --watch
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocUsePartials(const flyDoc_t *pDoc)
+{
+  return (pDoc->opts.nJobs > 1 || pDoc->opts.szCache || pDoc->pWatch) ? TRUE : FALSE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Classify a file found in the input tree by extension: images go in the image file list, source
+  and markdown files are queued for FlyDocParseInputs(), anything else is ignored.
+
+  @param    pDoc      flydoc state
+  @param    szPath    path to input file
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdInputFile(flyDoc_t *pDoc, const char *szPath)
+{
+  if(FlyStrPathHasExt(szPath, pDoc->opts.szExts) || FlyStrPathHasExt(szPath, m_szMarkdownExts))
+    FlyDocInputAdd(pDoc, szPath, FALSE);
+  else if(FlyStrPathHasExt(szPath, m_szImageExts) && pDoc->level <= FLYDOC_MAX_DEPTH)
+    FlyDocImgFileListAdd(pDoc, szPath);
+}
+
+// a folder found while walking the inputs, see FlyDocProcessFolderTree()
+typedef struct flyDocWalkDir
+{
+  char                   *szPath;       // folder with wildcard, e.g. "src/sub/*"
+  void                   *hList;        // files and subfolders, or NULL if folder couldn't be listed
+  struct flyDocWalkDir  **apSubDirs;    // for each entry in hList, subfolder to walk or NULL
+  unsigned                level;        // 0 for the input itself
+} flyDocWalkDir_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Is this file or folder excluded by the --exclude patterns?
+
+  A pattern without a '/' is matched against just the file or folder name, so "build" skips every
+  folder named build, and "*.min.js" every minified file. A pattern with a '/' is matched against
+  the path and each tail of the path, so "src/gen" skips "../project/src/gen/".
+
+  @param    pDoc      flydoc state with opts.szExclude
+  @param    szPath    path to file or folder (folders end in '/')
+  @return   TRUE if excluded
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdIsExcluded(const flyDoc_t *pDoc, const char *szPath)
+{
+  char        szFull[PATH_MAX];
+  char        szPat[PATH_MAX];
+  const char *szName;
+  const char *pszPat;
+  const char *psz;
+  size_t      len;
+
+  if(pDoc->opts.szExclude == NULL)
+    return FALSE;
+
+  // folders end in a slash, but patterns don't
+  FlyStrZCpy(szFull, szPath, sizeof(szFull));
+  len = strlen(szFull);
+  if(len > 1 && szFull[len - 1] == '/')
+    szFull[len - 1] = '\0';
+  szName = strrchr(szFull, '/');
+  szName = szName ? szName + 1 : szFull;
+
+  for(pszPat = pDoc->opts.szExclude; *pszPat; pszPat += len)
   {
-    pImgFile->szPath = FlyStrClone(szPath);
-    if(!pImgFile->szPath)
-      FlyFree(pImgFile);
+    if(*pszPat == ',')
+    {
+      len = 1;
+      continue;
+    }
+    len = strcspn(pszPat, ",");
+    FlyStrZNCpy(szPat, pszPat, sizeof(szPat), len);
+    if(strchr(szPat, '/') == NULL)
+    {
+      if(fnmatch(szPat, szName, 0) == 0)
+        return TRUE;
+    }
     else
     {
-      pDoc->pImgFileList = FlyListAppend(pDoc->pImgFileList, pImgFile);
+      for(psz = szFull; psz; psz = strchr(psz, '/'))
+      {
+        if(*psz == '/')
+          ++psz;
+        if(fnmatch(szPat, psz, 0) == 0)
+          return TRUE;
+      }
     }
   }
+
+  return FALSE;
 }
 
-/*!------------------------------------------------------------------------------------------------
-  Helper to FLyDocPreProcess(). Fills in pDoc->pImgFileList.
+/*-------------------------------------------------------------------------------------------------
+  Allocate a folder to walk.
 
-  @param    pDoc      A document state machine initialized with FlyDocInit()
-  @param    szPath    `file.jpg` , `../images\*` or `../folder/`
-  @return   return TRUE if worked, FALSE to abort
+  @param    szPath    folder path, wildcard or input as given on the command-line
+  @param    szWild    appended to szPath, e.g. "*", or "" for none
+  @param    level     depth of folder
+  @return   ptr to folder
 -------------------------------------------------------------------------------------------------*/
-bool_t FlyDocProcessImage(const char *szPath, void *pData)
+static flyDocWalkDir_t * MdWalkDirNew(const char *szPath, const char *szWild, unsigned level)
 {
-  flyDoc_t  *pDoc = pData;
+  flyDocWalkDir_t *pDir;
 
-  if(FlyStrPathHasExt(szPath, m_szImageExts))
-    FlyDocImgFileListAdd(pDoc, szPath);
+  pDir = FlyDocAlloc(sizeof(*pDir));
+  memset(pDir, 0, sizeof(*pDir));
+  pDir->szPath = FlyDocAlloc(strlen(szPath) + strlen(szWild) + 1);
+  strcpy(pDir->szPath, szPath);
+  strcat(pDir->szPath, szWild);
+  pDir->level = level;
+
+  return pDir;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Free a walked folder and all its subfolders.
+
+  @param    pDir      folder from MdWalkDirNew()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdWalkDirFree(flyDocWalkDir_t *pDir)
+{
+  unsigned  i;
 
+  if(pDir->hList)
+  {
+    if(pDir->apSubDirs)
+    {
+      for(i = 0; i < FlyFileListLen(pDir->hList); ++i)
+      {
+        if(pDir->apSubDirs[i])
+          MdWalkDirFree(pDir->apSubDirs[i]);
+      }
+      FlyFree(pDir->apSubDirs);
+    }
+    FlyFileListFree(pDir->hList);
+  }
+  FlyFree(pDir->szPath);
+  FlyFree(pDir);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Job to list one folder, called from a worker thread. See FlyDocJobsRun().
+
+  @param    pData     array of ptrs to folders, flyDocWalkDir_t **
+  @param    i         which folder
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdWalkJob(void *pData, unsigned i)
+{
+  flyDocWalkDir_t  **apDirs = pData;
+
+  apDirs[i]->hList = FlyFileListNewEx(apDirs[i]->szPath);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Nothing to do when a folder is listed, all folders at a level are gathered after all are done.
+
+  @param    pData     array of ptrs to folders, flyDocWalkDir_t **
+  @param    i         which folder
+  @return   TRUE to keep going
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdWalkJobDone(void *pData, unsigned i)
+{
+  (void)pData;
+  (void)i;
   return TRUE;
 }
 
-/*!------------------------------------------------------------------------------------------------
-  This gets a list of input images as they may be referenced in the source code.
+/*-------------------------------------------------------------------------------------------------
+  List the folder and all its subfolders that aren't excluded.
 
-  Fills in pDoc->pImgFileList with all input image files. All, some or none of the images may be
-  referenced by markdown text or @logo keyword.
+  Folders are listed a level at a time, all folders at the same level in parallel with -j, which
+  hides the latency of slow (e.g. network) file systems. Excluded folders are never listed.
 
   @param    pDoc      flydoc state
-  @param    szPath    `file.jpg` , `../images\*` or `../folder/`
+  @param    pRoot     top folder
   @return   none
 -------------------------------------------------------------------------------------------------*/
-void FlyDocPreProcess(flyDoc_t *pDoc, const char *szPath)
+static void MdWalkList(flyDoc_t *pDoc, flyDocWalkDir_t *pRoot)
 {
-  bool_t  fExists   = FALSE;
-  bool_t  fIsFolder = FALSE;
+  flyDocWalkDir_t **apDirs;
+  flyDocWalkDir_t **apNext;
+  flyDocWalkDir_t **apGrow;
+  flyDocWalkDir_t  *pDir;
+  const char       *pszPath;
+  unsigned          nDirs;
+  unsigned          nNext;
+  unsigned          maxNext;
+  unsigned          nEntries;
+  unsigned          i;
+  unsigned          j;
+
+  apDirs = FlyDocAlloc(sizeof(*apDirs));
+  apDirs[0] = pRoot;
+  nDirs = 1;
+  while(nDirs)
+  {
+    FlyDocJobsRun(pDoc->opts.nJobs, nDirs, MdWalkJob, MdWalkJobDone, apDirs);
+
+    // gather the subfolders of this level in order, they are the next level
+    apNext  = NULL;
+    nNext   = 0;
+    maxNext = 0;
+    for(i = 0; i < nDirs; ++i)
+    {
+      pDir = apDirs[i];
+      if(!pDir->hList)
+        continue;
+      nEntries = FlyFileListLen(pDir->hList);
+      if(nEntries == 0)
+        continue;
+      pDir->apSubDirs = FlyAllocZ(nEntries * sizeof(*pDir->apSubDirs));
+      FlyDocAllocCheck(pDir->apSubDirs);
+      for(j = 0; j < nEntries; ++j)
+      {
+        pszPath = FlyFileListGetName(pDir->hList, j);
+        if(!FlyStrPathIsFolder(pszPath) || MdIsExcluded(pDoc, pszPath))
+          continue;
+        if(nNext >= maxNext)
+        {
+          maxNext = maxNext ? 2 * maxNext : 64;
+          apGrow = FlyDocAlloc(maxNext * sizeof(*apGrow));
+          if(nNext)
+            memcpy(apGrow, apNext, nNext * sizeof(*apGrow));
+          FlyFreeIf(apNext);
+          apNext = apGrow;
+        }
+        pDir->apSubDirs[j] = MdWalkDirNew(pszPath, "*", pDir->level + 1);
+        apNext[nNext++] = pDir->apSubDirs[j];
+      }
+    }
 
-  // wildcard, let FlyFileListRecurse() process it
-  if(strpbrk(szPath, "*?"))
-  {
-    fExists = TRUE;
-    fIsFolder = TRUE;
+    FlyFree(apDirs);
+    apDirs = apNext;
+    nDirs  = nNext;
   }
-  else
-    fExists = FlyFileExists(szPath, &fIsFolder);
+  FlyFreeIf(apDirs);
+}
 
-  if(fExists)
-  {
-    // add any files with proper extension to image list, recursing into subfolders
-    if(fIsFolder)
-      FlyFileListRecurse(szPath, FLYDOC_MAX_DEPTH, FlyDocProcessImage, pDoc);
+/*-------------------------------------------------------------------------------------------------
+  Add the files in a listed folder tree, in the same depth first order as a serial walk.
+
+  @param    pDoc      flydoc state
+  @param    pDir      listed folder
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdWalkAdd(flyDoc_t *pDoc, const flyDocWalkDir_t *pDir)
+{
+  const flyDocWalkDir_t  *pSubDir;
+  const char             *pszPath;
+  unsigned                i;
 
-    // single file, if it's the right extention, add to image list
-    else if(FlyStrPathHasExt(szPath, m_szImageExts))
-      FlyDocImgFileListAdd(pDoc, szPath);
+  if(pDoc->pWatch)
+    FlyDocWatchFolder(pDoc, pDir->szPath);
+  for(i = 0; i < FlyFileListLen(pDir->hList); ++i)
+  {
+    pszPath = FlyFileListGetName(pDir->hList, i);
+    pSubDir = pDir->apSubDirs ? pDir->apSubDirs[i] : NULL;
+    if(pSubDir)
+    {
+      if(pSubDir->hList)
+        MdWalkAdd(pDoc, pSubDir);
+      else
+        FlyDocInputAdd(pDoc, pSubDir->szPath, TRUE);
+    }
+    else if(!FlyStrPathIsFolder(pszPath) && !MdIsExcluded(pDoc, pszPath))
+    {
+      pDoc->level = pDir->level;
+      MdInputFile(pDoc, pszPath);
+    }
   }
 }
 
 /*!------------------------------------------------------------------------------------------------
-  Fills in the flyDoc_t structture from input files and folders.
+  Walks input files and folders once, collecting input image files into pDoc->pImgFileList and
+  queuing source and markdown files for FlyDocParseInputs(). All images must be known before any
+  markdown is parsed, so nothing is parsed here.
 
-  Outputs warnings and errors found in the input files.
+  Files and folders matching --exclude patterns are skipped, and excluded folders are not walked.
+  With -j, folders are listed in parallel. The order of files is always the same.
 
   The flydoc state is guaranteed to be valid. If any invalid input, then that input may be ignored.
 
@@ -2249,55 +2467,497 @@ void FlyDocPreProcess(flyDoc_t *pDoc, const char *szPath)
 -------------------------------------------------------------------------------------------------*/
 void FlyDocProcessFolderTree(flyDoc_t *pDoc, const char *szPath)
 {
-  void         *hList;
-  const char   *pszPath;
-  unsigned      i;
+  flyDocWalkDir_t  *pRoot;
 
   if(pDoc->opts.debug)
-    printf("--- FlyDocProcessFolderTree(level=%u, path=%s) ---\n", pDoc->level, szPath);
-
-  // szInPath used for recursion into subfolders
-  if(pDoc->level == 0)
-    *pDoc->szInPath = '\0';
+    printf("--- FlyDocProcessFolderTree(path=%s) ---\n", szPath);
 
   // single file, process it
+  pDoc->level = 0;
   if(FlyFileExistsFile(szPath))
   {
-    FlyDocParseFile(pDoc, szPath);
+    if(pDoc->pWatch)
+      FlyDocWatchFolder(pDoc, szPath);
+    MdInputFile(pDoc, szPath);
   }
 
+  // a folder or wildcard (if folder, FlyFileListNewEx() will add wildcard)
   else
   {
-    // create a list from the path (if folder, will add wildcard)
-    hList = FlyFileListNewEx(szPath);
-    if(!hList)
+    pRoot = MdWalkDirNew(szPath, "", 0);
+    MdWalkList(pDoc, pRoot);
+    if(!pRoot->hList)
+      FlyDocInputAdd(pDoc, szPath, TRUE);
+    else
+      MdWalkAdd(pDoc, pRoot);
+    MdWalkDirFree(pRoot);
+  }
+  pDoc->level = 0;
+}
+
+// each input file is parsed into its own partial doc, see FlyDocParseInputs()
+typedef struct
+{
+  flyDoc_t           *pPartial;     // NULL if input is invalid
+  char               *szWarn;       // warnings from parsing, in order (allocated by open_memstream())
+  size_t              lenWarn;
+  flyDocWatchFile_t  *pWatchFile;   // --watch state of this input, or NULL
+  bool_t              fUnchanged;   // --watch: loaded from last build without reading the file
+} flyDocPartialJob_t;
+
+typedef struct
+{
+  flyDoc_t            *pDoc;
+  flyDocPartialJob_t  *aJobs;
+} flyDocPartialJobs_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Free everything parsed into a partial doc, leaving it empty.
+
+  @param    pPartial    a partial doc from MdParseJob()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdPartialClear(flyDoc_t *pPartial)
+{
+  FlyDocArenaFree(&pPartial->arena);
+  pPartial->pMainPage     = NULL;
+  pPartial->pModList      = NULL;
+  pPartial->pClassList    = NULL;
+  pPartial->pMarkdownList = NULL;
+  pPartial->pImageList    = NULL;
+  memset(&pPartial->modIndex, 0, sizeof(pPartial->modIndex));
+  memset(&pPartial->classIndex, 0, sizeof(pPartial->classIndex));
+  memset(&pPartial->pageIndex, 0, sizeof(pPartial->pageIndex));
+  pPartial->nPages        = 0;
+  pPartial->nFiles        = 0;
+  pPartial->nDocComments  = 0;
+  pPartial->nWarnings     = 0;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Free a partial doc that won't be merged, and everything parsed into it.
+
+  @param    pPartial    a partial doc from MdParseJob()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdPartialFree(flyDoc_t *pPartial)
+{
+  MdPartialClear(pPartial);
+  FlyFree(pPartial);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Would merging this partial doc differ from parsing the file directly into pDoc?
+
+  A file parsed on its own can't know about the modules, classes, documents or mainpage already in
+  pDoc. As long as the file only adds new things or adds functions, examples and styles to existing
+  modules/classes, the merged result is the same. Otherwise the file must be parsed again in order
+  (rare), so that the results and warnings are the same.
+
+  @param    pDoc        main flydoc state being merged into
+  @param    pPartial    a partial doc from MdParseJob()
+  @return   TRUE if the file must be parsed again into pDoc
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdPartialConflicts(const flyDoc_t *pDoc, const flyDoc_t *pPartial)
+{
+  char              szNameBase[PATH_MAX];
+  flyDocModule_t   *pMod;
+  flyDocMarkdown_t *pMarkdown;
+  unsigned          i;
+
+  if(pPartial->pMainPage && pDoc->pMainPage)
+    return TRUE;
+
+  // defined modules/classes (not only stubs for @ingroup/@inclass) are duplicate checked
+  for(i = 0; i < 2; ++i)
+  {
+    pMod = i ? pPartial->pClassList : pPartial->pModList;
+    while(pMod)
+    {
+      if(pMod->section.szSubtitle || pMod->section.szText)
+      {
+        if(FlyDocModFind(pDoc, pMod->section.szTitle, i))
+          return TRUE;
+        FlyDocMakeNameBase(szNameBase, pMod->section.szTitle, sizeof(szNameBase));
+        if(strcasecmp(szNameBase, "index") == 0 || FlyDocIsDup(pDoc, pMod->section.szTitle))
+          return TRUE;
+      }
+      pMod = pMod->pNext;
+    }
+  }
+
+  pMarkdown = pPartial->pMarkdownList;
+  while(pMarkdown)
+  {
+    FlyDocMakeNameBase(szNameBase, pMarkdown->section.szTitle, sizeof(szNameBase));
+    if(strcasecmp(szNameBase, "index") == 0 || FlyDocIsDup(pDoc, pMarkdown->section.szTitle))
+      return TRUE;
+    pMarkdown = pMarkdown->pNext;
+  }
+
+  return FALSE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Move the fields set by @ingroup/@inclass functions from a stub partial section to pDoc's section.
+
+  @param    pSection    section in pDoc
+  @param    pStub       section in the partial doc
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdSectionMerge(flyDocSection_t *pSection, flyDocSection_t *pStub)
+{
+  char            **appszStyle[] =
+  {
+    &pSection->szBarColor, &pSection->szTitleColor, &pSection->szHeadingColor, &pSection->szFontBody,
+    &pSection->szFontHeadings, &pSection->szLogo, &pSection->szVersion
+  };
+  char            **appszStub[] =
+  {
+    &pStub->szBarColor, &pStub->szTitleColor, &pStub->szHeadingColor, &pStub->szFontBody,
+    &pStub->szFontHeadings, &pStub->szLogo, &pStub->szVersion
+  };
+  flyDocExample_t  *pExample;
+  unsigned          i;
+
+  // later styles override earlier ones
+  for(i = 0; i < NumElements(appszStyle); ++i)
+  {
+    if(*appszStub[i])
+    {
+      *appszStyle[i] = *appszStub[i];
+      *appszStub[i] = NULL;
+    }
+  }
+
+  while(pStub->pExampleList)
+  {
+    pExample = pStub->pExampleList;
+    pStub->pExampleList = pExample->pNext;
+    pExample->pNext = NULL;
+    pSection->pExampleList = FlyListAppend(pSection->pExampleList, pExample);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Merge a partial doc into pDoc. Items are added in the order they were parsed, so lists end up
+  the same as if the file had been parsed directly into pDoc. The partial doc's arena moves into
+  pDoc's arena. Frees the partial doc.
+
+  @param    pDoc        main flydoc state
+  @param    pPartial    partial doc from MdParseJob()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdPartialMerge(flyDoc_t *pDoc, flyDoc_t *pPartial)
+{
+  flyDocModule_t   *pMod;
+  flyDocModule_t   *pFound;
+  flyDocFunc_t     *pFunc;
+  flyDocFunc_t     *pFuncNext;
+  flyDocMarkdown_t *pMarkdown;
+  flyDocImage_t    *pImage;
+  void             *pNext;
+  unsigned          i;
+
+  if(pPartial->pMainPage)
+    pDoc->pMainPage = pPartial->pMainPage;
+
+  for(i = 0; i < 2; ++i)
+  {
+    pMod    = i ? pPartial->pClassList : pPartial->pModList;
+    while(pMod)
     {
-      FlyDocPrintWarning(pDoc, szWarningInvalidInput, szPath);
-      return;
+      pNext = pMod->pNext;
+      pMod->pNext = NULL;
+      pFunc = pMod->pFuncList;
+
+      // new module, its functions are already in parse order
+      pFound = FlyDocModFind(pDoc, pMod->section.szTitle, i);
+      if(pFound == NULL)
+      {
+        FlyDocModAdd(pDoc, pMod, i);
+        pFunc = NULL;
+      }
+
+      // only a stub in the partial, merge into existing module or class
+      else
+        MdSectionMerge(&pFound->section, &pMod->section);
+
+      while(pFunc)
+      {
+        pFuncNext = pFunc->pNext;
+        pFunc->pNext = NULL;
+        pFound->pFuncList = FlyListAppend(pFound->pFuncList, pFunc);
+        pFunc = pFuncNext;
+      }
+
+      pMod = pNext;
     }
+  }
 
-    // traverse folder tree
+  pMarkdown = pPartial->pMarkdownList;
+  while(pMarkdown)
+  {
+    pNext = pMarkdown->pNext;
+    pMarkdown->pNext = NULL;
+    FlyDocMarkdownAdd(pDoc, pMarkdown);
+    pMarkdown = pNext;
+  }
+
+  // now that it's in order, mark image files as referenced
+  pImage = pPartial->pImageList;
+  while(pImage)
+  {
+    pNext = pImage->pNext;
+    pImage->pNext = NULL;
+    if(!FlyDocImageHasPath(pImage->szLink))
+      FlyDocImageFileFind(pDoc, pImage->szLink, TRUE);
+    pDoc->pImageList = FlyListAppend(pDoc->pImageList, pImage);
+    pImage = pNext;
+  }
+
+  pDoc->nFiles        += pPartial->nFiles;
+  pDoc->nDocComments  += pPartial->nDocComments;
+  pDoc->nWarnings     += pPartial->nWarnings;
+
+  FlyDocArenaMove(&pDoc->arena, &pPartial->arena);
+  FlyFree(pPartial);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Parse one queued input file into its own partial doc. Runs on a worker thread.
+
+  Only the options and the image file list (read only) are shared with the main doc. With --cache,
+  unchanged source files are loaded rather than parsed. With --watch, source files not modified
+  since the last build are loaded from memory without being read, see flydocwatch.c.
+
+  @param    pData   ptr to flyDocPartialJobs_t
+  @param    i       index into the input queue
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdParseJob(void *pData, unsigned i)
+{
+  flyDocPartialJobs_t  *pJobs     = pData;
+  flyDocPartialJob_t   *pJob      = &pJobs->aJobs[i];
+  const flyDoc_t       *pDoc      = pJobs->pDoc;
+  flyDocWatchFile_t    *pWatchFile = pJob->pWatchFile;
+  flyDoc_t             *pPartial;
+  const char           *szPath;
+  void                 *pCache;
+  size_t                lenCache;
+  flyDocInFile_t        inFile;
+  flyDocInFile_t       *pIn       = NULL;
+  uint64_t              hContents = 0;
+  uint64_t              nsRead    = 0;
+  bool_t                fSrc;
+  bool_t                fSame     = FALSE;
+  bool_t                fCached   = FALSE;
+  bool_t                fKept     = FALSE;
+  bool_t                fSave     = FALSE;
+
+  if(pDoc->aInputs[i].fInvalid)
+    return;
+
+  pPartial = FlyDocAlloc(sizeof(*pPartial));
+  memset(pPartial, 0, sizeof(*pPartial));
+  pPartial->sanchk        = pDoc->sanchk;
+  pPartial->opts          = pDoc->opts;
+  pPartial->opts.verbose  = FLYDOC_VERBOSE_NONE;
+  pPartial->pImgFileList  = pDoc->pImgFileList;
+  pPartial->imgIndex      = pDoc->imgIndex;
+  pPartial->hCache        = pDoc->hCache;
+  pPartial->pSpill        = pDoc->pSpill;
+  pPartial->fPartial      = TRUE;
+
+  // warnings are printed in order when the partial doc is merged
+  pPartial->fpWarn = open_memstream(&pJob->szWarn, &pJob->lenWarn);
+  FlyDocAllocCheck(pPartial->fpWarn);
+
+  szPath = pDoc->aInputs[i].szPath;
+  fSrc   = FlyStrPathHasExt(szPath, pDoc->opts.szExts);
+
+  // --watch: source file not modified since last build, don't even read it
+  if(pWatchFile)
+    fSame = FlyDocWatchFileSame(pWatchFile);
+  if(fSame && fSrc && pWatchFile->pCache)
+  {
+    fKept = FlyDocCacheLoadMem(pPartial, szPath, pWatchFile->hContents, pWatchFile->pCache, pWatchFile->lenCache);
+    if(fKept)
+      fCached = pJob->fUnchanged = TRUE;
     else
+      MdPartialClear(pPartial);
+  }
+
+  // source files may be in the --cache (or kept by --watch), keyed by contents
+  if(!fCached && fSrc && (pDoc->opts.szCache || pWatchFile))
+  {
+    if(pDoc->opts.fProfile)
+      nsRead = FlyDocProfNow();
+    FlyDocInFileRead(&inFile, szPath);
+    if(pDoc->opts.fProfile)
+      nsRead = FlyDocProfNow() - nsRead;
+    pIn = &inFile;
+    if(inFile.len)
     {
-      for(i = 0; i < FlyFileListLen(hList); ++i)
+      hContents = FlyDocHash(inFile.szFile, inFile.len, FLYDOC_HASH_INIT);
+      if(pWatchFile && pWatchFile->pCache && pWatchFile->hContents == hContents)
       {
-        pszPath = FlyFileListGetName(hList, i);
-        if(FlyStrPathIsFolder(pszPath))
-        {
-          ++pDoc->level;
-          strcpy(pDoc->szInPath, pszPath);
-          strcat(pDoc->szInPath, "*");
-          FlyDocProcessFolderTree(pDoc, pDoc->szInPath);
-          FlyStrPathParent(pDoc->szInPath, PATH_MAX);
-          --pDoc->level;
-        }
-        else
-        {
-          FlyDocParseFile(pDoc, pszPath);
-        }
+        fKept = FlyDocCacheLoadMem(pPartial, szPath, hContents, pWatchFile->pCache, pWatchFile->lenCache);
+        if(!fKept)
+          MdPartialClear(pPartial);
+      }
+      if(fKept || (pDoc->opts.szCache && FlyDocCacheLoad(pPartial, szPath, hContents, i)))
+      {
+        pPartial->fileProf.len = inFile.len;
+        FlyDocInFileFree(&inFile);
+        pIn = NULL;
+        fCached = TRUE;
       }
+      else
+      {
+        MdPartialClear(pPartial);
+        fSave = TRUE;
+      }
+    }
+  }
 
-      FlyFileListFree(hList);
+  if(!fCached)
+  {
+    FlyDocParseFileEx(pPartial, szPath, pIn);
+    if(fSave && pDoc->opts.szCache)
+    {
+      fflush(pPartial->fpWarn);
+      FlyDocCacheSave(pPartial, szPath, hContents, pJob->szWarn, pJob->lenWarn, i);
     }
   }
+
+  // --watch: keep the partial doc for the next build
+  if(pWatchFile && hContents && !fKept)
+  {
+    fflush(pPartial->fpWarn);
+    if(FlyDocCacheSaveMem(pPartial, szPath, hContents, pJob->szWarn, pJob->lenWarn, &pCache, &lenCache))
+      FlyDocWatchFileCache(pWatchFile, hContents, pCache, lenCache);
+  }
+  pPartial->fileProf.nsRead += nsRead;    // with --cache, file was read above
+  fclose(pPartial->fpWarn);
+  pPartial->fpWarn        = NULL;
+  pPartial->pImgFileList  = NULL;
+  memset(&pPartial->imgIndex, 0, sizeof(pPartial->imgIndex));
+
+  pJob->pPartial = pPartial;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Merge a parsed input file into the main doc. Called in input order on the main thread.
+
+  @param    pData   ptr to flyDocPartialJobs_t
+  @param    i       index into the input queue
+  @return   TRUE to continue with the next input
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdParseJobDone(void *pData, unsigned i)
+{
+  flyDocPartialJobs_t  *pJobs     = pData;
+  flyDocPartialJob_t   *pJob      = &pJobs->aJobs[i];
+  flyDoc_t             *pDoc      = pJobs->pDoc;
+  flyDocInput_t        *pInput    = &pDoc->aInputs[i];
+
+  if(pInput->fInvalid)
+    FlyDocPrintWarning(pDoc, szWarningInvalidInput, pInput->szPath);
+
+  // depends on earlier files, parse it again into the main doc
+  else if(MdPartialConflicts(pDoc, pJob->pPartial))
+  {
+    MdPartialFree(pJob->pPartial);
+    FlyDocParseFile(pDoc, pInput->szPath);
+    FlyDocProfFile(pDoc, pInput->szPath, &pDoc->fileProf);
+  }
+
+  else
+  {
+    if(pJob->pPartial->nFiles && !pJob->fUnchanged && pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
+      printf("%s\n", pInput->szPath);
+    if(pJob->lenWarn)
+      fwrite(pJob->szWarn, 1, pJob->lenWarn, stderr);
+    FlyDocProfFile(pDoc, pInput->szPath, &pJob->pPartial->fileProf);
+    MdPartialMerge(pDoc, pJob->pPartial);
+  }
+
+  pJob->pPartial = NULL;
+  if(pJob->szWarn)
+    free(pJob->szWarn);
+  pJob->szWarn = NULL;
+  FlyFree(pInput->szPath);
+  pInput->szPath = NULL;
+
+  return TRUE;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Parse all input files queued by FlyDocProcessFolderTree(), in order.
+
+  With -j=# threads, --cache and/or --watch, each file is parsed into its own partial doc, then the
+  partial docs are merged into pDoc in input order. The results and warnings are exactly the same
+  as parsing the files one at a time.
+
+  @param    pDoc      flydoc state
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocParseInputs(flyDoc_t *pDoc)
+{
+  flyDocPartialJobs_t   jobs;
+  unsigned              i;
+
+  if(pDoc->opts.debug)
+    printf("--- FlyDocParseInputs(nInputs=%u, nJobs=%d) ---\n", pDoc->nInputs, pDoc->opts.nJobs);
+
+  // without -j or --cache, parse each file in order directly into pDoc
+  if(!FlyDocUsePartials(pDoc))
+  {
+    for(i = 0; i < pDoc->nInputs; ++i)
+    {
+      if(pDoc->aInputs[i].fInvalid)
+        FlyDocPrintWarning(pDoc, szWarningInvalidInput, pDoc->aInputs[i].szPath);
+      else
+      {
+        FlyDocParseFile(pDoc, pDoc->aInputs[i].szPath);
+        FlyDocProfFile(pDoc, pDoc->aInputs[i].szPath, &pDoc->fileProf);
+      }
+    }
+  }
+
+  else if(pDoc->nInputs)
+  {
+    // a bad cache folder is just a warning, parse without it
+    if(pDoc->opts.szCache && !FlyDocCreateFolder(pDoc, pDoc->opts.szCache))
+    {
+      FlyDocPrintWarning(pDoc, szWarningCreateFolder, pDoc->opts.szCache);
+      pDoc->opts.szCache = NULL;
+    }
+    if(pDoc->opts.szCache || pDoc->pWatch)
+      pDoc->hCache = FlyDocCacheContext(pDoc);
+
+    jobs.pDoc  = pDoc;
+    jobs.aJobs = FlyAllocZ(pDoc->nInputs * sizeof(*jobs.aJobs));
+    FlyDocAllocCheck(jobs.aJobs);
+
+    // --watch state is looked up before parsing starts, so each job only touches its own
+    if(pDoc->pWatch)
+    {
+      for(i = 0; i < pDoc->nInputs; ++i)
+      {
+        if(!pDoc->aInputs[i].fInvalid)
+          jobs.aJobs[i].pWatchFile = FlyDocWatchFile(pDoc, pDoc->aInputs[i].szPath);
+      }
+    }
+    FlyDocJobsRun(pDoc->opts.nJobs, pDoc->nInputs, MdParseJob, MdParseJobDone, &jobs);
+    FlyFree(jobs.aJobs);
+  }
+
+  // paths are cloned by FlyDocInputAdd(), MdParseJobDone() frees those it merges
+  for(i = 0; i < pDoc->nInputs; ++i)
+    FlyFreeIf(pDoc->aInputs[i].szPath);
+  FlyFreeIf(pDoc->aInputs);
+  pDoc->aInputs   = NULL;
+  pDoc->nInputs   = 0;
+  pDoc->maxInputs = 0;
 }
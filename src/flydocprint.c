@@ -37,14 +37,16 @@ const char m_szEmpty[]             = "";
 
   Warning: W010 - couldn't create folder: ../foo/
 
-  @param    pDoc        ptr to document object
+  @param    pDoc        ptr to document object, warnings go to pDoc->fpWarn, or stderr if NULL
   @param    szWarning   ptr to warning msg
   @param    szExtra     more information, such as a folder or filename
   @return   none
 -------------------------------------------------------------------------------------------------*/
 void FlyDocPrintWarning(flyDoc_t *pDoc, const char *szWarning, const char *szExtra)
 {
-  fprintf(stderr, "Warning: %s%s\n", szWarning, szExtra ? szExtra : "");
+  FILE *fp = pDoc->fpWarn ? pDoc->fpWarn : stderr;
+
+  fprintf(fp, "Warning: %s%s\n", szWarning, szExtra ? szExtra : "");
   ++pDoc->nWarnings;
 }
 
@@ -74,17 +76,106 @@ void FlyDocPrintWarningEx(
   unsigned    line    = 1;
   unsigned    col     = 1;
   const char *szLine  = szFile;
+  FILE       *fp      = pDoc->fpWarn ? pDoc->fpWarn : stderr;
 
-  line = FlyStrLinePos(szFile, szFilePos, &col);
-  if(line)
-    szLine = FlyStrLineGoto(szFile, line);
-  fprintf(stderr, "%s:%u:%u: %s%s\n", pDoc->szPath, line, col, szWarning,
-                  szExtra ? szExtra : "");
-  fprintf(stderr, "%.*s\n", (unsigned)FlyStrLineLen(szLine), szLine);
-  fprintf(stderr, "%*s^\n", col - 1, " ");
+  if(szFile == pDoc->szFile)
+    line = FlyDocLinePos(pDoc, szFilePos, &col, &szLine);
+  else
+  {
+    line = FlyStrLinePos(szFile, szFilePos, &col);
+    if(line)
+      szLine = FlyStrLineGoto(szFile, line);
+  }
+  fprintf(fp, "%s:%u:%u: %s%s\n", pDoc->szPath, line, col, szWarning,
+              szExtra ? szExtra : "");
+  fprintf(fp, "%.*s\n", (unsigned)FlyStrLineLen(szLine), szLine);
+  fprintf(fp, "%*s^\n", col - 1, " ");
   ++pDoc->nWarnings;
 }
 
+/*-------------------------------------------------------------------------------------------------
+  Build the table of line start offsets for pDoc->szFile.
+
+  @param    pDoc        document state with szFile and lenFile
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdLinesBuild(flyDoc_t *pDoc)
+{
+  const char *szFile  = pDoc->szFile;
+  const char *szEnd   = szFile + pDoc->lenFile;
+  const char *psz;
+  unsigned    nLines  = 1;
+
+  for(psz = szFile; (psz = memchr(psz, '\n', szEnd - psz)) != NULL; ++psz)
+    ++nLines;
+
+  pDoc->aLineStarts = FlyAlloc(nLines * sizeof(*pDoc->aLineStarts));
+  FlyDocAllocCheck(pDoc->aLineStarts);
+  pDoc->aLineStarts[0] = 0;
+  nLines = 1;
+  for(psz = szFile; (psz = memchr(psz, '\n', szEnd - psz)) != NULL; ++psz)
+    pDoc->aLineStarts[nLines++] = (psz + 1) - szFile;
+  pDoc->nLineStarts = nLines;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Find the line and column of a position in pDoc->szFile, like FlyStrLinePos(), but with a binary
+  search of a line start table rather than scanning from the top of the file. The table is built
+  the 1st time it's needed for a file, so files without warnings cost nothing.
+
+  @param    pDoc        document state with szFile and lenFile
+  @param    szPos       position in pDoc->szFile
+  @param    pCol        returned column, 1-n
+  @param    ppszLine    returned ptr to start of line
+  @return   line 1-n, or 0 if szPos is not in pDoc->szFile (*pCol and *ppszLine are not changed)
+-------------------------------------------------------------------------------------------------*/
+unsigned FlyDocLinePos(flyDoc_t *pDoc, const char *szPos, unsigned *pCol, const char **ppszLine)
+{
+  size_t    offset;
+  unsigned  lo;
+  unsigned  hi;
+  unsigned  mid;
+
+  if(!pDoc->szFile || szPos < pDoc->szFile || szPos > pDoc->szFile + pDoc->lenFile)
+    return 0;
+
+  if(pDoc->nLineStarts == 0)
+    MdLinesBuild(pDoc);
+
+  // find last line that starts at or before szPos
+  offset = szPos - pDoc->szFile;
+  lo = 0;
+  hi = pDoc->nLineStarts;
+  while(hi - lo > 1)
+  {
+    mid = lo + (hi - lo) / 2;
+    if(pDoc->aLineStarts[mid] <= offset)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  // column is computed within the line, the same way as for the whole file
+  *ppszLine = pDoc->szFile + pDoc->aLineStarts[lo];
+  FlyStrLinePos(*ppszLine, szPos, pCol);
+
+  return lo + 1;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Free the line start table for pDoc->szFile. Call when done with the file.
+
+  @param    pDoc        document state
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocLinesFree(flyDoc_t *pDoc)
+{
+  if(pDoc->aLineStarts)
+    FlyFree(pDoc->aLineStarts);
+  pDoc->aLineStarts = NULL;
+  pDoc->nLineStarts = 0;
+}
+
 /*!------------------------------------------------------------------------------------------------
   Print assert "Warning: W013 - internal error, out of memory" with stack trace.
   @return   none
@@ -369,6 +460,8 @@ void FlyDocPrintStats(const flyDoc_t *pDoc)
   printf("  %*u file%s processed\n", width, pDoc->nFiles, (pDoc->nFiles == 1) ? "" : "s");
   printf("  %*u flydoc comment%s processed\n", width, pDoc->nDocComments, (pDoc->nDocComments == 1) ? "" : "s");
   printf("  %*u warning%s\n", width, pDoc->nWarnings, (pDoc->nWarnings == 1) ? "" : "s");
+  if(FlyDocSpillSize(pDoc))
+    printf("  %*zu MB of text spilled to disk (--max-mem)\n", width, (FlyDocSpillSize(pDoc) + 1024 * 1024 - 1) / (1024 * 1024));
 }
 
 /*!------------------------------------------------------------------------------------------------
@@ -0,0 +1,380 @@
+/**************************************************************************************************
+  flydocprof.c - Phase timing and counters for --profile
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <sys/resource.h>
+#include <time.h>
+#include "flydoc.h"
+
+#define FLYDOC_PROF_SLOW    10      // # of slowest input files and output pages to report
+#define FLYDOC_NS_PER_MS    1000000.0
+
+/*!
+  @defgroup flydoc_prof   Phase timing and counters for --profile
+
+  With `--profile`, flydoc reports where the time goes:
+
+  1. wall and CPU time for each phase: folder walk, parse, sort, write and image copy
+  2. time to read, parse source and parse markdown, summed over all input files
+  3. bytes read and written, arena allocations and peak RSS
+  4. the slowest input files and output pages
+
+  `--profile-json file` writes the same report as JSON, for comparing runs in scripts.
+
+  With -j=#, files are read and parsed (and pages written) on worker threads, so the per-file times
+  add up to more than the wall time of the phase. Worker threads only time themselves: the counters
+  are updated on the main thread, in order, by the "done" callbacks. Images are found during the
+  folder walk, so there is no separate image phase before parsing.
+*/
+
+// an input file or output page and how long it took
+typedef struct
+{
+  char       *szPath;       // NULL if slot unused
+  uint64_t    ns;
+} flyDocProfSlow_t;
+
+// --profile counters, allocated by FlyDocProfInit()
+typedef struct flyDocProf
+{
+  flyDocPhase_t     phase;                  // current phase, or FLYDOC_PHASE_MAX if none
+  uint64_t          nsWallStart;            // start of current phase
+  uint64_t          nsCpuStart;
+  uint64_t          aNsWall[FLYDOC_PHASE_MAX];
+  uint64_t          aNsCpu[FLYDOC_PHASE_MAX];
+  uint64_t          nsRead;                 // summed over all input files
+  uint64_t          nsParseSrc;
+  uint64_t          nsParseMd;
+  uint64_t          nsPages;                // summed over all output pages
+  uint64_t          bytesRead;
+  uint64_t          bytesWritten;
+  unsigned          nFiles;
+  unsigned          nPages;
+  flyDocProfSlow_t  aSlowFiles[FLYDOC_PROF_SLOW];
+  flyDocProfSlow_t  aSlowPages[FLYDOC_PROF_SLOW];
+} flyDocProf_t;
+
+static const char *m_aszPhases[FLYDOC_PHASE_MAX] =
+{
+  "walk", "parse", "sort", "write", "images"
+};
+
+/*-------------------------------------------------------------------------------------------------
+  Get a clock in nanoseconds.
+
+  @param    clockId   e.g. CLOCK_MONOTONIC
+  @return   time in nanoseconds
+-------------------------------------------------------------------------------------------------*/
+static uint64_t MdProfClock(clockid_t clockId)
+{
+  struct timespec ts;
+
+  clock_gettime(clockId, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Keep track of the slowest items. The list is sorted, slowest 1st.
+
+  @param    aSlow     array of FLYDOC_PROF_SLOW items
+  @param    szPath    path to input file or output page
+  @param    ns        how long it took
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdProfSlowAdd(flyDocProfSlow_t *aSlow, const char *szPath, uint64_t ns)
+{
+  unsigned  i;
+
+  if(aSlow[FLYDOC_PROF_SLOW - 1].szPath && ns <= aSlow[FLYDOC_PROF_SLOW - 1].ns)
+    return;
+
+  FlyFreeIf(aSlow[FLYDOC_PROF_SLOW - 1].szPath);
+  for(i = FLYDOC_PROF_SLOW - 1; i > 0 && (aSlow[i - 1].szPath == NULL || aSlow[i - 1].ns < ns); --i)
+    aSlow[i] = aSlow[i - 1];
+  aSlow[i].szPath = FlyStrClone(szPath);
+  FlyDocAllocCheck(aSlow[i].szPath);
+  aSlow[i].ns = ns;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Get peak resident set size of this process.
+
+  @return   peak RSS in kilobytes
+-------------------------------------------------------------------------------------------------*/
+static long MdProfPeakRssKb(void)
+{
+  struct rusage usage;
+
+  memset(&usage, 0, sizeof(usage));
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write a string as a JSON string, with quotes.
+
+  @param    fp      file to write to
+  @param    sz      string
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdProfJsonStr(FILE *fp, const char *sz)
+{
+  fputc('"', fp);
+  for( ; *sz; ++sz)
+  {
+    if(*sz == '"' || *sz == '\\')
+      fprintf(fp, "\\%c", *sz);
+    else if((uint8_t)*sz < ' ')
+      fprintf(fp, "\\u%04x", (unsigned)(uint8_t)*sz);
+    else
+      fputc(*sz, fp);
+  }
+  fputc('"', fp);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Write a list of slowest items as a JSON array.
+
+  @param    fp      file to write to
+  @param    aSlow   array of FLYDOC_PROF_SLOW items
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdProfJsonSlow(FILE *fp, const flyDocProfSlow_t *aSlow)
+{
+  unsigned  i;
+
+  fprintf(fp, "[");
+  for(i = 0; i < FLYDOC_PROF_SLOW && aSlow[i].szPath; ++i)
+  {
+    fprintf(fp, "%s\n    {\"path\": ", i ? "," : "");
+    MdProfJsonStr(fp, aSlow[i].szPath);
+    fprintf(fp, ", \"ms\": %.3f}", aSlow[i].ns / FLYDOC_NS_PER_MS);
+  }
+  fprintf(fp, "%s]", i ? "\n  " : "");
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Get a monotonic clock for timing.
+
+  @return   time in nanoseconds
+-------------------------------------------------------------------------------------------------*/
+uint64_t FlyDocProfNow(void)
+{
+  return MdProfClock(CLOCK_MONOTONIC);
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Start profiling if --profile or --profile-json. Does nothing otherwise.
+
+  @param    pDoc      main doc
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocProfInit(flyDoc_t *pDoc)
+{
+  if(pDoc->opts.szProfileJson)
+    pDoc->opts.fProfile = TRUE;
+  if(pDoc->opts.fProfile && pDoc->pProf == NULL)
+  {
+    pDoc->pProf = FlyAllocZ(sizeof(*pDoc->pProf));
+    FlyDocAllocCheck(pDoc->pProf);
+    pDoc->pProf->phase = FLYDOC_PHASE_MAX;
+  }
+}
+
+/*!------------------------------------------------------------------------------------------------
+  End the current phase (if any) and start the next one.
+
+  @param    pDoc      main doc
+  @param    phase     phase to start, or FLYDOC_PHASE_MAX to just end the current one
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocProfPhase(flyDoc_t *pDoc, flyDocPhase_t phase)
+{
+  flyDocProf_t *pProf = pDoc->pProf;
+  uint64_t      nsWall;
+  uint64_t      nsCpu;
+
+  if(pProf)
+  {
+    nsWall = FlyDocProfNow();
+    nsCpu  = MdProfClock(CLOCK_PROCESS_CPUTIME_ID);
+    if(pProf->phase < FLYDOC_PHASE_MAX)
+    {
+      pProf->aNsWall[pProf->phase] += nsWall - pProf->nsWallStart;
+      pProf->aNsCpu[pProf->phase]  += nsCpu  - pProf->nsCpuStart;
+    }
+    pProf->phase       = phase;
+    pProf->nsWallStart = nsWall;
+    pProf->nsCpuStart  = nsCpu;
+  }
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Count an input file that has been read and parsed. Main thread only.
+
+  @param    pDoc        main doc
+  @param    szPath      path to input file
+  @param    pFileProf   times from FlyDocParseFileEx()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocProfFile(flyDoc_t *pDoc, const char *szPath, const flyDocFileProf_t *pFileProf)
+{
+  flyDocProf_t *pProf = pDoc->pProf;
+
+  if(pProf && pFileProf->len)
+  {
+    ++pProf->nFiles;
+    pProf->bytesRead += pFileProf->len;
+    pProf->nsRead    += pFileProf->nsRead;
+    if(pFileProf->fMarkdown)
+      pProf->nsParseMd  += pFileProf->nsParse;
+    else
+      pProf->nsParseSrc += pFileProf->nsParse;
+    MdProfSlowAdd(pProf->aSlowFiles, szPath, pFileProf->nsRead + pFileProf->nsParse);
+  }
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Count an output page (or file) that has been written. Main thread only.
+
+  @param    pDoc        main doc
+  @param    szPath      path to output file
+  @param    ns          time to build and write the page
+  @param    len         bytes written
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocProfPage(flyDoc_t *pDoc, const char *szPath, uint64_t ns, size_t len)
+{
+  flyDocProf_t *pProf = pDoc->pProf;
+
+  if(pProf)
+  {
+    ++pProf->nPages;
+    pProf->bytesWritten += len;
+    pProf->nsPages      += ns;
+    MdProfSlowAdd(pProf->aSlowPages, szPath, ns);
+  }
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Print the --profile report. Call after the last phase has ended.
+
+  @param    pDoc        main doc
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocProfPrint(const flyDoc_t *pDoc)
+{
+  const flyDocProf_t *pProf = pDoc->pProf;
+  uint64_t            nsWall = 0;
+  uint64_t            nsCpu  = 0;
+  unsigned            i;
+
+  if(!pProf)
+    return;
+
+  printf("\nProfile:\n");
+  printf("  %-16s %12s %12s\n", "phase", "wall ms", "cpu ms");
+  for(i = 0; i < FLYDOC_PHASE_MAX; ++i)
+  {
+    printf("  %-16s %12.3f %12.3f\n", m_aszPhases[i], pProf->aNsWall[i] / FLYDOC_NS_PER_MS,
+           pProf->aNsCpu[i] / FLYDOC_NS_PER_MS);
+    nsWall += pProf->aNsWall[i];
+    nsCpu  += pProf->aNsCpu[i];
+  }
+  printf("  %-16s %12.3f %12.3f\n", "total", nsWall / FLYDOC_NS_PER_MS, nsCpu / FLYDOC_NS_PER_MS);
+
+  printf("\n  summed over files and pages (all threads):\n");
+  printf("  %-16s %12.3f ms, %u files, %llu bytes\n", "file read", pProf->nsRead / FLYDOC_NS_PER_MS,
+         pProf->nFiles, (unsigned long long)pProf->bytesRead);
+  printf("  %-16s %12.3f ms\n", "source parse", pProf->nsParseSrc / FLYDOC_NS_PER_MS);
+  printf("  %-16s %12.3f ms\n", "markdown parse", pProf->nsParseMd / FLYDOC_NS_PER_MS);
+  printf("  %-16s %12.3f ms, %u pages, %llu bytes\n", "page write", pProf->nsPages / FLYDOC_NS_PER_MS,
+         pProf->nPages, (unsigned long long)pProf->bytesWritten);
+
+  printf("\n  %zu arena allocations, %zu arena bytes, %ld KB peak RSS\n", pDoc->arena.nAllocs,
+         pDoc->arena.size, MdProfPeakRssKb());
+
+  if(pProf->aSlowFiles[0].szPath)
+  {
+    printf("\n  slowest input files:\n");
+    for(i = 0; i < FLYDOC_PROF_SLOW && pProf->aSlowFiles[i].szPath; ++i)
+      printf("  %12.3f ms  %s\n", pProf->aSlowFiles[i].ns / FLYDOC_NS_PER_MS, pProf->aSlowFiles[i].szPath);
+  }
+  if(pProf->aSlowPages[0].szPath)
+  {
+    printf("\n  slowest output pages:\n");
+    for(i = 0; i < FLYDOC_PROF_SLOW && pProf->aSlowPages[i].szPath; ++i)
+      printf("  %12.3f ms  %s\n", pProf->aSlowPages[i].ns / FLYDOC_NS_PER_MS, pProf->aSlowPages[i].szPath);
+  }
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write the --profile report as JSON. Call after the last phase has ended.
+
+  @param    pDoc        main doc
+  @param    szPath      JSON file to write
+  @return   TRUE if worked, FALSE if couldn't write file
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocProfWriteJson(const flyDoc_t *pDoc, const char *szPath)
+{
+  const flyDocProf_t *pProf = pDoc->pProf;
+  FILE               *fp;
+  unsigned            i;
+
+  if(!pProf)
+    return TRUE;
+
+  fp = fopen(szPath, "w");
+  if(!fp)
+    return FALSE;
+
+  fprintf(fp, "{\n  \"phases\": {");
+  for(i = 0; i < FLYDOC_PHASE_MAX; ++i)
+  {
+    fprintf(fp, "%s\n    \"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}", i ? "," : "", m_aszPhases[i],
+            pProf->aNsWall[i] / FLYDOC_NS_PER_MS, pProf->aNsCpu[i] / FLYDOC_NS_PER_MS);
+  }
+  fprintf(fp, "\n  },\n");
+  fprintf(fp, "  \"read_ms\": %.3f,\n", pProf->nsRead / FLYDOC_NS_PER_MS);
+  fprintf(fp, "  \"parse_source_ms\": %.3f,\n", pProf->nsParseSrc / FLYDOC_NS_PER_MS);
+  fprintf(fp, "  \"parse_markdown_ms\": %.3f,\n", pProf->nsParseMd / FLYDOC_NS_PER_MS);
+  fprintf(fp, "  \"write_ms\": %.3f,\n", pProf->nsPages / FLYDOC_NS_PER_MS);
+  fprintf(fp, "  \"files_read\": %u,\n", pProf->nFiles);
+  fprintf(fp, "  \"bytes_read\": %llu,\n", (unsigned long long)pProf->bytesRead);
+  fprintf(fp, "  \"pages_written\": %u,\n", pProf->nPages);
+  fprintf(fp, "  \"bytes_written\": %llu,\n", (unsigned long long)pProf->bytesWritten);
+  fprintf(fp, "  \"arena_allocs\": %zu,\n", pDoc->arena.nAllocs);
+  fprintf(fp, "  \"arena_bytes\": %zu,\n", pDoc->arena.size);
+  fprintf(fp, "  \"peak_rss_kb\": %ld,\n", MdProfPeakRssKb());
+  fprintf(fp, "  \"slowest_files\": ");
+  MdProfJsonSlow(fp, pProf->aSlowFiles);
+  fprintf(fp, ",\n  \"slowest_pages\": ");
+  MdProfJsonSlow(fp, pProf->aSlowPages);
+  fprintf(fp, "\n}\n");
+
+  return (fclose(fp) == 0) ? TRUE : FALSE;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Free the --profile counters. OK if not profiling.
+
+  @param    pDoc        main doc
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocProfFree(flyDoc_t *pDoc)
+{
+  flyDocProf_t *pProf = pDoc->pProf;
+  unsigned      i;
+
+  if(pProf)
+  {
+    for(i = 0; i < FLYDOC_PROF_SLOW; ++i)
+    {
+      FlyFreeIf(pProf->aSlowFiles[i].szPath);
+      FlyFreeIf(pProf->aSlowPages[i].szPath);
+    }
+    FlyFree(pProf);
+    pDoc->pProf = NULL;
+  }
+}
@@ -0,0 +1,481 @@
+/**************************************************************************************************
+  flydocsearch.c - Write a prebuilt search index for the HTML pages
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <ctype.h>
+#include "flydoc.h"
+#include "FlyList.h"
+#include "FlyStr.h"
+
+/*!
+  @defgroup flydoc_search   Write a prebuilt search index for the HTML pages
+
+  Each HTML page has a search box in its title bar. Searching is done in the browser with no server,
+  from an index built along with the pages. The index covers modules, classes, functions, methods,
+  markdown documents, their headings and examples.
+
+  The search box uses `search.js`, which is small: the search code and the names of the shards. The
+  index itself is split into shards, `search/xx.js`, where `xx` is the first two characters of the
+  search key (lowercase letters and digits, anything else is `_`). A shard is loaded with a
+  `<script>` tag (so it works from `file://` too) the first time a search needs it, and is a sorted
+  array of entries, so finding all keys that start with the search is a binary search:
+
+      flydocSearch.add("wr",[
+      [6,"FlyDocWriteHtml",2,"flydoc_html.html#FlyDocWriteHtml","Write the pDoc data to .html file(s)"],
+      ...
+      ]);
+
+  Each entry is `[offset, title, kind, href, brief]`. The search key is the title from offset on,
+  lowercase. A title has a key for each word in it (after a space, `_`, `-` or a lowercase to
+  uppercase change), so "html" finds FlyDocWriteHtml. Even for a very large project, a search only
+  loads the one shard it needs.
+
+  A search needs at least 2 characters to pick its shard, so a search of one character asks for
+  another character and doesn't look up anything.
+*/
+
+#define FLYDOC_SEARCH_WORDS   8     // most search keys per title
+#define FLYDOC_SEARCH_BRIEF   80    // longest brief kept in the index, in bytes
+#define FLYDOC_SEARCH_MIN     1024  // initial # of entries
+
+// kind of entry, index into flydocSearch.kinds in search.js
+typedef enum
+{
+  FLYDOC_SEARCH_MODULE,
+  FLYDOC_SEARCH_CLASS,
+  FLYDOC_SEARCH_FUNCTION,
+  FLYDOC_SEARCH_METHOD,
+  FLYDOC_SEARCH_DOCUMENT,
+  FLYDOC_SEARCH_HEADING,
+  FLYDOC_SEARCH_EXAMPLE
+} flyDocSearchKind_t;
+
+typedef struct
+{
+  const char         *szKey;      // lowercase title from offset, sort key
+  const char         *szTitle;    // e.g. "FlyDocWriteHtml" or "Building flydoc"
+  const char         *szHref;     // e.g. "flydoc_html.html#FlyDocWriteHtml"
+  const char         *szBrief;    // e.g. function brief or document title, may be NULL
+  unsigned            offset;     // szKey starts at szTitle + offset
+  unsigned            index;      // order added, so sort is stable
+  flyDocSearchKind_t  kind;
+  char                szShard[3]; // shard the entry is in, see MdSearchShard()
+} flyDocSearchEntry_t;
+
+typedef struct
+{
+  flyDocArena_t         arena;      // keys and hrefs, freed when index is written
+  flyDocSearchEntry_t  *aEntries;
+  unsigned              nEntries;
+  unsigned              maxEntries;
+} flyDocSearch_t;
+
+static const char m_szSearchJs[] =
+  "// flydoc search, see https://github.com/drewagislason/flydoc. Index shards are search/xx.js\n"
+  "var flydocSearch = {\n"
+  "  kinds: [\"module\", \"class\", \"function\", \"method\", \"document\", \"heading\", \"example\"],\n"
+  "  shards: {},\n"
+  "  query: \"\",\n"
+  "  max: 20,\n"
+  "  lower: function(s) { return s.replace(/[A-Z]+/g, function(m) { return m.toLowerCase(); }); },\n"
+  "  esc: function(s) { return s.replace(/&/g, \"&amp;\").replace(/</g, \"&lt;\").replace(/\"/g, \"&quot;\"); },\n"
+  "  key: function(e) { return this.lower(e[1].slice(e[0])); },\n"
+  "  shard: function(q) {\n"
+  "    var s = q.slice(0, 2).replace(/[^a-z0-9]/g, \"_\");\n"
+  "    return s.length < 2 ? s + \"_\" : s;\n"
+  "  },\n"
+  "  add: function(name, a) { this.shards[name] = a; this.find(this.query); },\n"
+  "  find: function(q) {\n"
+  "    var out = document.getElementById(\"flydoc-results\");\n"
+  "    var name, a, s, e, lo, hi, mid, n, html = \"\";\n"
+  "    q = this.lower(q.trim());\n"
+  "    this.query = q;\n"
+  "    if(!q.length) { out.innerHTML = \"\"; return; }\n"
+  "    if(q.length < 2) { out.innerHTML = \"<p><small>Type at least 2 characters</small></p>\"; return; }\n"
+  "    name = this.shard(q);\n"
+  "    a = this.shards[name];\n"
+  "    if(a === undefined && this.names.indexOf(\" \" + name + \" \") >= 0) {\n"
+  "      this.shards[name] = null;\n"
+  "      s = document.createElement(\"script\");\n"
+  "      s.src = \"search/\" + name + \".js\";\n"
+  "      document.head.appendChild(s);\n"
+  "      return;\n"
+  "    }\n"
+  "    if(a === null) return;\n"
+  "    a = a || [];\n"
+  "    lo = 0; hi = a.length;\n"
+  "    while(lo < hi) { mid = (lo + hi) >> 1; if(this.key(a[mid]) < q) lo = mid + 1; else hi = mid; }\n"
+  "    for(n = 0; lo < a.length && n < this.max && this.key(a[lo]).slice(0, q.length) == q; ++lo, ++n) {\n"
+  "      e = a[lo];\n"
+  "      html += \"<p><a href=\\\"\" + this.esc(e[3]) + \"\\\">\" + this.esc(e[1]) + \"</a> <small>\" +\n"
+  "              this.kinds[e[2]] + (e[4] ? \" - \" + this.esc(e[4]) : \"\") + \"</small></p>\";\n"
+  "    }\n"
+  "    out.innerHTML = html || \"<p>No matches</p>\";\n"
+  "  },\n"
+  "  go: function(ev) {\n"
+  "    var a = document.querySelector(\"#flydoc-results a\");\n"
+  "    if(ev.key == \"Enter\" && a) location.href = a.href;\n"
+  "  }\n"
+  "};\n";
+
+/*-------------------------------------------------------------------------------------------------
+  Does a word start at this position in the title? Words start after a space or punctuation, or
+  where lowercase changes to uppercase, e.g. "Write" and "Html" in "FlyDocWriteHtml".
+
+  @param    szTitle   title
+  @param    i         position in title, > 0
+  @return   TRUE if a word starts at szTitle[i]
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdSearchIsWord(const char *szTitle, size_t i)
+{
+  unsigned char c     = (unsigned char)szTitle[i];
+  unsigned char cPrev = (unsigned char)szTitle[i - 1];
+
+  if(!isalnum(c))
+    return FALSE;
+  if(strchr(" _-.:/(", cPrev))
+    return TRUE;
+  return (islower(cPrev) && isupper(c)) ? TRUE : FALSE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Get the shard name for a key, the same as flydocSearch.shard() in search.js, which works on UTF-16
+  code units: a 4-byte UTF-8 character is two of them.
+
+  @param    szShard   receives shard name, e.g. "fl" or "a_"
+  @param    szKey     search key
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdSearchShard(char szShard[3], const char *szKey)
+{
+  const unsigned char  *p = (const unsigned char *)szKey;
+  unsigned              n = 0;
+
+  while(n < 2)
+  {
+    if(*p == '\0')
+      szShard[n++] = '_';
+    else if(*p < 0x80)
+    {
+      szShard[n++] = (islower(*p) || isdigit(*p)) ? (char)*p : '_';
+      ++p;
+    }
+    else
+    {
+      szShard[n++] = '_';
+      if(*p >= 0xf0 && n < 2)
+        szShard[n++] = '_';
+      for(++p; (*p & 0xc0) == 0x80; ++p)
+        ;
+    }
+  }
+  szShard[2] = '\0';
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Add an entry to the index, one for each word in the title.
+
+  @param    pSearch   search index being built
+  @param    szTitle   persistent title, only the 1st line is used
+  @param    kind      kind of entry
+  @param    szBase    page base name, e.g. "MyModule", or NULL for "index"
+  @param    szLocal   local reference in page, e.g. "#myfunc" (see FlyDocRefNew()), or NULL
+  @param    szBrief   persistent brief description or NULL, only the 1st line is used
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdSearchAdd(flyDocSearch_t *pSearch, const char *szTitle, flyDocSearchKind_t kind,
+                        const char *szBase, const char *szLocal, const char *szBrief)
+{
+  flyDocSearchEntry_t  *aEntries;
+  flyDocSearchEntry_t  *pEntry;
+  char                  szRef[PATH_MAX];
+  const char           *szHref;
+  char                 *szKey;
+  size_t                len;
+  size_t                i;
+  size_t                j;
+  unsigned              nWords = 0;
+
+  len = FlyStrLineLen(szTitle);
+  if(len == 0)
+    return;
+
+  FlyDocRefJoin(szRef, sizeof(szRef), szBase ? szBase : "index", szLocal);
+  szHref = FlyDocArenaStrClone(&pSearch->arena, szRef);
+
+  for(i = 0; i < len && nWords < FLYDOC_SEARCH_WORDS; ++i)
+  {
+    if(i && !MdSearchIsWord(szTitle, i))
+      continue;
+    ++nWords;
+
+    // make room for more entries
+    if(pSearch->nEntries >= pSearch->maxEntries)
+    {
+      pSearch->maxEntries = pSearch->maxEntries ? pSearch->maxEntries * 2 : FLYDOC_SEARCH_MIN;
+      aEntries = FlyDocAlloc(pSearch->maxEntries * sizeof(*aEntries));
+      if(pSearch->nEntries)
+        memcpy(aEntries, pSearch->aEntries, pSearch->nEntries * sizeof(*aEntries));
+      FlyFreeIf(pSearch->aEntries);
+      pSearch->aEntries = aEntries;
+    }
+
+    // ASCII only lowercase, same as search.js
+    szKey = FlyDocArenaStrAllocN(&pSearch->arena, &szTitle[i], len - i);
+    for(j = 0; szKey[j]; ++j)
+    {
+      if(szKey[j] >= 'A' && szKey[j] <= 'Z')
+        szKey[j] = (char)(szKey[j] - 'A' + 'a');
+    }
+
+    pEntry = &pSearch->aEntries[pSearch->nEntries];
+    pEntry->szKey   = szKey;
+    pEntry->szTitle = szTitle;
+    pEntry->szHref  = szHref;
+    pEntry->szBrief = szBrief;
+    pEntry->offset  = (unsigned)i;
+    pEntry->index   = pSearch->nEntries;
+    pEntry->kind    = kind;
+    MdSearchShard(pEntry->szShard, szKey);
+    ++pSearch->nEntries;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Add examples of a section to the index.
+
+  @param    pSearch   search index being built
+  @param    pSection  section with examples
+  @param    szBase    page base name, e.g. "MyModule", or NULL for "index"
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdSearchAddExamples(flyDocSearch_t *pSearch, const flyDocSection_t *pSection, const char *szBase)
+{
+  const flyDocExample_t *pExample;
+  char                   szLocal[PATH_MAX];
+
+  for(pExample = pSection->pExampleList; pExample; pExample = pExample->pNext)
+  {
+    FlyDocStrToRef(szLocal, sizeof(szLocal), NULL, pExample->szTitle);
+    MdSearchAdd(pSearch, pExample->szTitle, FLYDOC_SEARCH_EXAMPLE, szBase, szLocal,
+                szBase ? pSection->szTitle : "Main Page");
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Add a list of modules or classes, their functions or methods and examples to the index.
+
+  @param    pSearch   search index being built
+  @param    pDoc      flydoc state with opts.split
+  @param    pModList  list of modules or classes
+  @param    fClass    TRUE if classes
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdSearchAddMods(flyDocSearch_t *pSearch, const flyDoc_t *pDoc, const flyDocModule_t *pModList,
+                            bool_t fClass)
+{
+  const flyDocModule_t  *pMod;
+  const flyDocFunc_t    *pFunc;
+  char                   szName[FLYDOC_REF_MAX];
+  unsigned               nParts;
+  unsigned               i;
+
+  for(pMod = pModList; pMod; pMod = pMod->pNext)
+  {
+    MdSearchAdd(pSearch, pMod->section.szTitle, fClass ? FLYDOC_SEARCH_CLASS : FLYDOC_SEARCH_MODULE,
+                pMod->section.szTitle, NULL, pMod->section.szSubtitle);
+
+    // with --split, link right to the page the function is on
+    nParts = FlyDocHtmlNumParts(pDoc, FlyListLen(pMod->pFuncList));
+    for(i = 0, pFunc = pMod->pFuncList; pFunc; pFunc = pFunc->pNext, ++i)
+    {
+      FlyDocHtmlPartName(szName, sizeof(szName), pMod->section.szTitle, nParts ? i / pDoc->opts.split + 1 : 0);
+      MdSearchAdd(pSearch, pFunc->szFunc, fClass ? FLYDOC_SEARCH_METHOD : FLYDOC_SEARCH_FUNCTION,
+                  szName, pFunc->szRef, pFunc->szBrief);
+    }
+    MdSearchAddExamples(pSearch, &pMod->section, pMod->section.szTitle);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Sort entries by shard, then key, then in the order added. A shard is not always a single run of
+  keys, e.g. "a b" and "a~" are in shard "a_", but "a0" is between them.
+
+  @param    pThis   ptr to flyDocSearchEntry_t
+  @param    pThat   ptr to flyDocSearchEntry_t
+  @return   <0, 0, >0 like strcmp()
+-------------------------------------------------------------------------------------------------*/
+static int MdSearchCmp(const void *pThis, const void *pThat)
+{
+  const flyDocSearchEntry_t *pEntry1 = pThis;
+  const flyDocSearchEntry_t *pEntry2 = pThat;
+  int                        ret;
+
+  ret = strcmp(pEntry1->szShard, pEntry2->szShard);
+  if(ret == 0)
+    ret = strcmp(pEntry1->szKey, pEntry2->szKey);
+  if(ret == 0)
+    ret = (pEntry1->index < pEntry2->index) ? -1 : 1;
+
+  return ret;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Append a string to the page as a JavaScript string literal.
+
+  @param    pPage     page being built
+  @param    sz        string, need not be '\0' terminated
+  @param    len       length of string
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdSearchStr(flyDocPage_t *pPage, const char *sz, size_t len)
+{
+  char      szEsc[8];
+  size_t    i;
+  size_t    iRun = 0;
+
+  FlyDocPageAppend(pPage, "\"", 1);
+  for(i = 0; i < len; ++i)
+  {
+    if(sz[i] == '"' || sz[i] == '\\' || (unsigned char)sz[i] < ' ')
+    {
+      FlyDocPageAppend(pPage, &sz[iRun], i - iRun);
+      if((unsigned char)sz[i] < ' ')
+        snprintf(szEsc, sizeof(szEsc), "\\u%04x", (unsigned)sz[i]);
+      else
+        snprintf(szEsc, sizeof(szEsc), "\\%c", sz[i]);
+      FlyDocPageStr(pPage, szEsc);
+      iRun = i + 1;
+    }
+  }
+  FlyDocPageAppend(pPage, &sz[iRun], i - iRun);
+  FlyDocPageAppend(pPage, "\"", 1);
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Append an entry to a shard.
+
+  @param    pPage     page being built
+  @param    pEntry    entry
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdSearchEntryWrite(flyDocPage_t *pPage, const flyDocSearchEntry_t *pEntry)
+{
+  size_t    len;
+
+  FlyDocPageTpl(pPage, "[%u,", pEntry->offset);
+  MdSearchStr(pPage, pEntry->szTitle, FlyStrLineLen(pEntry->szTitle));
+  FlyDocPageTpl(pPage, ",%u,", (unsigned)pEntry->kind);
+  MdSearchStr(pPage, pEntry->szHref, strlen(pEntry->szHref));
+  if(pEntry->szBrief)
+  {
+    // keep briefs short, ending on a whole UTF-8 character
+    len = FlyStrLineLen(pEntry->szBrief);
+    if(len > FLYDOC_SEARCH_BRIEF)
+    {
+      len = FLYDOC_SEARCH_BRIEF;
+      while(len && (pEntry->szBrief[len] & 0xc0) == 0x80)
+        --len;
+    }
+    FlyDocPageAppend(pPage, ",", 1);
+    MdSearchStr(pPage, pEntry->szBrief, len);
+  }
+  FlyDocPageStr(pPage, "],\n");
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Write the search index for the HTML pages: search.js, used by the search box on every page, and
+  its shards in the search/ folder. See @ref flydoc_search.
+
+  @param    pDoc    filled-in document, with opts.szOut folder already created
+  @return   TRUE if written, FALSE if couldn't create a folder or file (path in pDoc->szPath)
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocSearchWrite(flyDoc_t *pDoc)
+{
+  flyDocSearch_t          search;
+  flyDocMarkdown_t       *pMarkdown;
+  flyDocMdHdr_t          *pMdHdr;
+  flyDocSearchEntry_t    *pEntry;
+  flyDocPage_t            page;
+  flyDocPage_t            names;
+  char                    szFolder[PATH_MAX];
+  char                    szNameBase[FLYDOC_REF_MAX];
+  unsigned                nShards = 0;
+  unsigned                i;
+  bool_t                  fWorked = TRUE;
+
+  memset(&search, 0, sizeof(search));
+  memset(&page, 0, sizeof(page));
+  memset(&names, 0, sizeof(names));
+
+  // gather everything that can be searched for
+  MdSearchAddMods(&search, pDoc, pDoc->pModList, FALSE);
+  MdSearchAddMods(&search, pDoc, pDoc->pClassList, TRUE);
+  for(pMarkdown = pDoc->pMarkdownList; pMarkdown; pMarkdown = pMarkdown->pNext)
+  {
+    FlyDocMakeNameBase(szNameBase, pMarkdown->section.szTitle, sizeof(szNameBase));
+    MdSearchAdd(&search, pMarkdown->section.szTitle, FLYDOC_SEARCH_DOCUMENT, szNameBase, NULL,
+                pMarkdown->section.szSubtitle);
+    for(pMdHdr = pMarkdown->pHdrList; pMdHdr; pMdHdr = pMdHdr->pNext)
+      MdSearchAdd(&search, pMdHdr->szTitle, FLYDOC_SEARCH_HEADING, szNameBase, pMdHdr->szRef,
+                  pMarkdown->section.szTitle);
+    MdSearchAddExamples(&search, &pMarkdown->section, szNameBase);
+  }
+  if(pDoc->pMainPage)
+    MdSearchAddExamples(&search, &pDoc->pMainPage->section, NULL);
+  if(search.nEntries)
+    qsort(search.aEntries, search.nEntries, sizeof(*search.aEntries), MdSearchCmp);
+
+  // write each shard
+  FlyStrZCpy(szFolder, pDoc->opts.szOut, sizeof(szFolder));
+  FlyStrPathAppend(szFolder, "search", sizeof(szFolder));
+  if(search.nEntries && !FlyDocCreateFolder(pDoc, szFolder))
+  {
+    FlyStrZCpy(pDoc->szPath, szFolder, sizeof(pDoc->szPath));
+    fWorked = FALSE;
+  }
+  FlyDocPageStr(&names, "flydocSearch.names = \" ");
+  for(i = 0; fWorked && i < search.nEntries; ++i)
+  {
+    pEntry = &search.aEntries[i];
+    if(page.len == 0)
+      FlyDocPageTpl(&page, "flydocSearch.add(\"%s\",[\n", pEntry->szShard);
+    MdSearchEntryWrite(&page, pEntry);
+
+    // last entry in this shard
+    if(i + 1 == search.nEntries || strcmp(pEntry->szShard, pEntry[1].szShard) != 0)
+    {
+      FlyDocPageStr(&page, "]);\n");
+      FlyStrZCpy(pDoc->szPath, szFolder, sizeof(pDoc->szPath));
+      FlyStrPathAppend(pDoc->szPath, pEntry->szShard, sizeof(pDoc->szPath));
+      FlyStrZCat(pDoc->szPath, ".js", sizeof(pDoc->szPath));
+      if(!FlyDocPageWrite(pDoc, &page, pDoc->szPath))
+        fWorked = FALSE;
+      FlyDocPageTpl(&names, "%s ", pEntry->szShard);
+      ++nShards;
+    }
+  }
+  FlyDocPageStr(&names, "\";\n");
+  if(fWorked && nShards && pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
+    printf("  %s (%u file%s)\n", szFolder, nShards, (nShards == 1) ? "" : "s");
+
+  // search.js is the script and the names of the shards
+  if(fWorked)
+  {
+    FlyStrZCpy(pDoc->szPath, pDoc->opts.szOut, sizeof(pDoc->szPath));
+    FlyStrPathAppend(pDoc->szPath, "search.js", sizeof(pDoc->szPath));
+    if(pDoc->opts.verbose >= FLYDOC_VERBOSE_MORE)
+      printf("  %s\n", pDoc->szPath);
+    FlyDocPageStr(&page, m_szSearchJs);
+    FlyDocPageAppend(&page, names.szBuf, names.len);
+    fWorked = FlyDocPageWrite(pDoc, &page, pDoc->szPath);
+  }
+
+  FlyDocPageFree(&names);
+  FlyDocPageFree(&page);
+  FlyFreeIf(search.aEntries);
+  FlyDocArenaFree(&search.arena);
+
+  return fWorked;
+}
@@ -0,0 +1,225 @@
+/**************************************************************************************************
+  flydocspill.c - Keep document text in a pageable spill file when over --max-mem
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "flydoc.h"
+
+#ifndef MAP_NORESERVE
+  #define MAP_NORESERVE 0
+#endif
+
+#define FLYDOC_SPILL_RESERVE    ((size_t)1 << 36)   // 64GB of address space, shrinks if not allowed
+#define FLYDOC_SPILL_RESERVE_MIN ((size_t)1 << 30)  // 1GB, smallest worth reserving
+#define FLYDOC_SPILL_GROW       ((size_t)16 * 1024 * 1024) // file grows 16MB at a time
+#define FLYDOC_SPILL_ALIGN      16
+
+/*!
+  @defgroup flydoc_spill   Keep document text in a pageable spill file when over --max-mem
+
+  Nearly all of the memory of a parsed document is text: the notes of every module, class and
+  function, and their prototypes. Every page needs some of it, and text may come from any file
+  (e.g. @ingroup), so the whole document is kept in memory until it is written.
+
+  With `--max-mem=#`, text is allocated from the arena until there are # megabytes of it. Text
+  after that is allocated from a spill file, a temporary file in the output folder that is mapped
+  into memory. Pages of the spill file are ordinary file pages, so the OS writes them out and drops
+  them when memory is short, and reads them back when a page is written, rather than the process
+  growing past its memory limit. The text pointers are ordinary pointers, so nothing else in flydoc
+  changes.
+
+  The spill file is deleted as soon as it is created, so it is gone when flydoc exits, however it
+  exits. Markdown documents are already mapped from their own files, so they need no spill file.
+*/
+
+// the spill file, shared by all partial docs, hence the lock
+struct flyDocSpill
+{
+  pthread_mutex_t   lock;
+  int               fd;         // spill file, already unlinked
+  char             *pBase;      // reserved address range, the spill file is mapped from the start
+  size_t            reserve;    // size of reserved address range
+  size_t            mapped;     // size of spill file, all mapped
+  size_t            used;       // bytes of spill file allocated
+  size_t            nHeap;      // bytes of text allocated from the arena so far
+  size_t            maxHeap;    // --max-mem in bytes
+};
+
+/*-------------------------------------------------------------------------------------------------
+  Create the spill file, deleted at once. It goes in the output folder, which is usually on disk,
+  where /tmp may be in memory.
+
+  @param    pDoc      flydoc state with opts
+  @return   open file descriptor or -1 if failed
+-------------------------------------------------------------------------------------------------*/
+static int MdSpillFileCreate(flyDoc_t *pDoc)
+{
+  const char   *szFolder = NULL;
+  char          szPath[PATH_MAX];
+  int           fd;
+
+  if(pDoc->opts.szOut && !pDoc->opts.fNoBuild && FlyDocCreateFolder(pDoc, pDoc->opts.szOut))
+    szFolder = pDoc->opts.szOut;
+  if(szFolder == NULL)
+    szFolder = getenv("TMPDIR");
+  if(szFolder == NULL || *szFolder == '\0')
+    szFolder = "/tmp";
+
+  snprintf(szPath, sizeof(szPath), "%s%sflydoc-spill-XXXXXX", szFolder,
+           szFolder[strlen(szFolder) - 1] == '/' ? "" : "/");
+  fd = mkstemp(szPath);
+  if(fd >= 0)
+    unlink(szPath);
+
+  return fd;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Start the spill file for `--max-mem`, if opts.maxMem is set. Free with FlyDocSpillFree(). If the
+  spill file can't be made, a warning is printed and all text stays in memory.
+
+  @param    pDoc      flydoc state with opts.maxMem in megabytes
+  @return   TRUE if text over opts.maxMem will spill, FALSE if not
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocSpillInit(flyDoc_t *pDoc)
+{
+  struct flyDocSpill *pSpill;
+  void               *pBase = MAP_FAILED;
+  size_t              reserve;
+  int                 fd;
+
+  if(pDoc->opts.maxMem <= 0 || pDoc->pSpill)
+    return pDoc->pSpill ? TRUE : FALSE;
+
+  fd = MdSpillFileCreate(pDoc);
+  if(fd < 0)
+  {
+    FlyDocPrintWarning(pDoc, szWarningCreateFile, "--max-mem spill file");
+    return FALSE;
+  }
+
+  // reserve address space, but no memory, so the spill file never needs to move
+  for(reserve = FLYDOC_SPILL_RESERVE; reserve >= FLYDOC_SPILL_RESERVE_MIN; reserve /= 2)
+  {
+    pBase = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(pBase != MAP_FAILED)
+      break;
+  }
+  if(pBase == MAP_FAILED)
+  {
+    close(fd);
+    FlyDocPrintWarning(pDoc, szWarningCreateFile, "--max-mem spill file");
+    return FALSE;
+  }
+
+  pSpill = FlyAllocZ(sizeof(*pSpill));
+  FlyDocAllocCheck(pSpill);
+  pthread_mutex_init(&pSpill->lock, NULL);
+  pSpill->fd      = fd;
+  pSpill->pBase   = pBase;
+  pSpill->reserve = reserve;
+  pSpill->maxHeap = (size_t)pDoc->opts.maxMem * 1024 * 1024;
+  pDoc->pSpill    = pSpill;
+
+  return TRUE;
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Allocate from the spill file, growing it if needed. Must hold the lock.
+
+  @param    pSpill    spill file
+  @param    size      bytes to allocate
+  @return   ptr to zeroed memory, or NULL if the spill file can't grow
+-------------------------------------------------------------------------------------------------*/
+static char * MdSpillAlloc(struct flyDocSpill *pSpill, size_t size)
+{
+  char     *p;
+  size_t    grow;
+
+  size = (size + (FLYDOC_SPILL_ALIGN - 1)) & ~(size_t)(FLYDOC_SPILL_ALIGN - 1);
+  if(pSpill->used + size > pSpill->mapped)
+  {
+    grow = pSpill->used + size - pSpill->mapped;
+    grow = ((grow + FLYDOC_SPILL_GROW - 1) / FLYDOC_SPILL_GROW) * FLYDOC_SPILL_GROW;
+    if(pSpill->mapped + grow > pSpill->reserve)
+      return NULL;
+    if(ftruncate(pSpill->fd, (off_t)(pSpill->mapped + grow)) != 0)
+      return NULL;
+    p = mmap(pSpill->pBase + pSpill->mapped, grow, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             pSpill->fd, (off_t)pSpill->mapped);
+    if(p == MAP_FAILED)
+      return NULL;
+    pSpill->mapped += grow;
+  }
+
+  p = pSpill->pBase + pSpill->used;
+  pSpill->used += size;
+
+  return p;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Allocate memory for document text, such as the notes or prototype of a function. Same as
+  FlyDocArenaAlloc(), zeroed and lives as long as the arena, but with `--max-mem` text over the
+  budget goes to the spill file. Safe to call from parse threads on partial docs.
+
+  @param    pDoc      flydoc state (or partial doc) with arena and pSpill
+  @param    size      bytes to allocate, including the '\0'
+  @return   ptr to zeroed memory
+-------------------------------------------------------------------------------------------------*/
+char * FlyDocTextAlloc(flyDoc_t *pDoc, size_t size)
+{
+  struct flyDocSpill *pSpill = pDoc->pSpill;
+  char               *p = NULL;
+
+  if(pSpill)
+  {
+    pthread_mutex_lock(&pSpill->lock);
+    if(pSpill->nHeap + size > pSpill->maxHeap)
+      p = MdSpillAlloc(pSpill, size);
+    if(p == NULL)
+      pSpill->nHeap += size;
+    pthread_mutex_unlock(&pSpill->lock);
+  }
+
+  if(p == NULL)
+    p = FlyDocArenaAlloc(&pDoc->arena, size);
+
+  return p;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Get the number of bytes of text in the spill file, e.g. for stats.
+
+  @param    pDoc      flydoc state
+  @return   bytes in spill file, 0 if none
+-------------------------------------------------------------------------------------------------*/
+size_t FlyDocSpillSize(const flyDoc_t *pDoc)
+{
+  return pDoc->pSpill ? pDoc->pSpill->used : 0;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Free the spill file. All text in it is gone, so call only when done with the parsed document.
+
+  @param    pDoc      flydoc state from FlyDocSpillInit()
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocSpillFree(flyDoc_t *pDoc)
+{
+  struct flyDocSpill *pSpill = pDoc->pSpill;
+
+  if(pSpill)
+  {
+    munmap(pSpill->pBase, pSpill->reserve);
+    close(pSpill->fd);
+    pthread_mutex_destroy(&pSpill->lock);
+    FlyFree(pSpill);
+    pDoc->pSpill = NULL;
+  }
+}
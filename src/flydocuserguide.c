@@ -51,19 +51,34 @@ const char szFlyDocManual[] =
   "```\n"
   "flydoc v1.0\n"
   "\n"
-  "Usage = flydoc [-n] [-o out/] [-s] [-v] [--exts .c.js] [--local] [--markdown] [--noindex] in...\n"
+  "Usage = flydoc [-j=#] [-n] [-o out/] [-s] [-v] [--cache dir/] [--changed] [--copy=how] [--emit-db file] [--exclude pats] [--exts .c.js] [--gzip] [--load-db file] [--local] [--markdown] [--max-mem=#] [--noindex] [--nolink] [--nosearch] [--profile] [--profile-json file] [--split=#] [--watch] in...\n"
   "\n"
   "Options:\n"
+  "-j[=#]         Parse inputs and write pages using # threads. Default: 1\n"
   "-n             Parse inputs only, no output, useful to check for warnings\n"
   "-o             Output folder/\n"
   "-s             Sort modules/functions/classes/methods: -s- (off), -s (on: default)\n"
   "-v[=#]         Verbosity: -v- (none), -v=1 (some), -v=2 (more: default)\n"
+  "--cache dir/   Cache parse results of source files in dir/ for faster rebuilds\n"
+  "--changed      Only write output files whose contents have changed\n"
+  "--copy=how     Copy images with: copy (default, reflink if possible), link (hard) or symlink\n"
+  "--emit-db file Write the parsed document to file, to render later with --load-db\n"
+  "--exclude pats Skip files/folders matching comma separated patterns, e.g. \"build,*.min.js\"\n"
   "--exts         List of file exts to search. Default: \".c.c++.cc.cpp.cxx.cs.go.java.js.py.rs.swift.ts\"\n"
+  "--gzip         Also write a precompressed .gz copy of each output file, for web servers\n"
+  "--load-db file Render the parsed document from --emit-db file rather than parse inputs\n"
   "--local        Create local w3.css file rather than remote link to w3.css\n"
   "--markdown     Create a single combine markdown file rather than HTML pages\n"
+  "--max-mem=#    Keep at most # MB of document text in memory, the rest in a pageable temp file\n"
   "--noindex      Don't create index.html (mainpage). Allows for custom main page\n"
+  "--nolink       Don't link mentions of functions, modules and classes in text\n"
+  "--nosearch     Don't create the search box and search index in HTML pages\n"
+  "--profile      Print time spent in each phase, bytes read/written and slowest files/pages\n"
+  "--profile-json Same as --profile, but write the report to a file as JSON\n"
   "--slug         Create a reference id (slug) from a string\n"
+  "--split=#      Split modules/classes over pages of # functions, and main page lists every # entries\n"
   "--user-guide   Print flydoc user guide to the screen\n"
+  "--watch        Rebuild when inputs change, only reparsing changed files and rewriting changed pages\n"
   "in...          Input files and folders\n"
   "```\n"
   "\n"
@@ -122,6 +137,10 @@ const char szFlyDocManual[] =
   "\n"
   "### 1.5 - Options\n"
   "\n"
+  "The `-j` option parses input files and writes HTML pages in parallel using the given number of\n"
+  "threads, e.g. `-j=8`. The results and warnings are exactly the same as with one thread, just faster\n"
+  "on large projects.\n"
+  "\n"
   "The `-n` option allows you to see what files would be processed without processing them and issues\n"
   "any warnings found during that processing such as \"missing graphic\".\n"
   "\n"
@@ -136,18 +155,109 @@ const char szFlyDocManual[] =
   "the list of files processed. Set verbose to off with `-v-` to have no screen output except for\n"
   "warnings.\n"
   "\n"
+  "The `--cache` option saves the results of parsing each source file into the given folder. On the\n"
+  "next run, source files whose contents haven't changed are loaded from the cache rather than parsed\n"
+  "again, including any warnings. The cache folder can be deleted at any time. Markdown files are\n"
+  "always read, as their contents are the document.\n"
+  "\n"
+  "The `--changed` option builds each HTML page in memory and only writes it if it differs from the one\n"
+  "already in the output folder. The same goes for `w3.css`, `flydoc_home.png` and any copied images.\n"
+  "The `--markdown` file, which may be large, is written to a temporary file next to it, which only\n"
+  "replaces it if it differs. Unchanged files keep their modification time, so tools that sync the\n"
+  "output folder (rsync, a CDN, etc.) only see the files that really changed.\n"
+  "\n"
   "The `--combine` option instructs flydoc to combine all documentation into a single markdown file.\n"
   "This automatically turns on the `--markdown` option.\n"
   "\n"
+  "Referenced images are copied to the output folder on a few threads (more with `-j`). An image\n"
+  "that is already there with the same size and modified time is left alone, as copies keep the\n"
+  "modified time of the image. With `--copy=copy` (the default), a copy is a copy on write clone\n"
+  "(reflink) where the file system allows, e.g. Btrfs, XFS or APFS, so no data is copied at all.\n"
+  "`--copy=link` makes hard links, which are instant but need the output folder on the same file\n"
+  "system as the images (if not, the image is copied). `--copy=symlink` makes symbolic links to the\n"
+  "full path of each image, which is only useful for viewing the pages on the same machine.\n"
+  "\n"
+  "The `--exclude` option skips input files and folders that match any of a comma separated list of\n"
+  "patterns, such as `--exclude=build,third_party,node_modules,*.min.js`. A pattern without a slash\n"
+  "is matched against the file or folder name, so `build` skips every folder named build. A pattern\n"
+  "with a slash is matched against the end of the path, so `src/gen` skips `../project/src/gen/`. Excluded folders are never searched, which can\n"
+  "save a lot of time on large trees. With `-j`, folders are searched in parallel.\n"
+  "\n"
   "The `--exts` option let you change the default list of file extensions to search for. The default\n"
   "is \".c.c++.cc.cpp.cxx.cs.go.java.js.py.rs.swift.ts.\".\n"
   "\n"
-  "The `--markdown` option indicates the output shall be HTML (.html) in a folder, and not markdown\n"
-  "(.md) in a file.\n"
+  "The `--gzip` option writes a gzip compressed copy next to each output file, e.g. `index.html.gz`\n"
+  "next to `index.html`, compressed from the page in memory (the `--markdown` file is compressed from\n"
+  "disk). Web servers set up to serve precompressed files (nginx `gzip_static on`, Apache `MultiViews`,\n"
+  "many static hosts) send the `.gz` file as is, rather than compressing each page on every request. A\n"
+  "file that doesn't get smaller, like `flydoc_home.png` or a tiny file, gets no `.gz`, and isn't\n"
+  "compressed to find that out again. With `--changed`, the `.gz` of an unchanged file is only written\n"
+  "again if it is missing or older than the file.\n"
+  "\n"
+  "The `--markdown` option indicates the output shall be markdown (.md) in a file, and not HTML\n"
+  "(.html) in a folder. Markdown documents are not kept in memory while parsing: each is read again as\n"
+  "it is written, which keeps memory use low on large projects.\n"
+  "\n"
+  "The `--max-mem=#` option keeps memory use within a budget of about # megabytes, e.g. to document a\n"
+  "2 GB source tree in a container limited to 512 MB. Nearly all of a parsed document is the text of\n"
+  "its notes and prototypes, and all of it is needed until the pages are written. Text past the first\n"
+  "# MB goes into a temporary file in the output folder (or `$TMPDIR` with `-n`), which is mapped into\n"
+  "memory, so the system can write it out and drop it when memory is short, and read it back as pages\n"
+  "are written. The temporary file is deleted as it is created, so it never stays behind. Markdown\n"
+  "documents are already read this way from their own files. The output is the same with or without\n"
+  "`--max-mem`. A good value is half the memory available, e.g. `--max-mem=256`.\n"
   "\n"
   "The `--local` option is only useful for HTML output, as it creates a local copy of `w3.css` so that\n"
   "no internet access is required to load the HTML pages.\n"
   "\n"
+  "HTML pages have a search box in the title bar, which finds modules, classes, functions, methods,\n"
+  "markdown documents, their headings and examples by any word in their name, e.g. `html` finds\n"
+  "`FlyDocWriteHtml`. The search index is written with the pages, as `search.js` and a `search/`\n"
+  "folder of small index files. The browser only loads the index file a search needs, so searching is\n"
+  "instant even for very large projects, and works with no web server. A search needs at least 2\n"
+  "characters. `--nosearch` leaves out the search box and index.\n"
+  "\n"
+  "In HTML pages, a mention of any documented function, method, module or class in text becomes a\n"
+  "link to it, e.g. \"see FlyDocParseHdr() for details\" links to FlyDocParseHdr(), no hand written link\n"
+  "needed. To keep ordinary words ordinary, a plain word like `init` or `Point` is only linked if it\n"
+  "is a function followed by `(`, e.g. `init()`, while `snake_case`, `CamelCase` and names with digits\n"
+  "are always linked. Names documented in more than one place (e.g. a method of many classes), text\n"
+  "in code blocks, headings and existing links are never linked. `--nolink` turns this off.\n"
+  "\n"
+  "The `--split=#` option keeps HTML pages small, which matters most on phones. A module or class with\n"
+  "more than # functions gets a contents page, e.g. `MyClass.html`, with its text and a link to each\n"
+  "page of # functions, `MyClass-1.html`, `MyClass-2.html` and so on. Links to `MyClass.html#function`\n"
+  "still work: the contents page sends them on to the page with that function. Main page lists of\n"
+  "modules, classes, examples and documents show # entries per page, over `index.html`,\n"
+  "`index-2.html`, etc. A good value is `--split=100`.\n"
+  "\n"
+  "The `--profile` option prints where the time went after the statistics: wall and CPU time for each\n"
+  "phase (folder walk, parse, sort, write, image copy), time to read and parse input files and to\n"
+  "write output pages, bytes read and written, arena allocations, peak memory (RSS) and the slowest\n"
+  "input files and output pages. With `-j`, files and pages are timed on their own threads, so their\n"
+  "times add up to more than the phase. `--profile-json file.json` writes the same report as JSON,\n"
+  "useful for comparing runs in a script.\n"
+  "\n"
+  "The `--watch` option is for writing documentation: after building, flydoc waits for an input file\n"
+  "or folder to change, then builds again, until stopped with Ctrl-C. Source files that haven't\n"
+  "changed aren't read again, as their parse results are kept in memory, and only pages whose content\n"
+  "changed are written: a module or class page when its text or functions change, the main page when\n"
+  "a title, subtitle or example changes, and a markdown page when its file changes. Changed images\n"
+  "are copied again. Folders are watched with inotify on Linux, and checked every 250ms elsewhere.\n"
+  "\n"
+  "The `--emit-db file` option writes the whole parsed document (main page, modules, classes,\n"
+  "functions, examples, markdown documents and image references) to a single binary file. A later run\n"
+  "with `--load-db file` renders from that file rather than walking and parsing the inputs, so no\n"
+  "input files or folders are needed. This allows parsing once, for example in a CI job, then\n"
+  "rendering many times: HTML, `--markdown`, or with other output options. A db file is only read by\n"
+  "the same version of flydoc that wrote it. Parse only with `-n`:\n"
+  "\n"
+  "```\n"
+  "$ flydoc -n --emit-db project.fdb src/ docs/\n"
+  "$ flydoc --load-db project.fdb -o html/\n"
+  "$ flydoc --load-db project.fdb --markdown -o md/\n"
+  "```\n"
+  "\n"
   "## 2 - Building flydoc\n"
   "\n"
   "flydoc is a command-line program written in C. It relies on the firefly C library (flylibc).\n"
@@ -192,6 +302,27 @@ const char szFlyDocManual[] =
   "sudo cp flymake ~/bin/\n"
   "```\n"
   "\n"
+  "To time flydoc on your machine, run `make bench` from the `src/` folder. It builds `flydocgen`,\n"
+  "which generates the same synthetic tree of source, markdown and image files every time, then\n"
+  "prints the minimum and median milliseconds over 5 runs each for parsing only (`-n`), HTML and\n"
+  "`--markdown` output. Set `RUNS`, `JOBS` or `TREES` in the environment to change what is timed. See\n"
+  "`bench/bench.sh`.\n"
+  "\n"
+  "To use flydoc in-process, for example in a doc server or editor plugin, run `make libflydoc.a`\n"
+  "from the `src/` folder and link it with your program (plus `-lpthread -lz`). The library parses\n"
+  "inputs from memory and hands each output file to a callback, so there is no process to start and\n"
+  "no files to read back. `FlyDocLibWriteFunc()` renders the HTML of just one function, e.g. on hover.\n"
+  "See `src/flydoclib.c` for the API:\n"
+  "\n"
+  "```c\n"
+  "FlyDocLibInit(&doc, &opts);\n"
+  "FlyDocLibParse(&doc, \"src/foo.c\", szFooC, strlen(szFooC));\n"
+  "FlyDocLibDone(&doc);\n"
+  "FlyDocLibWriteFunc(&doc, \"FooOpen\", MyShowHover, pEditor);\n"
+  "FlyDocLibWrite(&doc, MyServeFile, pServer);\n"
+  "FlyDocLibFree(&doc);\n"
+  "```\n"
+  "\n"
   "If you are new to C, git or zsh or bash, consider the following links:\n"
   "\n"
   "Git: <https://www.atlassian.com/git>  \n"
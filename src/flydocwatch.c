@@ -0,0 +1,362 @@
+/**************************************************************************************************
+  flydocwatch.c - Watch the inputs and rebuild only what changed, see --watch
+  Copyright 2024 Drew Gislason
+  License MIT <https://mit-license.org>
+**************************************************************************************************/
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+  #include <poll.h>
+  #include <sys/inotify.h>
+#endif
+#include "flydoc.h"
+#include "FlyFile.h"
+#include "FlyStr.h"
+
+#define FLYDOC_WATCH_POLL_MS    250   // how often to check inputs if not notified by the OS
+#define FLYDOC_WATCH_SETTLE_MS  50    // wait for a burst of changes (e.g. an editor save) to end
+
+/*!
+  @defgroup flydoc_watch   Watch the inputs and rebuild only what changed, see --watch
+
+  With `--watch`, flydoc builds as usual, then waits for an input to change and builds again,
+  until stopped with Ctrl-C. The parsed document itself is rebuilt each time (an @ingroup in any
+  file can add to a module from any other file, so there is no safe way to patch it), but the
+  expensive parts are skipped using state kept from build to build:
+
+  1. Each source file's partial doc is kept in `--cache` form. If the file's modified time and size
+     are unchanged, the partial doc is loaded from memory without reading the file at all
+  2. Each page remembers a hash of everything it is made from, see FlyDocWatchPageSame(). Only
+     pages whose inputs changed are built and written. The main page only changes if a title,
+     subtitle or example changed
+  3. Referenced images are only copied if the image file changed. Pages refer to images by link, so
+     a changed image doesn't change any page
+
+  Folders are watched with inotify on Linux. Elsewhere, or if inotify runs out of watches, the
+  inputs are checked with stat() every 250ms. Either way a change is only acted on if a file's
+  modified time or size, or a folder, actually changed.
+*/
+
+// a folder walked in the last build
+typedef struct
+{
+  char             *szPath;
+  uint64_t          mtime;
+} flyDocWatchDir_t;
+
+// state kept from build to build, see pDoc->pWatch
+typedef struct flyDocWatch
+{
+  flyDocArena_t       arena;        // paths, files and page hashes, never freed
+  flyDocHash_t        fileIndex;    // flyDocWatchFile_t by path
+  flyDocHash_t        pageIndex;    // uint64_t hash of page inputs, by page name
+  flyDocWatchFile_t **apFiles;      // every file in fileIndex
+  unsigned            nFiles;
+  unsigned            maxFiles;
+  flyDocWatchDir_t   *aDirs;        // folders walked in the last build
+  unsigned            nDirs;
+  unsigned            maxDirs;
+  int                 fdNotify;     // inotify, or -1 to poll
+} flyDocWatch_t;
+
+/*-------------------------------------------------------------------------------------------------
+  Get modified time (ns) and size of a file or folder.
+
+  @param    szPath    path to file or folder
+  @param    pMtime    receives modified time, 0 if not there
+  @param    pSize     receives size, 0 if not there
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdWatchStat(const char *szPath, uint64_t *pMtime, uint64_t *pSize)
+{
+  struct stat   st;
+
+  *pMtime = 0;
+  *pSize  = 0;
+  if(stat(szPath, &st) == 0)
+  {
+#ifdef __APPLE__
+    *pMtime = (uint64_t)st.st_mtimespec.tv_sec * 1000000000ULL + (uint64_t)st.st_mtimespec.tv_nsec;
+#else
+    *pMtime = (uint64_t)st.st_mtim.tv_sec * 1000000000ULL + (uint64_t)st.st_mtim.tv_nsec;
+#endif
+    *pSize  = (uint64_t)st.st_size;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------
+  Has any input file or folder changed since the last build?
+
+  @param    pWatch    watch state
+  @return   TRUE if something changed
+-------------------------------------------------------------------------------------------------*/
+static bool_t MdWatchChanged(const flyDocWatch_t *pWatch)
+{
+  const flyDocWatchFile_t  *pFile;
+  uint64_t                  mtime;
+  uint64_t                  size;
+  unsigned                  i;
+
+  // a file or folder added, removed or renamed changes the folder
+  for(i = 0; i < pWatch->nDirs; ++i)
+  {
+    MdWatchStat(pWatch->aDirs[i].szPath, &mtime, &size);
+    if(mtime != pWatch->aDirs[i].mtime)
+      return TRUE;
+  }
+
+  for(i = 0; i < pWatch->nFiles; ++i)
+  {
+    pFile = pWatch->apFiles[i];
+    if(pFile->fStat)
+    {
+      MdWatchStat(pFile->szPath, &mtime, &size);
+      if(mtime != pFile->mtime || size != pFile->size)
+        return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+#ifdef __linux__
+/*-------------------------------------------------------------------------------------------------
+  Wait for inotify events, then for them to settle. The events themselves are discarded, as all
+  that matters is whether something changed, see MdWatchChanged().
+
+  @param    pWatch    watch state with fdNotify
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+static void MdWatchNotifyWait(flyDocWatch_t *pWatch)
+{
+  struct pollfd   pfd;
+  char            aEvents[4096];
+
+  pfd.fd      = pWatch->fdNotify;
+  pfd.events  = POLLIN;
+  pfd.revents = 0;
+  if(poll(&pfd, 1, -1) <= 0)
+    return;
+  do
+  {
+    if(read(pWatch->fdNotify, aEvents, sizeof(aEvents)) <= 0)
+      break;
+  } while(poll(&pfd, 1, FLYDOC_WATCH_SETTLE_MS) > 0);
+}
+#endif
+
+/*!------------------------------------------------------------------------------------------------
+  Start watching. Call after FlyDocInit(), before the first build. The state is kept in pDoc->pWatch
+  and lasts the life of the program.
+
+  @param    pDoc      flydoc state
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocWatchInit(flyDoc_t *pDoc)
+{
+  flyDocWatch_t  *pWatch;
+
+  pWatch = FlyDocAlloc(sizeof(*pWatch));
+  memset(pWatch, 0, sizeof(*pWatch));
+#ifdef __linux__
+  pWatch->fdNotify = inotify_init1(IN_CLOEXEC);
+#else
+  pWatch->fdNotify = -1;
+#endif
+  pDoc->pWatch = pWatch;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Find the watch state of an input or image file, adding it if new.
+
+  Only call from the main thread, and not while input files are being parsed, as the table may
+  grow. What's returned stays valid, so each parse job can be handed its own file.
+
+  @param    pDoc      flydoc state with pWatch
+  @param    szPath    path to file
+  @return   ptr to file state
+-------------------------------------------------------------------------------------------------*/
+flyDocWatchFile_t * FlyDocWatchFile(flyDoc_t *pDoc, const char *szPath)
+{
+  flyDocWatch_t      *pWatch = pDoc->pWatch;
+  flyDocWatchFile_t  *pFile;
+  flyDocWatchFile_t **apGrow;
+
+  pFile = FlyDocIndexFind(&pWatch->fileIndex, szPath);
+  if(pFile == NULL)
+  {
+    if(pWatch->nFiles >= pWatch->maxFiles)
+    {
+      pWatch->maxFiles = pWatch->maxFiles ? 2 * pWatch->maxFiles : 256;
+      apGrow = FlyDocAlloc(pWatch->maxFiles * sizeof(*apGrow));
+      if(pWatch->nFiles)
+        memcpy(apGrow, pWatch->apFiles, pWatch->nFiles * sizeof(*apGrow));
+      FlyFreeIf(pWatch->apFiles);
+      pWatch->apFiles = apGrow;
+    }
+
+    pFile = FlyDocArenaAlloc(&pWatch->arena, sizeof(*pFile));
+    pFile->szPath = FlyDocArenaStrClone(&pWatch->arena, szPath);
+    FlyDocIndexAdd(&pWatch->arena, &pWatch->fileIndex, pFile->szPath, pFile);
+    pWatch->apFiles[pWatch->nFiles++] = pFile;
+  }
+
+  return pFile;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Is the file the same as when last checked? Records its modified time and size for next time.
+
+  A file never checked before is not the same.
+
+  @param    pFile     file from FlyDocWatchFile()
+  @return   TRUE if modified time and size are unchanged
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocWatchFileSame(flyDocWatchFile_t *pFile)
+{
+  uint64_t  mtime;
+  uint64_t  size;
+  bool_t    fSame;
+
+  MdWatchStat(pFile->szPath, &mtime, &size);
+  fSame = (pFile->fStat && mtime == pFile->mtime && size == pFile->size) ? TRUE : FALSE;
+  pFile->mtime = mtime;
+  pFile->size  = size;
+  pFile->fStat = TRUE;
+
+  return fSame;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Keep a source file's partial doc, see FlyDocCacheSaveMem(). Replaces any from an earlier build.
+
+  @param    pFile       file from FlyDocWatchFile()
+  @param    hContents   hash of file contents
+  @param    pCache      partial doc in cache form, now owned by pFile
+  @param    len         length of pCache
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocWatchFileCache(flyDocWatchFile_t *pFile, uint64_t hContents, void *pCache, size_t len)
+{
+  if(pFile->pCache)
+    free(pFile->pCache);
+  pFile->hContents = hContents;
+  pFile->pCache    = pCache;
+  pFile->lenCache  = len;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Are a page's inputs the same as in the last build? Records the new hash for next time.
+
+  A page never built before is not the same. Only call from the main thread.
+
+  @param    pDoc      flydoc state with pWatch
+  @param    szName    page name, e.g. "index" or a module title
+  @param    hInputs   hash of everything the page is made from
+  @return   TRUE if page needn't be built again
+-------------------------------------------------------------------------------------------------*/
+bool_t FlyDocWatchPageSame(flyDoc_t *pDoc, const char *szName, uint64_t hInputs)
+{
+  flyDocWatch_t  *pWatch = pDoc->pWatch;
+  uint64_t       *pHash;
+  bool_t          fSame = FALSE;
+
+  pHash = FlyDocIndexFind(&pWatch->pageIndex, szName);
+  if(pHash == NULL)
+  {
+    pHash = FlyDocArenaAlloc(&pWatch->arena, sizeof(*pHash));
+    FlyDocIndexAdd(&pWatch->arena, &pWatch->pageIndex, FlyDocArenaStrClone(&pWatch->arena, szName), pHash);
+  }
+  else if(*pHash == hInputs)
+    fSame = TRUE;
+  *pHash = hInputs;
+
+  return fSame;
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Forget all page hashes, so the next build writes every page. Used when a build failed.
+
+  @param    pDoc      flydoc state with pWatch
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocWatchPagesForget(flyDoc_t *pDoc)
+{
+  memset(&pDoc->pWatch->pageIndex, 0, sizeof(pDoc->pWatch->pageIndex));
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Watch a folder walked while finding inputs. For a file or wildcard, its folder is watched.
+
+  @param    pDoc      flydoc state with pWatch
+  @param    szPath    folder, wildcard or file, e.g. "src/", "src/\*.c" or "src/file.c"
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocWatchFolder(flyDoc_t *pDoc, const char *szPath)
+{
+  flyDocWatch_t      *pWatch = pDoc->pWatch;
+  flyDocWatchDir_t   *aGrow;
+  char                szDir[PATH_MAX];
+  uint64_t            size;
+  size_t              n;
+
+  FlyStrZCpy(szDir, szPath, sizeof(szDir));
+  n = (size_t)(FlyStrPathNameOnly(szDir) - szDir);
+  if(strpbrk(&szDir[n], "*?") || FlyFileExistsFile(szDir))
+    szDir[n] = '\0';
+  if(*szDir == '\0')
+    FlyStrZCpy(szDir, "./", sizeof(szDir));
+
+  if(pWatch->nDirs >= pWatch->maxDirs)
+  {
+    pWatch->maxDirs = pWatch->maxDirs ? 2 * pWatch->maxDirs : 64;
+    aGrow = FlyDocAlloc(pWatch->maxDirs * sizeof(*aGrow));
+    if(pWatch->nDirs)
+      memcpy(aGrow, pWatch->aDirs, pWatch->nDirs * sizeof(*aGrow));
+    FlyFreeIf(pWatch->aDirs);
+    pWatch->aDirs = aGrow;
+  }
+  pWatch->aDirs[pWatch->nDirs].szPath = FlyStrClone(szDir);
+  FlyDocAllocCheck(pWatch->aDirs[pWatch->nDirs].szPath);
+  MdWatchStat(szDir, &pWatch->aDirs[pWatch->nDirs].mtime, &size);
+  ++pWatch->nDirs;
+
+  // watching the same folder again is harmless, if out of watches just poll
+#ifdef __linux__
+  if(pWatch->fdNotify >= 0 && inotify_add_watch(pWatch->fdNotify, szDir,
+     IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB) < 0)
+  {
+    close(pWatch->fdNotify);
+    pWatch->fdNotify = -1;
+  }
+#endif
+}
+
+/*!------------------------------------------------------------------------------------------------
+  Wait until an input file or folder changes. The folders are then forgotten, as the next build
+  walks the inputs again.
+
+  @param    pDoc      flydoc state with pWatch
+  @return   none
+-------------------------------------------------------------------------------------------------*/
+void FlyDocWatchWait(flyDoc_t *pDoc)
+{
+  flyDocWatch_t  *pWatch = pDoc->pWatch;
+  unsigned        i;
+
+  while(TRUE)
+  {
+#ifdef __linux__
+    if(pWatch->fdNotify >= 0)
+      MdWatchNotifyWait(pWatch);
+    else
+#endif
+      usleep(FLYDOC_WATCH_POLL_MS * 1000);
+    if(MdWatchChanged(pWatch))
+      break;
+  }
+
+  for(i = 0; i < pWatch->nDirs; ++i)
+    FlyFree(pWatch->aDirs[i].szPath);
+  pWatch->nDirs = 0;
+}